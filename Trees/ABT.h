@@ -66,6 +66,7 @@ class ABT: public BST<K, V> {
 public:
     ABT(); // O(1)
     NodeTree<K,V>* insereixAVL(const K& clau, const V& value);
+    NodeTree<K,V>* insereixAVL(const K& clau, V&& value);
 
 private:
     int balanceig(NodeTree<K, V>* n);
@@ -94,6 +95,13 @@ NodeTree<K,V>* ABT<K, V>::insereixAVL(const K& clau, const V& value) {
     return t;
 }
 
+template <class K, class V>
+NodeTree<K,V>* ABT<K, V>::insereixAVL(const K& clau, V&& value) {
+    NodeTree<K, V>* t = this->insereix(clau, std::move(value));
+    actualitzaArbre(t);
+    return t;
+}
+
 template <class K, class V>
 void ABT<K, V>::actualitzaArbre(NodeTree<K, V>*n) {
     int b = balanceig(n);
@@ -0,0 +1,438 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Order statistic tree (Arbre d'estadístics d'ordre). Defined with templates.
+ * This class is an AVL tree of keys where every node also stores the size of its subtree,
+ * so it can answer "how many keys are smaller than k" and "which is the i-th key" in O(log n).
+ * It is used as a secondary index (for example, of (playcount, artistId) pairs).
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - Insertion (insereix) and removal (esborra): O(log n) time, the tree is rebalanced with rotations.
+ * - Rank (comptaMenors, comptaMenorsOIguals), selection (seleccio) and search (conte): O(log n) time.
+ * - Range report (recorreRang): O(log n + k) time, where k is the number of keys reported.
+ * - Bulk load of sorted keys (construeixOrdenat): O(n) time.
+ * - Height and size of each node are stored, so they are O(1).
+ * - The tree uses O(n) space for n keys.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * An ArbreEstadistic has a pointer to the root node.
+ * Each node has a key (class K), its height, the number of keys of its subtree, and its left and right children.
+ * The keys are unique; to index repeated values, K can be a pair (value, identifier).
+ *
+ * ################################################
+ *
+ * ################################################
+ * METHODS
+ *
+ * CONSTRUCTORS  ##################################
+ *
+ * ArbreEstadistic : Default constructor. Initializes the tree as empty.
+ * ~ArbreEstadistic : Destructor. Recursively deletes all nodes.
+ *
+ * MODIFIERS  #####################################
+ *
+ * insereix : Inserts a key. Returns false if it already existed.
+ * esborra : Removes a key. Returns false if it did not exist.
+ * construeixOrdenat : Builds the tree at once from sorted unique keys (the tree must be empty).
+ * buida : Removes all the keys.
+ *
+ * CONSULTORS #####################################
+ *
+ * mida : Returns the number of keys.
+ * esBuit : Returns true if the tree is empty.
+ * conte : Returns true if the key is in the tree.
+ * comptaMenors : Returns the number of keys smaller than k.
+ * comptaMenorsOIguals : Returns the number of keys smaller or equal than k.
+ * seleccio : Returns the i-th smallest key (0-based).
+ *
+ * OPERATIONS #####################################
+ *
+ * recorreRang : Calls a function with every key in [minim, maxim] in increasing order.
+ * recorreDescendent : Calls a function with the keys in decreasing order until the function returns false.
+ * recorreDesDe : Calls a function with the keys greater or equal than a key in increasing order until the function returns false.
+ *
+ * ################################################
+ */
+
+#ifndef ARBREESTADISTIC_H
+#define ARBREESTADISTIC_H
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+
+template <class K>
+class ArbreEstadistic {
+public:
+    ArbreEstadistic(); // O(1)
+    ArbreEstadistic(const ArbreEstadistic<K>&) = delete;
+    ArbreEstadistic<K>& operator=(const ArbreEstadistic<K>&) = delete;
+    ~ArbreEstadistic(); // O(n)
+
+    bool insereix(const K& clau); // O(log n)
+    bool esborra(const K& clau); // O(log n)
+    void construeixOrdenat(const vector<K>& claus); // O(n)
+    void buida(); // O(n)
+
+    size_t mida() const; // O(1)
+    bool esBuit() const; // O(1)
+    bool conte(const K& clau) const; // O(log n)
+    size_t comptaMenors(const K& clau) const; // O(log n)
+    size_t comptaMenorsOIguals(const K& clau) const; // O(log n)
+    const K& seleccio(size_t i) const; // O(log n)
+
+    template <class F>
+    void recorreRang(const K& minim, const K& maxim, F f) const; // O(log n + k)
+    template <class F>
+    void recorreDescendent(F f) const; // O(k) amortitzat per les k primeres claus
+    template <class F>
+    void recorreDesDe(const K& minim, F f) const; // O(log n + k)
+
+private:
+    struct Node {
+        K clau;
+        int altura;
+        size_t mida;
+        Node* esq;
+        Node* dre;
+        Node(const K& c): clau(c), altura(1), mida(1), esq(nullptr), dre(nullptr) {}
+    };
+    Node* arrel;
+
+    static int altura(const Node* n);
+    static size_t mida(const Node* n);
+    static void actualitza(Node* n);
+    static Node* rotaDreta(Node* n);
+    static Node* rotaEsquerra(Node* n);
+    static Node* equilibra(Node* n);
+    static Node* insereixAux(Node* n, const K& clau, bool& inserit);
+    static Node* esborraAux(Node* n, const K& clau, bool& esborrat);
+    static Node* treuMinim(Node* n, Node*& minim);
+    static Node* construeixAux(const vector<K>& claus, size_t inici, size_t fi);
+    static void esborraNodes(Node* n);
+    template <class F>
+    static void recorreRangAux(const Node* n, const K& minim, const K& maxim, F& f);
+    template <class F>
+    static bool recorreDescendentAux(const Node* n, F& f);
+    template <class F>
+    static bool recorreDesDeAux(const Node* n, const K& minim, F& f);
+};
+
+/**
+ * Constructor sense paràmetres
+*/
+template <class K>
+ArbreEstadistic<K>::ArbreEstadistic(): arrel(nullptr) {}
+
+/**
+ * Destructor
+*/
+template <class K>
+ArbreEstadistic<K>::~ArbreEstadistic() {
+    esborraNodes(arrel);
+}
+
+template <class K>
+void ArbreEstadistic<K>::esborraNodes(Node* n) {
+    if (n == nullptr) return;
+    esborraNodes(n->esq);
+    esborraNodes(n->dre);
+    delete n;
+}
+
+template <class K>
+void ArbreEstadistic<K>::buida() {
+    esborraNodes(arrel);
+    arrel = nullptr;
+}
+
+/**
+ * Consultors de l'altura i la mida d'un subarbre (0 si és buit)
+*/
+template <class K>
+int ArbreEstadistic<K>::altura(const Node* n) {
+    return (n == nullptr) ? 0 : n->altura;
+}
+
+template <class K>
+size_t ArbreEstadistic<K>::mida(const Node* n) {
+    return (n == nullptr) ? 0 : n->mida;
+}
+
+template <class K>
+void ArbreEstadistic<K>::actualitza(Node* n) {
+    n->altura = 1 + max(altura(n->esq), altura(n->dre));
+    n->mida = 1 + mida(n->esq) + mida(n->dre);
+}
+
+/**
+ * Rotacions per mantenir l'equilibri AVL
+ * @return Node nova arrel del subarbre
+*/
+template <class K>
+typename ArbreEstadistic<K>::Node* ArbreEstadistic<K>::rotaDreta(Node* n) {
+    Node* t = n->esq;
+    n->esq = t->dre;
+    t->dre = n;
+    actualitza(n);
+    actualitza(t);
+    return t;
+}
+
+template <class K>
+typename ArbreEstadistic<K>::Node* ArbreEstadistic<K>::rotaEsquerra(Node* n) {
+    Node* t = n->dre;
+    n->dre = t->esq;
+    t->esq = n;
+    actualitza(n);
+    actualitza(t);
+    return t;
+}
+
+template <class K>
+typename ArbreEstadistic<K>::Node* ArbreEstadistic<K>::equilibra(Node* n) {
+    actualitza(n);
+    int b = altura(n->esq) - altura(n->dre);
+    if (b > 1) {
+        if (altura(n->esq->esq) < altura(n->esq->dre)) n->esq = rotaEsquerra(n->esq);
+        return rotaDreta(n);
+    }
+    if (b < -1) {
+        if (altura(n->dre->dre) < altura(n->dre->esq)) n->dre = rotaDreta(n->dre);
+        return rotaEsquerra(n);
+    }
+    return n;
+}
+
+/**
+ * Insereix una clau a l'arbre
+ * @return bool false si la clau ja hi era
+*/
+template <class K>
+bool ArbreEstadistic<K>::insereix(const K& clau) {
+    bool inserit = false;
+    arrel = insereixAux(arrel, clau, inserit);
+    return inserit;
+}
+
+template <class K>
+typename ArbreEstadistic<K>::Node* ArbreEstadistic<K>::insereixAux(Node* n, const K& clau, bool& inserit) {
+    if (n == nullptr) {
+        inserit = true;
+        return new Node(clau);
+    }
+    if (clau < n->clau) n->esq = insereixAux(n->esq, clau, inserit);
+    else if (n->clau < clau) n->dre = insereixAux(n->dre, clau, inserit);
+    else return n;
+    return equilibra(n);
+}
+
+/**
+ * Esborra una clau de l'arbre
+ * @return bool false si la clau no hi era
+*/
+template <class K>
+bool ArbreEstadistic<K>::esborra(const K& clau) {
+    bool esborrat = false;
+    arrel = esborraAux(arrel, clau, esborrat);
+    return esborrat;
+}
+
+template <class K>
+typename ArbreEstadistic<K>::Node* ArbreEstadistic<K>::esborraAux(Node* n, const K& clau, bool& esborrat) {
+    if (n == nullptr) return nullptr;
+    if (clau < n->clau) n->esq = esborraAux(n->esq, clau, esborrat);
+    else if (n->clau < clau) n->dre = esborraAux(n->dre, clau, esborrat);
+    else {
+        esborrat = true;
+        Node* esq = n->esq;
+        Node* dre = n->dre;
+        delete n;
+        if (dre == nullptr) return esq;
+        Node* minim = nullptr;
+        dre = treuMinim(dre, minim);
+        minim->esq = esq;
+        minim->dre = dre;
+        return equilibra(minim);
+    }
+    return equilibra(n);
+}
+
+/**
+ * Treu el node més petit d'un subarbre sense esborrar-lo
+ * @return Node nova arrel del subarbre
+*/
+template <class K>
+typename ArbreEstadistic<K>::Node* ArbreEstadistic<K>::treuMinim(Node* n, Node*& minim) {
+    if (n->esq == nullptr) {
+        minim = n;
+        return n->dre;
+    }
+    n->esq = treuMinim(n->esq, minim);
+    return equilibra(n);
+}
+
+/**
+ * Construeix l'arbre de cop a partir de claus ordenades i sense repetir. L'arbre ha de ser buit.
+*/
+template <class K>
+void ArbreEstadistic<K>::construeixOrdenat(const vector<K>& claus) {
+    if (arrel != nullptr) throw logic_error("L'índex no és buit\n");
+    arrel = construeixAux(claus, 0, claus.size());
+}
+
+template <class K>
+typename ArbreEstadistic<K>::Node* ArbreEstadistic<K>::construeixAux(const vector<K>& claus, size_t inici, size_t fi) {
+    if (inici >= fi) return nullptr;
+    size_t mig = inici + (fi - inici) / 2;
+    Node* n = new Node(claus[mig]);
+    n->esq = construeixAux(claus, inici, mig);
+    n->dre = construeixAux(claus, mig + 1, fi);
+    actualitza(n);
+    return n;
+}
+
+template <class K>
+size_t ArbreEstadistic<K>::mida() const {
+    return mida(arrel);
+}
+
+template <class K>
+bool ArbreEstadistic<K>::esBuit() const {
+    return arrel == nullptr;
+}
+
+/**
+ * Mètode que comprova si la clau és a l'arbre
+ * @return bool si hi és
+*/
+template <class K>
+bool ArbreEstadistic<K>::conte(const K& clau) const {
+    const Node* n = arrel;
+    while (n != nullptr) {
+        if (clau < n->clau) n = n->esq;
+        else if (n->clau < clau) n = n->dre;
+        else return true;
+    }
+    return false;
+}
+
+/**
+ * Compta les claus estrictament més petites que la clau entrada
+ * @return size_t nombre de claus
+*/
+template <class K>
+size_t ArbreEstadistic<K>::comptaMenors(const K& clau) const {
+    size_t compte = 0;
+    const Node* n = arrel;
+    while (n != nullptr) {
+        if (n->clau < clau) {
+            compte += mida(n->esq) + 1;
+            n = n->dre;
+        }
+        else n = n->esq;
+    }
+    return compte;
+}
+
+/**
+ * Compta les claus més petites o iguals que la clau entrada
+ * @return size_t nombre de claus
+*/
+template <class K>
+size_t ArbreEstadistic<K>::comptaMenorsOIguals(const K& clau) const {
+    size_t compte = 0;
+    const Node* n = arrel;
+    while (n != nullptr) {
+        if (clau < n->clau) n = n->esq;
+        else {
+            compte += mida(n->esq) + 1;
+            n = n->dre;
+        }
+    }
+    return compte;
+}
+
+/**
+ * Retorna la i-èsima clau més petita (començant per 0)
+ * @return K& clau en la posició i
+*/
+template <class K>
+const K& ArbreEstadistic<K>::seleccio(size_t i) const {
+    if (i >= mida()) throw out_of_range("Posició fora de l'índex\n");
+    const Node* n = arrel;
+    while (true) {
+        size_t m = mida(n->esq);
+        if (i < m) n = n->esq;
+        else if (i == m) return n->clau;
+        else {
+            i -= m + 1;
+            n = n->dre;
+        }
+    }
+}
+
+/**
+ * Recorre en ordre creixent les claus de l'interval [minim, maxim] i crida a f(clau)
+*/
+template <class K>
+template <class F>
+void ArbreEstadistic<K>::recorreRang(const K& minim, const K& maxim, F f) const {
+    recorreRangAux(arrel, minim, maxim, f);
+}
+
+template <class K>
+template <class F>
+void ArbreEstadistic<K>::recorreRangAux(const Node* n, const K& minim, const K& maxim, F& f) {
+    if (n == nullptr) return;
+    if (minim < n->clau) recorreRangAux(n->esq, minim, maxim, f);
+    if (!(n->clau < minim) && !(maxim < n->clau)) f(n->clau);
+    if (n->clau < maxim) recorreRangAux(n->dre, minim, maxim, f);
+}
+
+/**
+ * Recorre les claus en ordre decreixent i crida a f(clau) fins que f retorna false
+*/
+template <class K>
+template <class F>
+void ArbreEstadistic<K>::recorreDescendent(F f) const {
+    recorreDescendentAux(arrel, f);
+}
+
+template <class K>
+template <class F>
+bool ArbreEstadistic<K>::recorreDescendentAux(const Node* n, F& f) {
+    if (n == nullptr) return true;
+    if (!recorreDescendentAux(n->dre, f)) return false;
+    if (!f(n->clau)) return false;
+    return recorreDescendentAux(n->esq, f);
+}
+
+/**
+ * Recorre en ordre creixent les claus més grans o iguals que minim i crida a f(clau) fins que f retorna false
+*/
+template <class K>
+template <class F>
+void ArbreEstadistic<K>::recorreDesDe(const K& minim, F f) const {
+    recorreDesDeAux(arrel, minim, f);
+}
+
+template <class K>
+template <class F>
+bool ArbreEstadistic<K>::recorreDesDeAux(const Node* n, const K& minim, F& f) {
+    if (n == nullptr) return true;
+    if (n->clau < minim) return recorreDesDeAux(n->dre, minim, f);
+    if (!recorreDesDeAux(n->esq, minim, f)) return false;
+    if (!f(n->clau)) return false;
+    return recorreDesDeAux(n->dre, minim, f);
+}
+
+#endif /* ARBREESTADISTIC_H */
@@ -0,0 +1,283 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Two-dimensional k-d tree (Arbre k-d) of (x, y) points with unique x, for example (artistId, playcount).
+ * The tree is built at once (construeix): the points are split by the median of the coordinate with
+ * the widest extent, recursively, until a node has at most FULLA points. The nodes are stored
+ * implicitly in an array (the children of node i are 2i + 1 and 2i + 2) and the points of every
+ * subtree are contiguous, so the tree has no pointers. Every node keeps the bounding box of its points
+ * and the number of live points: a subtree whose box is inside the query rectangle is counted in O(1)
+ * and a subtree whose box is outside is skipped.
+ * Changes do not rebuild the tree: a changed point is marked as removed in the tree (the live counts
+ * of its ancestors are decremented) and its new coordinates, like the added points, go to a small list
+ * of pending points that every query scans. When the pending points are more than max(MIN_PENDENTS,
+ * n / 32) the tree is rebuilt with all the live points.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - construeix: O(n log n) time (one nth_element per level).
+ * - compta: O(sqrt(n) + p) time, where p is the number of pending points.
+ * - recorre: O(sqrt(n) + p + k) time, where k is the number of points reported.
+ * - afegeix: O(1) amortized plus the rebuilds, O(log n) amortized.
+ * - canvia: O(sqrt(n)) to find the point in the tree (usually O(log n)), plus the rebuilds.
+ * - O(n) space: 8 bytes per point and 20 bytes per node (one node per FULLA / 2 points at least).
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * punts : Points of the tree, the ones of every subtree contiguous.
+ * nodes : Bounding box and number of live points of every node.
+ * esborrat : 1 for the points of the tree that have been changed (their current coordinates are pending).
+ * pendentsAfegits, posicionsPendents : Points added or changed since the last build, and the position of each x.
+ *
+ * ################################################
+ */
+
+#ifndef ARBREKD_H
+#define ARBREKD_H
+#include "../Hash_Tables/HashTable.h"
+#include <vector>
+#include <cstdint>
+#include <climits>
+#include <algorithm>
+
+using namespace std;
+
+struct PuntKD {
+    int x;
+    int y;
+};
+
+class ArbreKD {
+public:
+    static constexpr size_t FULLA = 16;
+    static constexpr size_t MIN_PENDENTS = 1024;
+
+    ArbreKD();
+
+    void construeix(vector<PuntKD> punts);
+    void afegeix(int x, int y);
+    void canvia(int x, int anterior, int nou);
+
+    size_t compta(int xMinim, int xMaxim, int yMinim, int yMaxim) const;
+    template <class F>
+    void recorre(int xMinim, int xMaxim, int yMinim, int yMaxim, F f) const;
+
+    size_t mida() const;
+    size_t pendents() const;
+    size_t memoria() const;
+
+private:
+    struct Node {
+        int xMinim, xMaxim, yMinim, yMaxim;
+        uint32_t vius;
+    };
+
+    vector<PuntKD> punts;
+    vector<Node> nodes;
+    vector<uint8_t> esborrat;
+    vector<PuntKD> pendentsAfegits;
+    HashTable<int, uint32_t> posicionsPendents;
+
+    void construeixNode(size_t node, size_t inici, size_t fi);
+    bool esborra(size_t node, size_t inici, size_t fi, int x, int y);
+    void reconstrueix();
+    size_t comptaNode(size_t node, size_t inici, size_t fi, const Node& q) const;
+    template <class F>
+    void recorreNode(size_t node, size_t inici, size_t fi, const Node& q, F& f) const;
+
+    static bool dins(int x, int y, const Node& q);
+};
+
+/**
+ * Constructor sense paràmetres. L'arbre és buit
+*/
+ArbreKD::ArbreKD(): posicionsPendents(64) {}
+
+/**
+ * Construeix l'arbre amb els punts entrats (les x han de ser diferents) i buida els pendents
+*/
+void ArbreKD::construeix(vector<PuntKD> nous) {
+    punts = std::move(nous);
+    pendentsAfegits.clear();
+    posicionsPendents.clear();
+    esborrat.assign(punts.size(), 0);
+    nodes.clear();
+    if (punts.empty()) return;
+    size_t fulles = 1;
+    while (punts.size() > FULLA * fulles) fulles *= 2;
+    nodes.resize(2 * fulles - 1);
+    construeixNode(0, 0, punts.size());
+}
+
+/**
+ * Calcula la caixa dels punts [inici, fi) i els parteix per la mediana de la coordenada més ampla
+*/
+void ArbreKD::construeixNode(size_t node, size_t inici, size_t fi) {
+    Node& n = nodes[node];
+    n.xMinim = n.yMinim = INT_MAX;
+    n.xMaxim = n.yMaxim = INT_MIN;
+    for (size_t i = inici; i < fi; i++) {
+        n.xMinim = min(n.xMinim, punts[i].x);
+        n.xMaxim = max(n.xMaxim, punts[i].x);
+        n.yMinim = min(n.yMinim, punts[i].y);
+        n.yMaxim = max(n.yMaxim, punts[i].y);
+    }
+    n.vius = static_cast<uint32_t>(fi - inici);
+    if (fi - inici <= FULLA) return;
+
+    size_t mig = inici + (fi - inici) / 2;
+    if (static_cast<long long>(n.xMaxim) - n.xMinim >= static_cast<long long>(n.yMaxim) - n.yMinim) {
+        nth_element(punts.begin() + inici, punts.begin() + mig, punts.begin() + fi,
+            [](const PuntKD& a, const PuntKD& b) { return a.x < b.x; });
+    } else {
+        nth_element(punts.begin() + inici, punts.begin() + mig, punts.begin() + fi,
+            [](const PuntKD& a, const PuntKD& b) { return a.y < b.y; });
+    }
+    construeixNode(2 * node + 1, inici, mig);
+    construeixNode(2 * node + 2, mig, fi);
+}
+
+/**
+ * Afegeix un punt nou (la x no pot ser a l'arbre) a la llista de pendents
+*/
+void ArbreKD::afegeix(int x, int y) {
+    if (posicionsPendents.contains(x)) {
+        pendentsAfegits[posicionsPendents.get(x)].y = y;
+        return;
+    }
+    posicionsPendents.insert(x, static_cast<uint32_t>(pendentsAfegits.size()));
+    pendentsAfegits.push_back(PuntKD{x, y});
+    if (pendentsAfegits.size() > max(MIN_PENDENTS, punts.size() / 32)) reconstrueix();
+}
+
+/**
+ * Canvia la y del punt (x, anterior) a nou. Si el punt és a l'arbre s'hi marca com a esborrat
+*/
+void ArbreKD::canvia(int x, int anterior, int nou) {
+    if (!posicionsPendents.contains(x) && !nodes.empty()) esborra(0, 0, punts.size(), x, anterior);
+    afegeix(x, nou);
+}
+
+/**
+ * Busca el punt (x, y) viu dins del subarbre, el marca com a esborrat i resta un viu als nodes del camí
+ * @return bool si l'ha trobat
+*/
+bool ArbreKD::esborra(size_t node, size_t inici, size_t fi, int x, int y) {
+    Node& n = nodes[node];
+    if (n.vius == 0 || !dins(x, y, n)) return false;
+    bool trobat = false;
+    if (fi - inici <= FULLA) {
+        for (size_t i = inici; i < fi && !trobat; i++) {
+            if (punts[i].x == x && punts[i].y == y && !esborrat[i]) {
+                esborrat[i] = 1;
+                trobat = true;
+            }
+        }
+    } else {
+        size_t mig = inici + (fi - inici) / 2;
+        trobat = esborra(2 * node + 1, inici, mig, x, y) || esborra(2 * node + 2, mig, fi, x, y);
+    }
+    if (trobat) n.vius--;
+    return trobat;
+}
+
+/**
+ * Torna a construir l'arbre amb els punts vius i els pendents
+*/
+void ArbreKD::reconstrueix() {
+    vector<PuntKD> tots;
+    tots.reserve(mida());
+    for (size_t i = 0; i < punts.size(); i++) {
+        if (!esborrat[i]) tots.push_back(punts[i]);
+    }
+    tots.insert(tots.end(), pendentsAfegits.begin(), pendentsAfegits.end());
+    construeix(std::move(tots));
+}
+
+/**
+ * Compta els punts amb x dins de [xMinim, xMaxim] i y dins de [yMinim, yMaxim]
+ * @return size_t nombre de punts
+*/
+size_t ArbreKD::compta(int xMinim, int xMaxim, int yMinim, int yMaxim) const {
+    if (xMaxim < xMinim || yMaxim < yMinim) return 0;
+    Node q = {xMinim, xMaxim, yMinim, yMaxim, 0};
+    size_t total = nodes.empty() ? 0 : comptaNode(0, 0, punts.size(), q);
+    for (const PuntKD& p : pendentsAfegits) total += dins(p.x, p.y, q);
+    return total;
+}
+
+size_t ArbreKD::comptaNode(size_t node, size_t inici, size_t fi, const Node& q) const {
+    const Node& n = nodes[node];
+    if (n.vius == 0 || n.xMaxim < q.xMinim || n.xMinim > q.xMaxim || n.yMaxim < q.yMinim || n.yMinim > q.yMaxim) return 0;
+    if (n.xMinim >= q.xMinim && n.xMaxim <= q.xMaxim && n.yMinim >= q.yMinim && n.yMaxim <= q.yMaxim) return n.vius;
+    if (fi - inici <= FULLA) {
+        size_t total = 0;
+        for (size_t i = inici; i < fi; i++) total += !esborrat[i] && dins(punts[i].x, punts[i].y, q);
+        return total;
+    }
+    size_t mig = inici + (fi - inici) / 2;
+    return comptaNode(2 * node + 1, inici, mig, q) + comptaNode(2 * node + 2, mig, fi, q);
+}
+
+/**
+ * Crida a f(x, y) amb cada punt dins del rectangle, sense cap ordre
+*/
+template <class F>
+void ArbreKD::recorre(int xMinim, int xMaxim, int yMinim, int yMaxim, F f) const {
+    if (xMaxim < xMinim || yMaxim < yMinim) return;
+    Node q = {xMinim, xMaxim, yMinim, yMaxim, 0};
+    if (!nodes.empty()) recorreNode(0, 0, punts.size(), q, f);
+    for (const PuntKD& p : pendentsAfegits) {
+        if (dins(p.x, p.y, q)) f(p.x, p.y);
+    }
+}
+
+template <class F>
+void ArbreKD::recorreNode(size_t node, size_t inici, size_t fi, const Node& q, F& f) const {
+    const Node& n = nodes[node];
+    if (n.vius == 0 || n.xMaxim < q.xMinim || n.xMinim > q.xMaxim || n.yMaxim < q.yMinim || n.yMinim > q.yMaxim) return;
+    bool tot = n.xMinim >= q.xMinim && n.xMaxim <= q.xMaxim && n.yMinim >= q.yMinim && n.yMaxim <= q.yMaxim;
+    if (tot || fi - inici <= FULLA) {
+        // Dins del rectangle només cal mirar els esborrats, i si no n'hi ha cap ni això
+        bool senseEsborrats = n.vius == fi - inici;
+        for (size_t i = inici; i < fi; i++) {
+            if ((senseEsborrats || !esborrat[i]) && (tot || dins(punts[i].x, punts[i].y, q))) f(punts[i].x, punts[i].y);
+        }
+        return;
+    }
+    size_t mig = inici + (fi - inici) / 2;
+    recorreNode(2 * node + 1, inici, mig, q, f);
+    recorreNode(2 * node + 2, mig, fi, q, f);
+}
+
+bool ArbreKD::dins(int x, int y, const Node& q) {
+    return x >= q.xMinim && x <= q.xMaxim && y >= q.yMinim && y <= q.yMaxim;
+}
+
+/**
+ * Nombre de punts vius (de l'arbre i pendents)
+ * @return size_t nombre de punts
+*/
+size_t ArbreKD::mida() const {
+    return (nodes.empty() ? 0 : nodes[0].vius) + pendentsAfegits.size();
+}
+
+size_t ArbreKD::pendents() const {
+    return pendentsAfegits.size();
+}
+
+/**
+ * Bytes aproximats que fa servir l'arbre
+ * @return size_t bytes
+*/
+size_t ArbreKD::memoria() const {
+    return punts.capacity() * sizeof(PuntKD) + nodes.capacity() * sizeof(Node) + esborrat.capacity()
+         + pendentsAfegits.capacity() * sizeof(PuntKD) + posicionsPendents.size() * (sizeof(int) + sizeof(uint32_t) + 2 * sizeof(void*));
+}
+
+#endif /* ARBREKD_H */
@@ -1,10 +1,21 @@
 /**
  * @author Albert Villanueva Kosoy Grup C
+ *
+ * El gènere, el país i els estils es guarden com a codis de diccionari (Diccionari.h):
+ * cada text diferent es guarda un sol cop i cada artista només guarda el seu codi.
+ * Els consultors continuen retornant el text. Els consultors ...View retornen una vista del text
+ * guardat (al node o al diccionari) i formatTo afegeix l'artista al final d'un string, sense
+ * cap string temporal: són els que s'han de fer servir als recorreguts i a les respostes.
 */
 
 #ifndef ARTIST_H
 #define ARTIST_H
 #include <iostream>
+#include <string_view>
+#include <charconv>
+#include <cstdint>
+#include <stdexcept>
+#include "Diccionari.h"
 
 using namespace std;
 
@@ -12,19 +23,33 @@ class Artist{
     private:
         int artistId;
         string name;
-        string gender;
-        string country;
-        string styles;
+        uint16_t gender;
+        uint16_t country;
+        uint32_t styles;
         int playcount;
+
+        static uint16_t codi16(Diccionari& d, string_view text);
     public:
         Artist();
         Artist (int artistId, string &name, string& gender, string& country, string& styles, int placount);
+        Artist (int artistId, string_view name, string_view gender, string_view country, string_view styles, int playcount);
         int getArtistId()const;
         string getName()const;
         string getGender()const;
         string getCountry()const;
         string getStyles()const;
         int getPlaycount()const;
+        uint16_t getGenderCode()const;
+        uint16_t getCountryCode()const;
+        uint32_t getStylesCode()const;
+        string_view nameView()const;
+        string_view genderView()const;
+        string_view countryView()const;
+        string_view stylesView()const;
+
+        static Diccionari& generes();
+        static Diccionari& paisos();
+        static Diccionari& estils();
 
         void setArtistId(int artistId);
         void setName(string name);
@@ -35,17 +60,57 @@ class Artist{
         
         void print();
         string toString()const;
+        size_t midaFormat()const;
+        void formatTo(string& sortida)const;
+        void formatAmbIdTo(string& sortida)const;
+        static void afegeixEnter(string& sortida, long long valor);
 };
 /**
  * Constructor sense paràmetres de la classe Artist
 */
-Artist::Artist(){}
+Artist::Artist(): artistId(0), gender(0), country(0), styles(0), playcount(0){}
 
 /**
  * Constructor amb paràmetres de la classe Artist
 */
 Artist::Artist (int artistId, string &name, string &gender, string &country, string &styles, int playcount)
-        : artistId(artistId), name(name), gender(gender), country(country), styles(styles), playcount(playcount){}
+        : artistId(artistId), name(name), gender(codi16(generes(), gender)), country(codi16(paisos(), country)),
+          styles(estils().codi(styles)), playcount(playcount){}
+
+/**
+ * Constructor amb paràmetres de la classe Artist a partir de vistes de text (sense strings temporals)
+*/
+Artist::Artist (int artistId, string_view name, string_view gender, string_view country, string_view styles, int playcount)
+        : artistId(artistId), name(name), gender(codi16(generes(), gender)), country(codi16(paisos(), country)),
+          styles(estils().codi(styles)), playcount(playcount){}
+
+/**
+ * Diccionaris compartits per tots els artistes
+*/
+Diccionari& Artist::generes(){
+    static Diccionari d;
+    return d;
+}
+
+Diccionari& Artist::paisos(){
+    static Diccionari d;
+    return d;
+}
+
+Diccionari& Artist::estils(){
+    static Diccionari d;
+    return d;
+}
+
+/**
+ * Codi d'un text en un diccionari que ha de cabre en 16 bits
+ * @return uint16_t codi del text
+*/
+uint16_t Artist::codi16(Diccionari& d, string_view text){
+    uint32_t c = d.codi(text);
+    if (c > UINT16_MAX) throw length_error("Massa valors diferents per guardar-los en 16 bits\n");
+    return static_cast<uint16_t>(c);
+}
 
 
 /**
@@ -62,38 +127,73 @@ string Artist::getName()const{
     return name;
 }
 
+/**
+ * Vistes del nom, el gènere, el país i els estils. Són vàlides mentre l'artista no es modifiqui
+ * (el nom) o sempre (els textos del diccionari no es mouen)
+*/
+string_view Artist::nameView()const{
+    return name;
+}
+
+string_view Artist::genderView()const{
+    return generes().text(gender);
+}
+
+string_view Artist::countryView()const{
+    return paisos().text(country);
+}
+
+string_view Artist::stylesView()const{
+    return estils().text(styles);
+}
+
 void Artist::setName(string name){
     this->name = name;
 }
 
 string Artist::getGender()const{
-    return gender;
+    return generes().text(gender);
 }
 
 void Artist::setGender(string gender){
-    this->gender = gender;
+    this->gender = codi16(generes(), gender);
 }
 
 string Artist::getCountry()const{
-    return country;
+    return paisos().text(country);
 }
 
 void Artist::setCountry(string country){
-    this->country = country;
+    this->country = codi16(paisos(), country);
 }
 
 string Artist::getStyles()const{
-    return styles;
+    return estils().text(styles);
 }
 
 void Artist::setStyles(string styles){
-    this->styles = styles;
+    this->styles = estils().codi(styles);
 }
 
 int Artist::getPlaycount()const{
     return playcount;
 }
 
+/**
+ * Codis de diccionari del gènere, el país i els estils. Dos artistes tenen el mateix text si tenen el mateix codi
+*/
+uint16_t Artist::getGenderCode()const{
+    return gender;
+}
+
+uint16_t Artist::getCountryCode()const{
+    return country;
+}
+
+uint32_t Artist::getStylesCode()const{
+    return styles;
+}
+
 void Artist::setPlaycount(int playcount){
     this->playcount = playcount;
 }
@@ -103,15 +203,58 @@ void Artist::setPlaycount(int playcount){
  * @return string info dels artistes
 */
 string Artist::toString()const{
-            string missatge = getName() + "::" + getGender() + "::" + getCountry() + "::" + getStyles() + "::" + to_string(getPlaycount());
-            return missatge;
-        }
+    string missatge;
+    missatge.reserve(midaFormat());
+    formatTo(missatge);
+    return missatge;
+}
+
+/**
+ * Mida màxima del text de formatTo
+ * @return size_t caràcters
+*/
+size_t Artist::midaFormat()const{
+    return name.size() + genderView().size() + countryView().size() + stylesView().size() + 4 * 2 + 11;
+}
+
+/**
+ * Afegeix nom::gènere::país::estils::playcount al final de sortida (el mateix text que toString)
+*/
+void Artist::formatTo(string& sortida)const{
+    sortida.append(name);
+    sortida.append("::", 2);
+    sortida.append(genderView());
+    sortida.append("::", 2);
+    sortida.append(countryView());
+    sortida.append("::", 2);
+    sortida.append(stylesView());
+    sortida.append("::", 2);
+    afegeixEnter(sortida, playcount);
+}
+
+/**
+ * Afegeix id::nom::gènere::país::estils::playcount al final de sortida
+*/
+void Artist::formatAmbIdTo(string& sortida)const{
+    afegeixEnter(sortida, artistId);
+    sortida.append("::", 2);
+    formatTo(sortida);
+}
+
+/**
+ * Afegeix un enter en decimal al final de sortida sense crear cap string
+*/
+void Artist::afegeixEnter(string& sortida, long long valor){
+    char xifres[24];
+    char* fi = to_chars(xifres, xifres + sizeof(xifres), valor).ptr;
+    sortida.append(xifres, fi);
+}
 
 /**
  * Imprimeix la informació d'un artista per pantalla
 */
 void Artist::print(){
-    cout << "(Id :: " << artistId << ",  nom :: " << name << ", gènere :: " << gender << ", país :: " << country <<
-    ", estil :: " << styles << ", playcount :: " << playcount << ")\n";
+    cout << "(Id :: " << artistId << ",  nom :: " << name << ", gènere :: " << getGender() << ", país :: " << getCountry() <<
+    ", estil :: " << getStyles() << ", playcount :: " << playcount << ")\n";
 }
 #endif
\ No newline at end of file
@@ -40,6 +40,7 @@
  * MODIFIERS  #####################################
  * 
  * insereix : Inserts a key and value into the BST.
+ * construeixOrdenat : Builds a balanced tree at once from keys already sorted (bulk load of an empty tree).
  * arbreMirall : Converts the tree into its mirror.
  * 
  * CONSULTORS #####################################
@@ -59,6 +60,9 @@
 #include "NodeTree.h"
 #include <iostream>
 #include <list>
+#include <vector>
+#include <utility>
+#include <stdexcept>
 using namespace std;
 
 template <class CLAU, class VALOR>
@@ -70,6 +74,8 @@ class BST {
     bool buida() const; // O(1)
     int altura() const; 
     NodeTree<CLAU,VALOR>* insereix(const CLAU& clau, const VALOR& value); // O(log 2 n), crida a cercar
+    NodeTree<CLAU,VALOR>* insereix(const CLAU& clau, VALOR&& value); // O(log 2 n), mou el valor dins del node
+    void construeixOrdenat(vector<pair<CLAU, VALOR>>& elements); // O(n), arbre buit i claus ordenades
     const VALOR& valorDe(const CLAU& clau) const; // O(log 2 n) també crida a la funcio cercar
     void imprimeixPreordre(const NodeTree<CLAU,VALOR>* n = nullptr) const; // O(n), ha d'imprimir tot l'arbre
     void imprimeixInordre(const NodeTree<CLAU,VALOR>* n = nullptr) const; // O(n)
@@ -87,6 +93,7 @@ private:
     void obteFullesArbreAux(NodeTree<CLAU, VALOR>* n, bool esq, list<NodeTree<CLAU, VALOR>*>* llista)const;
     void arbreMirallAux(NodeTree<CLAU,VALOR> *n); // O(n), ja que només ha de recorrer tot l'arbre
     NodeTree<CLAU,VALOR> *cercarAux(NodeTree<CLAU, VALOR> *node, const CLAU&K)const;
+    NodeTree<CLAU,VALOR>* construeixOrdenatAux(vector<pair<CLAU, VALOR>>& elements, size_t inici, size_t fi, NodeTree<CLAU,VALOR>* pare);
     void preordre(const NodeTree<CLAU,VALOR>* n) const;
     void inordre(const NodeTree<CLAU,VALOR>* n) const;
     void postordre(const NodeTree<CLAU,VALOR>* n) const;
@@ -140,27 +147,62 @@ int BST<CLAU, VALOR>::altura() const{
 */
 template <class CLAU, class VALOR>
 NodeTree<CLAU,VALOR>* BST<CLAU, VALOR>::insereix(const CLAU& clau, const VALOR& value){
+    return insereix(clau, VALOR(value));
+}
+
+template <class CLAU, class VALOR>
+NodeTree<CLAU,VALOR>* BST<CLAU, VALOR>::insereix(const CLAU& clau, VALOR&& value){
     NodeTree<CLAU, VALOR>* n = cercarAux(arrel, clau);
     _mida++;
     if (n == nullptr){
-        arrel = new NodeTree<CLAU, VALOR>(clau, value);
+        arrel = new NodeTree<CLAU, VALOR>(clau, std::move(value));
         return arrel;
     }
     else{
         if (clau < n->getKey()){
-            NodeTree<CLAU, VALOR>* l = new NodeTree<CLAU, VALOR>(clau, value);
+            NodeTree<CLAU, VALOR>* l = new NodeTree<CLAU, VALOR>(clau, std::move(value));
             l->setParent(n);
             n->setLeft(l);
             return n->getLeft();
         }
         else {
-            NodeTree<CLAU, VALOR>* r = new NodeTree<CLAU, VALOR>(clau, value);
+            NodeTree<CLAU, VALOR>* r = new NodeTree<CLAU, VALOR>(clau, std::move(value));
             r->setParent(n);
             n->setRight(r);
             return n->getRight();
         }
     }
 }
+/**
+ * Mètode que construeix de cop un arbre equilibrat a partir d'elements ordenats per clau.
+ * L'arbre ha de ser buit i les claus no es poden repetir. Els valors es mouen dins dels nodes.
+*/
+template <class CLAU, class VALOR>
+void BST<CLAU, VALOR>::construeixOrdenat(vector<pair<CLAU, VALOR>>& elements){
+    if (arrel != nullptr) throw logic_error("L'arbre no és buit\n");
+    for (size_t i = 1; i < elements.size(); i++){
+        if (elements[i].first == elements[i - 1].first) throw logic_error("Ja existeix un artista amb l'identificador\n");
+        if (elements[i].first < elements[i - 1].first) throw logic_error("Les claus no estan ordenades\n");
+    }
+    arrel = construeixOrdenatAux(elements, 0, elements.size(), nullptr);
+    _mida = static_cast<int>(elements.size());
+}
+
+/**
+ * Mètode auxiliar que posa l'element del mig com a arrel del subarbre [inici, fi)
+ * @return NodeTree arrel del subarbre construït
+*/
+template <class CLAU, class VALOR>
+NodeTree<CLAU,VALOR>* BST<CLAU, VALOR>::construeixOrdenatAux(vector<pair<CLAU, VALOR>>& elements, size_t inici, size_t fi, NodeTree<CLAU,VALOR>* pare){
+    if (inici >= fi) return nullptr;
+    size_t mig = inici + (fi - inici) / 2;
+    NodeTree<CLAU, VALOR>* n = new NodeTree<CLAU, VALOR>(elements[mig].first, std::move(elements[mig].second));
+    n->setParent(pare);
+    n->setLeft(construeixOrdenatAux(elements, inici, mig, n));
+    n->setRight(construeixOrdenatAux(elements, mig + 1, fi, n));
+    return n;
+}
+
 /**
  * Mètode que cerca un node en l'arbre amb l'identificador
  * @return NodeTree el node amb la clau entrada
@@ -0,0 +1,165 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Scaling benchmark of the search engines (Banc de proves d'escalat).
+ * For every size (1K, 10K, 100K, ... rows up to maxFiles) it writes a synthetic catalogue with
+ * GeneradorArtistes and measures, for every backend:
+ * - carrega: loading the CSV (BST and AVL insert the rows in the order of the file, "AVL lot"
+ *   reads in parallel and builds the balanced tree at once).
+ * - cerca: buscarArtista of random ids (1 of 10 does not exist).
+ * - estil: obtenirArtistesPerEstil of random styles, with the query caches disabled.
+ * - playcount: buscarRecompteArtistes and obtenirArtistesPerPlaycount of random ranges.
+ * When loading a size takes more than limitSegons, the bigger sizes of that backend are skipped
+ * (the BST with sorted ids is O(n^2) and would not finish), and every kind of query stops after
+ * limitSegons (the time per query is the average of the queries done). The number of artists
+ * returned by the style and playcount queries is added up and printed, so the queries are not removed
+ * by the compiler and the results of the backends can be compared.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - bancProvesEscalat: O(sum of the sizes) to write the files, plus the cost of every backend.
+ *   Only one catalogue and one search engine are in memory at a time.
+ *
+ * ################################################
+ */
+
+#ifndef BANCPROVES_H
+#define BANCPROVES_H
+#include "GeneradorArtistes.h"
+#include "CercadorArtistes.h"
+#include "CercadorArtistesAVL.h"
+#include <string>
+#include <vector>
+#include <list>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+
+using namespace std;
+
+struct ResultatEscalat {
+    string cercador;
+    size_t files = 0;
+    double carregaMs = 0;
+    double cercaNs = 0;         // Per consulta
+    double estilUs = 0;
+    double playcountUs = 0;
+    int altura = 0;
+    size_t trobats = 0;         // Cerques d'artistes que existeixen
+    size_t resultats = 0;       // Artistes retornats per les consultes d'estil i de playcount
+};
+
+struct ConfiguracioBancProves {
+    size_t minFiles = 1000;
+    size_t maxFiles = 100000000;
+    ConfiguracioGenerador::OrdreIds ordre = ConfiguracioGenerador::ALEATORI;
+    double limitSegons = 60;
+    size_t cerques = 200000;
+    size_t consultesEstil = 200;
+    size_t consultesPlaycount = 2000;
+    string directori = ".";
+};
+
+/**
+ * Crida a consulta(i) n cops o fins que passen limitSegons
+ * @return double nanosegons per consulta
+*/
+template <class F>
+double mesuraConsultes(size_t n, double limitSegons, F consulta) {
+    chrono::steady_clock::time_point inici = chrono::steady_clock::now();
+    chrono::steady_clock::time_point limit = inici
+        + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(limitSegons));
+    size_t fetes = 0;
+    while (fetes < n) {
+        consulta(fetes++);
+        if (fetes % 64 == 0 && chrono::steady_clock::now() > limit) break;
+    }
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - inici).count() / max<size_t>(fetes, 1);
+}
+
+/**
+ * Carrega un catàleg en un cercador i hi fa les consultes de cada tipus
+ * @return ResultatEscalat temps de càrrega i de cada consulta
+*/
+template <class Cercador>
+ResultatEscalat mesuraCercador(const string& nom, const string& fitxer, size_t files, bool paral, const ConfiguracioBancProves& c) {
+    typedef chrono::steady_clock Rellotge;
+    ResultatEscalat r;
+    r.cercador = nom;
+    r.files = files;
+    Cercador cercador;
+    cercador.configuraCache(0);
+
+    Rellotge::time_point t0 = Rellotge::now();
+    if (paral) cercador.afegeixArtistesParallel(list<string>{fitxer});
+    else cercador.afegeixArtistes(fitxer);
+    r.carregaMs = chrono::duration<double, milli>(Rellotge::now() - t0).count();
+    r.altura = cercador.height();
+
+    // Els ids del catàleg són 1..files
+    mt19937 aleatori(5);
+    uniform_int_distribution<int> id(1, static_cast<int>(files + files / 9 + 1));
+    r.cercaNs = mesuraConsultes(c.cerques, c.limitSegons, [&](size_t) { r.trobats += cercador.buscarArtista(id(aleatori)); });
+
+    static const char* const ESTILS[] = {"rock", "rap", "pop", "jazz", "shoegaze", "mathcore", "polka"};
+    r.estilUs = mesuraConsultes(c.consultesEstil, c.limitSegons, [&](size_t i) {
+        r.resultats += cercador.obtenirArtistesPerEstil(ESTILS[i % 7]).size();
+    }) / 1000;
+
+    uniform_int_distribution<int> playcount(1, 400000);
+    r.playcountUs = mesuraConsultes(c.consultesPlaycount, c.limitSegons, [&](size_t) {
+        int a = playcount(aleatori);
+        r.resultats += static_cast<size_t>(cercador.buscarRecompteArtistes(a, a * 2));
+        r.resultats += cercador.obtenirArtistesPerPlaycount(a * 1000, a * 1000 + 1000).size();
+    }) / 1000;
+    return r;
+}
+
+/**
+ * Escriu una fila de la taula de resultats
+*/
+void escriuResultat(ostream& sortida, const ResultatEscalat& r) {
+    sortida << left << setw(8) << r.cercador << right << setw(11) << r.files << fixed << setprecision(1)
+            << setw(12) << r.carregaMs << setw(10) << r.cercaNs << setw(12) << r.estilUs << setw(13) << r.playcountUs
+            << setw(8) << r.altura << setw(12) << r.resultats << endl;
+}
+
+/**
+ * Executa el banc de proves per totes les mides de c.minFiles a c.maxFiles (multiplicant per 10)
+ * @return vector<ResultatEscalat> resultats de cada cercador i mida
+*/
+vector<ResultatEscalat> bancProvesEscalat(const ConfiguracioBancProves& c, ostream& sortida) {
+    static const char* const NOMS[] = {"BST", "AVL", "AVL lot"};
+    bool actius[] = {true, true, true};
+    vector<ResultatEscalat> resultats;
+    sortida << left << setw(8) << "cercador" << right << setw(11) << "files" << setw(12) << "carrega ms"
+            << setw(10) << "cerca ns" << setw(12) << "estil us" << setw(13) << "playcount us" << setw(8) << "altura" << setw(12) << "resultats" << endl;
+    for (size_t files = c.minFiles; files <= c.maxFiles && (actius[0] || actius[1] || actius[2]); files *= 10) {
+        ConfiguracioGenerador g;
+        g.files = files;
+        g.ordre = c.ordre;
+        string fitxer = c.directori + "/artistes_" + to_string(files) + ".csv";
+        generaArtistes(fitxer, g);
+        for (int b = 0; b < 3; b++) {
+            if (!actius[b]) continue;
+            ResultatEscalat r = (b == 0) ? mesuraCercador<CercadorArtistes>(NOMS[b], fitxer, files, false, c)
+                : mesuraCercador<CercadorArtistesAVL>(NOMS[b], fitxer, files, b == 2, c);
+            escriuResultat(sortida, r);
+            resultats.push_back(r);
+            if (r.carregaMs > c.limitSegons * 1000) {
+                sortida << NOMS[b] << ": la carrega passa de " << c.limitSegons << " s, no es proven mides mes grans" << endl;
+                actius[b] = false;
+            }
+        }
+        remove(fitxer.c_str());
+    }
+    return resultats;
+}
+
+#endif /* BANCPROVES_H */
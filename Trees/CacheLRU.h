@@ -0,0 +1,263 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * LRU cache of query results (Memòria cau LRU).
+ * This class keeps the last results of the search engine queries. When it is full it evicts
+ * the least recently used result. A HashTable finds the entry of a key, and the entries are
+ * linked in a recency list by their positions (intrusive list), so no extra node is allocated.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - obte, posa, invalida: O(1) average (HashTable lookup plus moving an entry in the list).
+ * - buida: O(n).
+ * - teEntrades: O(1) without the mutex, so the writers can skip invalidating an empty cache.
+ * - The cache uses O(n) space, bounded by maxEntrades entries and maxBytes bytes of results.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * posicions : HashTable from every key to the position of its entry.
+ * entrades : Array of entries (key, value, bytes, previous and next in the recency list).
+ * lliures : Positions of the array that can be reused.
+ * primer, ultim : Most and least recently used entries.
+ * encerts, errades, expulsions, invalidacions : Counters of the cache.
+ * ocupades : Number of entries, atomic so it can be read without the mutex.
+ *
+ * All the methods hold a mutex, so the cache can be used from const queries called by several threads.
+ *
+ * ################################################
+ */
+
+#ifndef CACHELRU_H
+#define CACHELRU_H
+#include "../Hash_Tables/HashTable.h"
+#include <vector>
+#include <cstdint>
+#include <mutex>
+#include <atomic>
+
+using namespace std;
+
+struct EstadistiquesCache {
+    size_t encerts = 0;
+    size_t errades = 0;
+    size_t expulsions = 0;
+    size_t invalidacions = 0;
+    size_t entrades = 0;
+    size_t bytes = 0;
+};
+
+template <class K, class V>
+class CacheLRU {
+public:
+    CacheLRU(size_t maxEntrades = 1024, size_t maxBytes = SIZE_MAX);
+    CacheLRU(const CacheLRU<K, V>&) = delete;
+    CacheLRU<K, V>& operator=(const CacheLRU<K, V>&) = delete;
+
+    bool obte(const K& clau, V& valor);
+    void posa(const K& clau, const V& valor, size_t bytes = 0);
+    bool invalida(const K& clau);
+    void buida();
+    void configura(size_t maxEntrades, size_t maxBytes = SIZE_MAX);
+    EstadistiquesCache estadistiques() const;
+    bool teEntrades() const;
+
+private:
+    static const uint32_t CAP = UINT32_MAX;
+
+    struct Entrada {
+        K clau;
+        V valor;
+        size_t bytes;
+        uint32_t anterior;
+        uint32_t seguent;
+    };
+
+    HashTable<K, uint32_t> posicions;
+    vector<Entrada> entrades;
+    vector<uint32_t> lliures;
+    uint32_t primer, ultim;
+    size_t maxEntrades, maxBytes, bytes;
+    size_t encerts, errades, expulsions, invalidacions;
+    atomic<size_t> ocupades;
+    mutable mutex mtx;
+
+    void desenllaca(uint32_t e);
+    void enllacaPrimer(uint32_t e);
+    void treu(uint32_t e);
+    void expulsaSobrants();
+};
+
+/**
+ * Constructor amb el nombre màxim d'entrades i de bytes
+*/
+template <class K, class V>
+CacheLRU<K, V>::CacheLRU(size_t maxEntrades, size_t maxBytes):
+    posicions(64), primer(CAP), ultim(CAP), maxEntrades(maxEntrades), maxBytes(maxBytes), bytes(0),
+    encerts(0), errades(0), expulsions(0), invalidacions(0), ocupades(0) {}
+
+/**
+ * Treu una entrada de la llista de recència
+*/
+template <class K, class V>
+void CacheLRU<K, V>::desenllaca(uint32_t e) {
+    Entrada& x = entrades[e];
+    if (x.anterior != CAP) entrades[x.anterior].seguent = x.seguent;
+    else primer = x.seguent;
+    if (x.seguent != CAP) entrades[x.seguent].anterior = x.anterior;
+    else ultim = x.anterior;
+    x.anterior = x.seguent = CAP;
+}
+
+/**
+ * Posa una entrada al principi de la llista de recència (la més recent)
+*/
+template <class K, class V>
+void CacheLRU<K, V>::enllacaPrimer(uint32_t e) {
+    entrades[e].anterior = CAP;
+    entrades[e].seguent = primer;
+    if (primer != CAP) entrades[primer].anterior = e;
+    primer = e;
+    if (ultim == CAP) ultim = e;
+}
+
+/**
+ * Esborra una entrada de la cache i deixa lliure la seva posició
+*/
+template <class K, class V>
+void CacheLRU<K, V>::treu(uint32_t e) {
+    desenllaca(e);
+    posicions.remove(entrades[e].clau);
+    bytes -= entrades[e].bytes;
+    entrades[e].valor = V();
+    lliures.push_back(e);
+    ocupades.store(posicions.size(), memory_order_release);
+}
+
+/**
+ * Expulsa les entrades menys usades fins que la cache compleix els límits
+*/
+template <class K, class V>
+void CacheLRU<K, V>::expulsaSobrants() {
+    while (ultim != CAP && (posicions.size() > maxEntrades || bytes > maxBytes)) {
+        treu(ultim);
+        expulsions++;
+    }
+}
+
+/**
+ * Busca el resultat d'una clau i el marca com el més recent
+ * @return bool si la clau era a la cache (encert)
+*/
+template <class K, class V>
+bool CacheLRU<K, V>::obte(const K& clau, V& valor) {
+    lock_guard<mutex> lock(mtx);
+    if (!posicions.contains(clau)) {
+        errades++;
+        return false;
+    }
+    uint32_t e = posicions.get(clau);
+    desenllaca(e);
+    enllacaPrimer(e);
+    valor = entrades[e].valor;
+    encerts++;
+    return true;
+}
+
+/**
+ * Guarda el resultat d'una clau com el més recent. bytes és la mida del resultat per al límit de bytes
+*/
+template <class K, class V>
+void CacheLRU<K, V>::posa(const K& clau, const V& valor, size_t bytes) {
+    lock_guard<mutex> lock(mtx);
+    if (posicions.contains(clau)) treu(posicions.get(clau));
+    if (maxEntrades == 0 || bytes > maxBytes) return;
+
+    uint32_t e;
+    if (!lliures.empty()) {
+        e = lliures.back();
+        lliures.pop_back();
+        entrades[e].clau = clau;
+        entrades[e].valor = valor;
+        entrades[e].bytes = bytes;
+    } else {
+        e = static_cast<uint32_t>(entrades.size());
+        entrades.push_back(Entrada{clau, valor, bytes, CAP, CAP});
+    }
+    posicions.insert(clau, e);
+    ocupades.store(posicions.size(), memory_order_release);
+    this->bytes += bytes;
+    enllacaPrimer(e);
+    expulsaSobrants();
+}
+
+/**
+ * Esborra el resultat d'una clau perquè ja no és vàlid
+ * @return bool si la clau era a la cache
+*/
+template <class K, class V>
+bool CacheLRU<K, V>::invalida(const K& clau) {
+    lock_guard<mutex> lock(mtx);
+    if (!posicions.contains(clau)) return false;
+    treu(posicions.get(clau));
+    invalidacions++;
+    return true;
+}
+
+/**
+ * Esborra tots els resultats (els comptadors es mantenen)
+*/
+template <class K, class V>
+void CacheLRU<K, V>::buida() {
+    lock_guard<mutex> lock(mtx);
+    invalidacions += posicions.size();
+    posicions.clear();
+    entrades.clear();
+    lliures.clear();
+    primer = ultim = CAP;
+    bytes = 0;
+    ocupades.store(0, memory_order_release);
+}
+
+/**
+ * Canvia els límits de la cache i expulsa el que sobra
+*/
+template <class K, class V>
+void CacheLRU<K, V>::configura(size_t maxEntrades, size_t maxBytes) {
+    lock_guard<mutex> lock(mtx);
+    this->maxEntrades = maxEntrades;
+    this->maxBytes = maxBytes;
+    expulsaSobrants();
+}
+
+/**
+ * Comptadors d'encerts, errades, expulsions i invalidacions, i l'ocupació actual
+ * @return EstadistiquesCache estadístiques de la cache
+*/
+template <class K, class V>
+EstadistiquesCache CacheLRU<K, V>::estadistiques() const {
+    lock_guard<mutex> lock(mtx);
+    EstadistiquesCache e;
+    e.encerts = encerts;
+    e.errades = errades;
+    e.expulsions = expulsions;
+    e.invalidacions = invalidacions;
+    e.entrades = posicions.size();
+    e.bytes = bytes;
+    return e;
+}
+
+/**
+ * Diu si la cache té alguna entrada, sense bloquejar el mutex
+ * @return bool si hi ha alguna entrada
+*/
+template <class K, class V>
+bool CacheLRU<K, V>::teEntrades() const {
+    return ocupades.load(memory_order_acquire) > 0;
+}
+
+#endif /* CACHELRU_H */
@@ -0,0 +1,84 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * Funcions per carregar artistes des de fitxers CSV, compartides per CercadorArtistes i CercadorArtistesAVL.
+ *
+ * artistaDeFila : Converteix una fila del LectorCSV en un Artist. O(mida de la fila)
+ * llegeixArtistesParallel : Divideix cada fitxer en trossos tallats en salts de línia i els converteix
+ * en artistes en un PoolFils. Retorna els trossos en l'ordre dels fitxers, així qui insereix pot
+ * mantenir el mateix ordre (i els mateixos errors d'identificador repetit) que la càrrega seqüencial.
+ * O(n / fils) temps per fil i O(n) espai.
+ */
+
+#ifndef CARREGADORARTISTES_H
+#define CARREGADORARTISTES_H
+#include "Artist.h"
+#include "LectorCSV.h"
+#include "PoolFils.h"
+#include <list>
+#include <vector>
+#include <memory>
+#include <exception>
+
+using namespace std;
+
+/**
+ * Artistes d'un tros d'un fitxer, en l'ordre del fitxer. Si una fila no s'ha pogut llegir,
+ * error guarda l'excepció i artistes conté les files anteriors.
+*/
+struct TrosArtistes {
+    vector<Artist> artistes;
+    exception_ptr error;
+};
+
+/**
+ * Converteix una fila llegida d'un fitxer en un Artist. El gènere, el país i els estils es retallen,
+ * perquè " United States" i "United States" tinguin el mateix codi als diccionaris.
+ * @return Artist amb les dades de la fila
+*/
+Artist artistaDeFila(const FilaArtista& fila){
+    Artist a(fila.artistId, fila.name, LectorCSV::retalla(fila.gender), LectorCSV::retalla(fila.country),
+             LectorCSV::retalla(fila.styles), fila.playcount);
+    if (LectorCSV::teCometes(fila.name)) a.setName(LectorCSV::text(fila.name));
+    return a;
+}
+
+/**
+ * Llegeix els fitxers en paral·lel. Els fitxers que no es poden obrir s'avisen i se salten.
+ * @return vector de trossos en l'ordre dels fitxers
+*/
+vector<TrosArtistes> llegeixArtistesParallel(const list<string>& fitxers, PoolFils& pool){
+    vector<unique_ptr<LectorCSV>> lectors;
+    vector<future<TrosArtistes>> pendents;
+
+    for (const string& filename : fitxers) {
+        lectors.push_back(make_unique<LectorCSV>(filename));
+        const LectorCSV& lector = *lectors.back();
+        if (!lector.obert()) {
+            cerr << "Error: Unable to open file " << filename << endl;
+            continue;
+        }
+        // Més trossos que fils perquè els fils que acabin abans en puguin agafar un altre
+        for (string_view tros : lector.trossos(pool.mida() * 4)) {
+            pendents.push_back(pool.envia([tros] {
+                TrosArtistes resultat;
+                resultat.artistes.reserve(tros.size() / 48 + 1);
+                try {
+                    LectorCSV::recorreTros(tros, [&resultat](const FilaArtista& fila) {
+                        resultat.artistes.push_back(artistaDeFila(fila));
+                    });
+                } catch (...) {
+                    resultat.error = current_exception();
+                }
+                return resultat;
+            }));
+        }
+    }
+
+    vector<TrosArtistes> trossos;
+    trossos.reserve(pendents.size());
+    for (future<TrosArtistes>& p : pendents) trossos.push_back(p.get());
+    return trossos;
+}
+
+#endif /* CARREGADORARTISTES_H */
@@ -0,0 +1,582 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Pipelined loader of artist files (Carregador per etapes).
+ * afegeixArtistes reads, parses and inserts one after the other, so the CPU waits for the disk and
+ * the disk waits for the tree. carregaPerEtapes splits the load in three stages that run at the same
+ * time, connected by bounded queues (CuaAcotada):
+ * - lectura (a thread): reads the files in blocks of midaBloc bytes. On Linux it uses io_uring
+ *   (LectorUring) with up to profunditat reads in flight, so the kernel reads the next blocks while
+ *   the previous ones are parsed. If io_uring is not available it reads with ifstream.
+ * - analisi (a thread): cuts the blocks in rows (a row can be split between two blocks) and converts
+ *   them into a TrosArtistes per block.
+ * - insercio (the calling thread): calls insereix with every TrosArtistes, in the order of the files.
+ * When a queue is full the stage before it waits, so the memory is bounded by the capacity of the
+ * queues. Every stage measures the time it works and the time it waits for the stage before it
+ * (entrada) or after it (sortida), to know which one limits the load.
+ * The errors are the same as with afegeixArtistes: the files that cannot be opened are skipped, and
+ * a wrong row stops the load after inserting the rows before it.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - carregaPerEtapes: O(n) to read and parse, plus the cost of insereix, in the time of the slowest
+ *   stage instead of the sum of the three.
+ * - Memory: (capacitat + profunditat + 2) blocks of midaBloc bytes plus capacitat parsed blocks.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * CuaAcotada : deque of elements, capacity, closed flag, a mutex and a condition variable for each side.
+ * LectorUring : The io_uring file descriptor and the mapped submission and completion rings.
+ *
+ * ################################################
+ */
+
+#ifndef CARREGADORETAPES_H
+#define CARREGADORETAPES_H
+#include "CarregadorArtistes.h"
+#include "LectorCSV.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <list>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define CARREGADOR_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#endif
+
+using namespace std;
+
+struct ConfiguracioEtapes {
+    size_t midaBloc = 1 << 20;      // Bytes de cada lectura
+    size_t capacitat = 8;           // Elements de cada cua entre etapes
+    unsigned profunditat = 4;       // Lectures en vol amb io_uring
+    bool ioUring = true;            // false: llegeix sempre amb ifstream
+};
+
+struct EtapaCarrega {
+    double ocupatSegons = 0;            // Treballant (la lectura inclou esperar el disc)
+    double esperaEntradaSegons = 0;     // Esperant l'etapa anterior
+    double esperaSortidaSegons = 0;     // Esperant que l'etapa següent faci lloc a la cua
+    size_t elements = 0;                // Blocs o trossos fets
+
+    double ocupacio(double totalSegons) const { return totalSegons > 0 ? ocupatSegons / totalSegons : 0; }
+};
+
+struct EstadistiquesEtapes {
+    double segons = 0;
+    size_t bytes = 0;
+    size_t files = 0;
+    bool ioUring = false;       // La lectura ha fet servir io_uring
+    EtapaCarrega lectura;
+    EtapaCarrega analisi;
+    EtapaCarrega insercio;
+};
+
+template <class T>
+class CuaAcotada {
+public:
+    explicit CuaAcotada(size_t capacitat);
+
+    bool posa(T element, double& esperaSegons);
+    bool treu(T& element, double& esperaSegons);
+    bool provaTreu(T& element);
+    void tanca();
+
+private:
+    deque<T> elements;
+    size_t capacitat;
+    bool tancada;
+    mutex mtx;
+    condition_variable noPlena;
+    condition_variable noBuida;
+};
+
+/**
+ * Constructor d'una cua buida que admet com a molt capacitat elements
+*/
+template <class T>
+CuaAcotada<T>::CuaAcotada(size_t capacitat): capacitat(capacitat == 0 ? 1 : capacitat), tancada(false) {}
+
+/**
+ * Posa un element al final. Si la cua és plena espera i suma el temps a esperaSegons
+ * @return bool false si la cua s'ha tancat (l'element es descarta)
+*/
+template <class T>
+bool CuaAcotada<T>::posa(T element, double& esperaSegons) {
+    {
+        unique_lock<mutex> lock(mtx);
+        if (!tancada && elements.size() >= capacitat) {
+            chrono::steady_clock::time_point inici = chrono::steady_clock::now();
+            noPlena.wait(lock, [this] { return tancada || elements.size() < capacitat; });
+            esperaSegons += chrono::duration<double>(chrono::steady_clock::now() - inici).count();
+        }
+        if (tancada) return false;
+        elements.push_back(std::move(element));
+    }
+    noBuida.notify_one();
+    return true;
+}
+
+/**
+ * Treu el primer element. Si la cua és buida espera i suma el temps a esperaSegons
+ * @return bool false si la cua s'ha tancat i ja no hi queda cap element
+*/
+template <class T>
+bool CuaAcotada<T>::treu(T& element, double& esperaSegons) {
+    {
+        unique_lock<mutex> lock(mtx);
+        if (!tancada && elements.empty()) {
+            chrono::steady_clock::time_point inici = chrono::steady_clock::now();
+            noBuida.wait(lock, [this] { return tancada || !elements.empty(); });
+            esperaSegons += chrono::duration<double>(chrono::steady_clock::now() - inici).count();
+        }
+        if (elements.empty()) return false;
+        element = std::move(elements.front());
+        elements.pop_front();
+    }
+    noPlena.notify_one();
+    return true;
+}
+
+/**
+ * Treu el primer element si n'hi ha algun, sense esperar
+ * @return bool si n'ha tret un
+*/
+template <class T>
+bool CuaAcotada<T>::provaTreu(T& element) {
+    {
+        lock_guard<mutex> lock(mtx);
+        if (elements.empty()) return false;
+        element = std::move(elements.front());
+        elements.pop_front();
+    }
+    noPlena.notify_one();
+    return true;
+}
+
+/**
+ * Tanca la cua: posa deixa de guardar elements i treu acaba quan la cua queda buida
+*/
+template <class T>
+void CuaAcotada<T>::tanca() {
+    {
+        lock_guard<mutex> lock(mtx);
+        tancada = true;
+    }
+    noPlena.notify_all();
+    noBuida.notify_all();
+}
+
+#ifdef CARREGADOR_IO_URING
+class LectorUring {
+public:
+    explicit LectorUring(unsigned entrades);
+    LectorUring(const LectorUring&) = delete;
+    LectorUring& operator=(const LectorUring&) = delete;
+    ~LectorUring();
+
+    bool obert() const;
+    bool envia(int fd, char* desti, unsigned mida, uint64_t posicio, uint64_t dada);
+    bool espera(uint64_t& dada, int& resultat);
+
+private:
+    int fd;
+    void* anellEnviament;
+    size_t midaEnviament;
+    void* anellCompletats;
+    size_t midaCompletats;
+    io_uring_sqe* peticions;
+    size_t midaPeticions;
+
+    unsigned* cuaEnviament;
+    unsigned mascaraEnviament;
+    unsigned* indexosEnviament;
+    unsigned* capCompletats;
+    unsigned* cuaCompletats;
+    unsigned mascaraCompletats;
+    io_uring_cqe* completats;
+};
+
+/**
+ * Constructor que crea l'anell i el mapeja. Si el nucli no té io_uring (o no es pot fer servir), obert() és false
+*/
+LectorUring::LectorUring(unsigned entrades): fd(-1), anellEnviament(MAP_FAILED), midaEnviament(0),
+    anellCompletats(MAP_FAILED), midaCompletats(0), peticions(static_cast<io_uring_sqe*>(MAP_FAILED)), midaPeticions(0) {
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    fd = static_cast<int>(syscall(__NR_io_uring_setup, entrades, &p));
+    if (fd < 0) return;
+    if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+        // Nucli anterior a IORING_OP_READ (5.6): es llegeix amb ifstream
+        close(fd);
+        fd = -1;
+        return;
+    }
+
+    midaEnviament = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    midaCompletats = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool unSolMapa = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (unSolMapa) midaEnviament = midaCompletats = max(midaEnviament, midaCompletats);
+    anellEnviament = mmap(nullptr, midaEnviament, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (anellEnviament == MAP_FAILED) return;
+    if (unSolMapa) anellCompletats = anellEnviament;
+    else anellCompletats = mmap(nullptr, midaCompletats, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (anellCompletats == MAP_FAILED) return;
+    midaPeticions = p.sq_entries * sizeof(io_uring_sqe);
+    peticions = static_cast<io_uring_sqe*>(mmap(nullptr, midaPeticions, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+    if (peticions == MAP_FAILED) return;
+
+    char* e = static_cast<char*>(anellEnviament);
+    char* c = static_cast<char*>(anellCompletats);
+    cuaEnviament = reinterpret_cast<unsigned*>(e + p.sq_off.tail);
+    mascaraEnviament = *reinterpret_cast<unsigned*>(e + p.sq_off.ring_mask);
+    indexosEnviament = reinterpret_cast<unsigned*>(e + p.sq_off.array);
+    capCompletats = reinterpret_cast<unsigned*>(c + p.cq_off.head);
+    cuaCompletats = reinterpret_cast<unsigned*>(c + p.cq_off.tail);
+    mascaraCompletats = *reinterpret_cast<unsigned*>(c + p.cq_off.ring_mask);
+    completats = reinterpret_cast<io_uring_cqe*>(c + p.cq_off.cqes);
+}
+
+/**
+ * Destructor. Desmapeja els anells i tanca l'io_uring
+*/
+LectorUring::~LectorUring() {
+    if (peticions != MAP_FAILED) munmap(peticions, midaPeticions);
+    if (anellCompletats != MAP_FAILED && anellCompletats != anellEnviament) munmap(anellCompletats, midaCompletats);
+    if (anellEnviament != MAP_FAILED) munmap(anellEnviament, midaEnviament);
+    if (fd >= 0) close(fd);
+}
+
+bool LectorUring::obert() const {
+    return fd >= 0 && peticions != MAP_FAILED;
+}
+
+/**
+ * Envia la lectura de mida bytes del fitxer fd a partir de posicio. dada torna amb la resposta
+ * @return bool si s'ha pogut enviar
+*/
+bool LectorUring::envia(int fitxer, char* desti, unsigned mida, uint64_t posicio, uint64_t dada) {
+    // Només aquest fil escriu la cua d'enviament, el nucli llegeix fins on diu
+    unsigned cua = *cuaEnviament;
+    unsigned index = cua & mascaraEnviament;
+    io_uring_sqe& sqe = peticions[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_READ;
+    sqe.fd = fitxer;
+    sqe.addr = reinterpret_cast<uint64_t>(desti);
+    sqe.len = mida;
+    sqe.off = posicio;
+    sqe.user_data = dada;
+    indexosEnviament[index] = index;
+    __atomic_store_n(cuaEnviament, cua + 1, __ATOMIC_RELEASE);
+    long enviades;
+    do {
+        enviades = syscall(__NR_io_uring_enter, fd, 1, 0, 0, nullptr, 0);
+    } while (enviades < 0 && errno == EINTR);
+    return enviades == 1;
+}
+
+/**
+ * Espera que acabi una lectura
+ * @return bool si n'ha acabat alguna; dada és la de envia i resultat els bytes llegits o -errno
+*/
+bool LectorUring::espera(uint64_t& dada, int& resultat) {
+    while (true) {
+        unsigned cap = *capCompletats;
+        if (cap != __atomic_load_n(cuaCompletats, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe& cqe = completats[cap & mascaraCompletats];
+            dada = cqe.user_data;
+            resultat = cqe.res;
+            __atomic_store_n(capCompletats, cap + 1, __ATOMIC_RELEASE);
+            return true;
+        }
+        if (syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR) return false;
+    }
+}
+#endif /* CARREGADOR_IO_URING */
+
+/**
+ * Bloc llegit d'un fitxer
+*/
+struct BlocFitxer {
+    vector<char> dades;
+    size_t mida = 0;
+    bool primer = false;    // Primer bloc del fitxer (comença amb la capçalera)
+    bool ultim = false;     // Últim bloc del fitxer
+};
+
+/**
+ * Etapa de lectura amb ifstream: posa els blocs de cada fitxer a la cua
+ * @return bool false si la cua s'ha tancat
+*/
+bool llegeixBlocsFitxer(const string& fitxer, const ConfiguracioEtapes& c, CuaAcotada<BlocFitxer>& blocs,
+                        CuaAcotada<vector<char>>& lliures, EstadistiquesEtapes& e) {
+    ifstream entrada(fitxer, ios::binary);
+    if (!entrada.is_open()) {
+        cerr << "Error: Unable to open file " << fitxer << endl;
+        return true;
+    }
+    bool primer = true;
+    while (true) {
+        BlocFitxer bloc;
+        if (!lliures.provaTreu(bloc.dades)) bloc.dades.resize(c.midaBloc);
+        entrada.read(bloc.dades.data(), static_cast<streamsize>(c.midaBloc));
+        bloc.mida = static_cast<size_t>(entrada.gcount());
+        bloc.primer = primer;
+        bloc.ultim = bloc.mida < c.midaBloc;
+        primer = false;
+        e.bytes += bloc.mida;
+        e.lectura.elements++;
+        bool ultim = bloc.ultim;
+        if (!blocs.posa(std::move(bloc), e.lectura.esperaSortidaSegons)) return false;
+        if (ultim) return true;
+    }
+}
+
+#ifdef CARREGADOR_IO_URING
+/**
+ * Etapa de lectura amb io_uring: manté fins a c.profunditat lectures en vol i posa els blocs a la cua
+ * en l'ordre del fitxer. Una lectura curta (abans del final) es completa amb pread
+ * @return bool false si la cua s'ha tancat
+*/
+bool llegeixBlocsFitxerUring(const string& fitxer, const ConfiguracioEtapes& c, LectorUring& anell,
+                             CuaAcotada<BlocFitxer>& blocs, CuaAcotada<vector<char>>& lliures, EstadistiquesEtapes& e) {
+    int fd = open(fitxer.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        cerr << "Error: Unable to open file " << fitxer << endl;
+        return true;
+    }
+    size_t mida = static_cast<size_t>(st.st_size);
+    size_t nBlocs = max<size_t>(1, (mida + c.midaBloc - 1) / c.midaBloc);
+
+    // Lectures en vol, de la més antiga a la més nova: el bloc i si ja ha acabat (resultat >= 0 o -errno)
+    struct Lectura {
+        BlocFitxer bloc;
+        bool acabada = false;
+        int resultat = 0;
+    };
+    deque<Lectura> enVol;
+    size_t enviats = 0, lliurats = 0;
+    bool correcte = true;
+    // Espera les lectures en vol abans de tancar el fitxer i alliberar-ne els blocs. Si l'anell falla, els blocs
+    // que el nucli encara pot escriure no s'alliberen mai (es perden a propòsit) i el fitxer queda obert
+    auto drena = [&]() {
+        size_t pendents = static_cast<size_t>(count_if(enVol.begin(), enVol.end(), [](const Lectura& x) { return !x.acabada; }));
+        for (; pendents > 0; pendents--) {
+            uint64_t dada;
+            int resultat;
+            if (!anell.espera(dada, resultat)) break;
+            enVol[dada - lliurats].acabada = true;
+        }
+        if (pendents == 0) close(fd);
+        else {
+            for (Lectura& l : enVol) {
+                if (!l.acabada) new vector<char>(std::move(l.bloc.dades));
+            }
+        }
+    };
+    while (correcte && lliurats < nBlocs) {
+        while (enviats < nBlocs && enVol.size() < max(1u, c.profunditat)) {
+            Lectura l;
+            if (!lliures.provaTreu(l.bloc.dades)) l.bloc.dades.resize(c.midaBloc);
+            size_t posicio = enviats * c.midaBloc;
+            l.bloc.mida = min(c.midaBloc, mida - min(mida, posicio));
+            l.bloc.primer = (enviats == 0);
+            l.bloc.ultim = (enviats + 1 == nBlocs);
+            if (l.bloc.mida == 0) l.acabada = true;
+            enVol.push_back(std::move(l));
+            if (!enVol.back().acabada && !anell.envia(fd, enVol.back().bloc.dades.data(), static_cast<unsigned>(enVol.back().bloc.mida), posicio, enviats)) {
+                enVol.back().acabada = true;
+                enVol.back().resultat = -EIO;
+            }
+            enviats++;
+        }
+        while (!enVol.front().acabada) {
+            uint64_t dada;
+            int resultat;
+            if (!anell.espera(dada, resultat)) {
+                drena();
+                throw runtime_error("Error: io_uring ha fallat llegint " + fitxer);
+            }
+            Lectura& l = enVol[dada - lliurats];
+            l.acabada = true;
+            l.resultat = resultat;
+        }
+        Lectura l = std::move(enVol.front());
+        enVol.pop_front();
+        if (l.resultat < 0) {
+            lliurats++;     // enVol comença pel bloc següent
+            drena();
+            throw runtime_error("Error: no s'ha pogut llegir " + fitxer + ": " + strerror(-l.resultat));
+        }
+        for (size_t llegits = static_cast<size_t>(l.resultat); llegits < l.bloc.mida; ) {
+            ssize_t n = pread(fd, l.bloc.dades.data() + llegits, l.bloc.mida - llegits, static_cast<off_t>(lliurats * c.midaBloc + llegits));
+            if (n <= 0) {
+                l.bloc.mida = llegits;
+                break;
+            }
+            llegits += static_cast<size_t>(n);
+        }
+        lliurats++;
+        e.bytes += l.bloc.mida;
+        e.lectura.elements++;
+        correcte = blocs.posa(std::move(l.bloc), e.lectura.esperaSortidaSegons);
+    }
+    // Si la cua s'ha tancat, les lectures en vol encara escriuen als seus blocs
+    drena();
+    return correcte;
+}
+#endif /* CARREGADOR_IO_URING */
+
+/**
+ * Etapa d'anàlisi: talla els blocs en files i en fa un TrosArtistes per bloc. La part d'una fila que
+ * queda al final d'un bloc es guarda fins al bloc següent. Si una fila és incorrecta, el tros porta
+ * l'error i l'etapa s'atura
+*/
+void analitzaBlocs(CuaAcotada<BlocFitxer>& blocs, CuaAcotada<vector<char>>& lliures,
+                   CuaAcotada<TrosArtistes>& trossos, EstadistiquesEtapes& e) {
+    string resta;               // Principi de l'última fila del bloc anterior
+    bool capcalera = false;     // Encara s'ha de saltar la capçalera del fitxer
+    BlocFitxer bloc;
+    double espera = 0;
+    while (blocs.treu(bloc, e.analisi.esperaEntradaSegons)) {
+        if (bloc.primer) {
+            resta.clear();
+            capcalera = true;
+        }
+        TrosArtistes tros;
+        tros.artistes.reserve(bloc.mida / 48 + 1);
+        auto afegeix = [&tros](const FilaArtista& fila) { tros.artistes.push_back(artistaDeFila(fila)); };
+        const char* p = bloc.dades.data();
+        const char* fi = p + bloc.mida;
+        try {
+            if (capcalera) {
+                const char* salt = static_cast<const char*>(memchr(p, '\n', fi - p));
+                p = (salt == nullptr) ? fi : salt + 1;
+                capcalera = (salt == nullptr);
+            }
+            else if (!resta.empty()) {
+                const char* salt = static_cast<const char*>(memchr(p, '\n', fi - p));
+                const char* fiResta = (salt == nullptr) ? fi : salt + 1;
+                resta.append(p, fiResta);
+                p = fiResta;
+                if (salt != nullptr || bloc.ultim) {
+                    e.files += LectorCSV::recorreTros(resta, afegeix);
+                    resta.clear();
+                }
+            }
+            const char* fiFiles = fi;
+            if (!bloc.ultim) {
+                // L'última fila pot continuar al bloc següent
+                while (fiFiles > p && fiFiles[-1] != '\n') fiFiles--;
+                resta.append(fiFiles, fi);
+            }
+            e.files += LectorCSV::recorreTros(string_view(p, fiFiles - p), afegeix);
+        } catch (...) {
+            tros.error = current_exception();
+        }
+        lliures.posa(std::move(bloc.dades), espera);
+        bloc = BlocFitxer();
+        bool error = static_cast<bool>(tros.error);
+        e.analisi.elements++;
+        if (!trossos.posa(std::move(tros), e.analisi.esperaSortidaSegons) || error) break;
+    }
+    trossos.tanca();
+    blocs.tanca();
+}
+
+/**
+ * Carrega els fitxers amb les tres etapes a la vegada. insereix(TrosArtistes&) es crida des d'aquest fil
+ * amb els trossos en l'ordre dels fitxers; si llança una excepció, la càrrega s'atura i es torna a llançar
+ * @return EstadistiquesEtapes temps i ocupació de cada etapa
+*/
+template <class F>
+EstadistiquesEtapes carregaPerEtapes(const list<string>& fitxers, F insereix, const ConfiguracioEtapes& c = ConfiguracioEtapes()) {
+    typedef chrono::steady_clock Rellotge;
+    if (c.midaBloc < 4096) throw invalid_argument("La mida de bloc ha de ser com a minim de 4096 bytes\n");
+    EstadistiquesEtapes e;
+    CuaAcotada<BlocFitxer> blocs(c.capacitat);
+    CuaAcotada<TrosArtistes> trossos(c.capacitat);
+    CuaAcotada<vector<char>> lliures(c.capacitat + c.profunditat + 2);
+    exception_ptr errorLectura;
+    Rellotge::time_point inici = Rellotge::now();
+
+    thread lectura([&] {
+        Rellotge::time_point t0 = Rellotge::now();
+        try {
+#ifdef CARREGADOR_IO_URING
+            LectorUring anell(max(1u, c.profunditat));
+            e.ioUring = c.ioUring && anell.obert();
+#endif
+            for (const string& fitxer : fitxers) {
+#ifdef CARREGADOR_IO_URING
+                if (e.ioUring) {
+                    if (!llegeixBlocsFitxerUring(fitxer, c, anell, blocs, lliures, e)) break;
+                    continue;
+                }
+#endif
+                if (!llegeixBlocsFitxer(fitxer, c, blocs, lliures, e)) break;
+            }
+        } catch (...) {
+            errorLectura = current_exception();
+        }
+        blocs.tanca();
+        e.lectura.ocupatSegons = chrono::duration<double>(Rellotge::now() - t0).count() - e.lectura.esperaSortidaSegons;
+    });
+    thread analisi([&] {
+        Rellotge::time_point t0 = Rellotge::now();
+        analitzaBlocs(blocs, lliures, trossos, e);
+        e.analisi.ocupatSegons = chrono::duration<double>(Rellotge::now() - t0).count()
+            - e.analisi.esperaEntradaSegons - e.analisi.esperaSortidaSegons;
+    });
+
+    exception_ptr errorInsercio;
+    TrosArtistes tros;
+    try {
+        while (trossos.treu(tros, e.insercio.esperaEntradaSegons)) {
+            e.insercio.elements++;
+            insereix(tros);
+        }
+    } catch (...) {
+        errorInsercio = current_exception();
+    }
+    // Tancar les cues desperta les etapes que esperen si la inserció s'ha aturat abans d'hora
+    trossos.tanca();
+    blocs.tanca();
+    lectura.join();
+    analisi.join();
+    e.segons = chrono::duration<double>(Rellotge::now() - inici).count();
+    e.insercio.ocupatSegons = e.segons - e.insercio.esperaEntradaSegons;
+    if (errorInsercio) rethrow_exception(errorInsercio);
+    if (errorLectura) rethrow_exception(errorLectura);
+    return e;
+}
+
+#endif /* CARREGADORETAPES_H */
@@ -2,40 +2,143 @@
  * @author Albert Villanueva Kosoy Grup C
 */
 
+#ifndef CERCADORARTISTESAVL_H
+#define CERCADORARTISTESAVL_H
+
 #include <iostream>
 #include <list>
 #include "BST.h"
 #include "ABT.h"
 #include "Artist.h"
+#include "CarregadorArtistes.h"
+#include "CarregadorEtapes.h"
+#include "IndexosArtistes.h"
+#include "CacheLRU.h"
+#include "PlanificadorConsultes.h"
+#include "IngestaEvents.h"
+#include "RegistreEscriptura.h"
+#include "MagatzemArtistes.h"
+#include "FiltreBloom.h"
+#include "ConjuntEliasFano.h"
+#include "PatronsText.h"
+#include <memory>
 #include <fstream>
+#include <algorithm>
 
 using namespace std;
 class CercadorArtistesAVL: public ABT<int, Artist>{
     public:
     CercadorArtistesAVL();
 
-    void afegeixArtistes(string filename); // Recorre un arxiu (0(log n)) i crida a insereix artista (0(log2 n))
+    void afegeixArtistes(string filename); // Recorre un arxiu mapejat (0(n)) i insereix cada artista (0(log2 n))
+    void afegeixArtistesParallel(const list<string>& fitxers, unsigned fils = 0); // Llegeix en paral·lel; si l'arbre és buit el construeix de cop (0(n log n))
+    void afegeixTrossos(vector<TrosArtistes>& trossos); // Insereix artistes ja llegits, com afegeixArtistesParallel
+    EstadistiquesEtapes afegeixArtistesEtapes(const list<string>& fitxers, const ConfiguracioEtapes& c = ConfiguracioEtapes()); // lectura, anàlisi i inserció a la vegada
+    const IndexosArtistes& indexosArtistes() const;
     void insereixArtista(int ArtistaID, string name, string gender, string country,
     string styles, int counts); // Crida a insereix -> 0(log2 n) 
-    string mostrarArtista(int ArtistaID)const; // 0(n) -> mostra cada artista
+    string mostrarArtista(int ArtistaID)const; // 0(log n), amb la cache de consultes
+    bool mostrarArtista(int ArtistaID, string& sortida)const; // 0(log n), afegeix la línia a sortida sense strings temporals
     bool buscarArtista(int ArtistaID); //0(n)
-    int buscarRecompteArtistes(int playcount);
+    int buscarRecompteArtistes(int playcount); // 0(log n) amb l'índex de playcount
+    int buscarRecompteArtistes(int minim, int maxim); // 0(log n)
+    list<int> obtenirArtistesPerPlaycount(int minim, int maxim); // 0(log n + k)
+    void activaArbreRangs(); // 0(n log n), arbre k-d de (id, playcount) per les consultes dels dos rangs
+    int buscarRecompteArtistes(int idMinim, int idMaxim, int minim, int maxim); // 0(sqrt n) amb l'arbre k-d, 0(n) sense
+    list<int> obtenirArtistesPerIdIPlaycount(int idMinim, int idMaxim, int minim, int maxim); // 0(sqrt n + k log k)
+    bool actualitzaPlaycount(int ArtistaID, int playcount); // 0(log n)
+    EstadistiquesIngesta aplicaReproduccions(vector<EventReproduccio>& events); // 0(e log e + d log n), d artistes diferents
+    size_t activaRegistre(const string& cami, unsigned intervalMs = 2); // reprodueix instantània + registre
+    void sincronitzaRegistre(); // espera el proper group commit
+    void compactaRegistre(); // 0(n) escriu una instantània i buida el registre
+    EstadistiquesRegistre estadistiquesRegistre() const;
+    void escriuMagatzem(const string& cami, size_t midaBloc = MagatzemArtistes::MIDA_BLOC) const; // 0(n)
+    void obreMagatzem(const string& cami, size_t blocsCache = 256); // zona freda en disc
+    list<int> obtenirArtistesPerId(int minim, int maxim) const; // 0(log n + k) més els blocs del rang
+    vector<int> obtenirIds() const; // 0(n), ids de l'arbre i del magatzem ordenats
+    EstadistiquesMagatzem estadistiquesMagatzem() const;
+    void activaConjuntIds(); // 0(n), ids en Elias-Fano: 2 + log(U/n) bits per id
+    const ConjuntEliasFano* conjuntIds() const; // nul si no està activat
+    list<int> obtenirPaginaIds(size_t pagina, size_t mida) const; // 0(1 + mida) amb el conjunt Elias-Fano, 0(n) sense
+    list<int> obtenirIdsDesDe(int primer, size_t mida) const; // 0(1 + mida) amb el conjunt Elias-Fano, 0(n) sense
+    void activaFiltreBloom(double falsPositius = 0.01, size_t capacitat = 0); // 0(n), les cerques d'ids absents miren una línia de cache
+    EstadistiquesBloom estadistiquesBloom() const;
     int height() const;
-    list<int> obtenirArtistesPerEstil(const string estil);
+    list<int> obtenirArtistesPerEstil(const string estil); // 0(k) amb l'índex d'estils
+    list<int> obtenirArtistesPerEstils(const list<string>& totes, const list<string>& algun, const list<string>& cap);
+    list<int> buscarArtistesPerNom(const string& nom); // 0(m) amb el trie de noms
+    list<int> autocompletaNom(const string& prefix, int k); // els k amb més playcount
+    list<int> buscarArtistesPerNomAproximat(const string& nom, int distancia, int k); // els k més semblants, 0(d) per node visitat del trie
+    int comptaArtistes(const FiltreArtistes& filtre, unsigned fils = 1); // 0(n / fils) amb la taula per columnes
+    list<int> obtenirArtistes(const FiltreArtistes& filtre, unsigned fils = 1); // amb el pla de PlanificadorConsultes
+    list<int> obtenirArtistesSenseIndex(const FiltreArtistes& filtre); // 0(n) recorrent l'arbre
+    list<int> obtenirArtistesPerText(const FiltreText& filtre); // 0(bytes dels camps) amb un autòmat per tots els patrons
+    string explicaConsulta(const FiltreArtistes& filtre) const;
+    long long sumaPlaycount(const FiltreArtistes& filtre, unsigned fils = 1);
+    list<int> topArtistes(int k, const FiltreArtistes& filtre = FiltreArtistes(), unsigned fils = 1); // 0(k + log n) sense filtres, 0(n log k / fils) amb filtres
+    list<GrupArtistes> agrupaArtistes(unsigned camps, const FiltreArtistes& filtre = FiltreArtistes(), unsigned fils = 1); // 0(n / fils + g log g)
+    void configuraCache(size_t maxEntrades, size_t maxBytes = SIZE_MAX);
+    EstadistiquesCache estadistiquesCache() const;
     
     void imprimirOrdenat()const;
 
  private:
     void mostrarArtistesInordreAux(NodeTree<int,Artist>* n, int &counter);
-    void auxRecompte(NodeTree<int, Artist>* n, int& num, int playcount);
-    void auxEstil(NodeTree<int, Artist>* n, string estil, list<int>& llista);
+    void auxArtistesInordre(NodeTree<int, Artist>* n, vector<const Artist*>& artistes) const;
+    void auxIdsRang(NodeTree<int, Artist>* n, int minim, int maxim, list<int>& ids) const;
+    void auxIds(NodeTree<int, Artist>* n, vector<int>& ids) const;
+    bool potExistir(int ArtistID) const;
+    void afegeixAlFiltre(int ArtistID);
+    void reconstrueixFiltre(size_t capacitat);
     void auxImprimirOrdenat(NodeTree<int,Artist>* n, int num) const;
+    void insereixFila(const FilaArtista& fila);
+    void insereixTros(TrosArtistes& tros);
+
+    IndexosArtistes indexos;
+    mutable CacheLRU<int, string> cacheMostrar; // artistId -> text de mostrarArtista
+    unique_ptr<RegistreEscriptura> registre; // nul si el registre no està activat
+    string camiRegistre;
+    unique_ptr<MagatzemArtistes> magatzem; // zona freda en disc, nul si no n'hi ha
+    unique_ptr<FiltreBloom> filtreBloom; // ids de l'arbre i del magatzem, nul si no està activat
+    size_t reconstruccionsBloom = 0;
+    unique_ptr<ConjuntEliasFano> idsEliasFano; // ids de l'arbre i del magatzem, nul si no està activat o si s'ha afegit algun id
+
+    void invalidaCache(const Artist& a);
+    void auxFiltre(NodeTree<int, Artist>* n, const FiltreArtistes& filtre, list<int>& llista) const;
+    void auxText(NodeTree<int, Artist>* n, const CercaText& cerca, list<int>& llista) const;
 };
 
 /**
  * Constructor sense paràmetres de la class CercadorArtistesAVL
 */
-CercadorArtistesAVL::CercadorArtistesAVL():ABT<int, Artist>() {}
+CercadorArtistesAVL::CercadorArtistesAVL():ABT<int, Artist>() {
+    indexos.afegeixObservador([this](const Artist& a) { invalidaCache(a); });
+    indexos.afegeixObservador([this](const Artist& a) { if (filtreBloom) afegeixAlFiltre(a.getArtistId()); });
+    indexos.afegeixObservador([this](const Artist& a) { if (idsEliasFano && !idsEliasFano->conte(a.getArtistId())) idsEliasFano.reset(); });
+}
+
+/**
+ * Invalida el text de la cache d'un artista afegit o modificat
+*/
+void CercadorArtistesAVL::invalidaCache(const Artist& a){
+    // Durant les càrregues la cache sol ser buida: no cal bloquejar-la
+    if (cacheMostrar.teEntrades()) cacheMostrar.invalida(a.getArtistId());
+}
+
+/**
+ * Canvia la mida màxima de la cache de mostrarArtista (0 entrades la desactiva)
+*/
+void CercadorArtistesAVL::configuraCache(size_t maxEntrades, size_t maxBytes){
+    cacheMostrar.configura(maxEntrades, maxBytes);
+}
+
+/**
+ * Encerts, errades i ocupació de la cache de mostrarArtista
+ * @return EstadistiquesCache estadístiques
+*/
+EstadistiquesCache CercadorArtistesAVL::estadistiquesCache() const{
+    return cacheMostrar.estadistiques();
+}
 
 /**
  * Insereix l'artista cridant a la funció d'insereix de l'arbre AVL
@@ -43,47 +146,136 @@ CercadorArtistesAVL::CercadorArtistesAVL():ABT<int, Artist>() {}
 void CercadorArtistesAVL::insereixArtista(int ArtistID, string name, string gender, string country, string styles, int counts){
     Artist a(ArtistID, name, gender, country, styles, counts);
     ABT<int,Artist>::insereixAVL(ArtistID, a);
+    indexos.afegeix(a);
+    if (registre) registre->registraArtista(a);
 }
 
 /**
- * Afageix els artistes des d'un arxiu
+ * Afageix els artistes des d'un arxiu. El fitxer es mapeja a memòria i cada fila
+ * es converteix directament en un Artist dins de l'arbre, sense strings temporals.
 */
 void CercadorArtistesAVL::afegeixArtistes(std::string filename) {
-        std::ifstream fitxer(filename);
-        if (!fitxer.is_open()) {
-            std::cerr << "Error: Unable to open file " << filename << std::endl;
-        }
+    LectorCSV lector(filename);
+    if (!lector.obert()) {
+        std::cerr << "Error: Unable to open file " << filename << std::endl;
+        return;
+    }
+    lector.perCadaFila([this](const FilaArtista& fila) { insereixFila(fila); });
+}
 
-        std::string line, header;
-        getline(fitxer,header,'\n');
-        while (std::getline(fitxer, line)) {
-            if (line.empty()) {
-                continue; 
-            }
+/**
+ * Insereix una fila llegida d'un fitxer movent l'artista dins del node de l'arbre
+*/
+void CercadorArtistesAVL::insereixFila(const FilaArtista& fila){
+    NodeTree<int, Artist>* n = ABT<int,Artist>::insereixAVL(fila.artistId, artistaDeFila(fila));
+    indexos.afegeix(n->getValue());
+}
 
-            std::istringstream ss(line);
-            string id, name, gender, country, styles, playcount;
+/**
+ * Afegeix els artistes de diversos fitxers llegint-los en paral·lel amb un pool de fils.
+ * Si l'arbre és buit i no hi ha identificadors repetits, s'ordena i es construeix l'arbre equilibrat de cop.
+ * Si no, s'insereixen en l'ordre dels fitxers i un identificador repetit llança el mateix error que afegeixArtistes.
+*/
+void CercadorArtistesAVL::afegeixArtistesParallel(const list<string>& fitxers, unsigned fils){
+    PoolFils pool(fils);
+    vector<TrosArtistes> trossos = llegeixArtistesParallel(fitxers, pool);
+    afegeixTrossos(trossos);
+}
 
-            std::getline(ss, id, ',');
-            std::getline(ss, name, ',');
-            std::getline(ss, gender, ',');
-            std::getline(ss, country, ',');
-            std::getline(ss, styles, ',');
-            std::getline(ss, playcount, '\n');
+/**
+ * Insereix els artistes de trossos ja llegits (es mouen dins dels nodes). Si l'arbre és buit i no hi ha
+ * identificadors repetits, es construeix l'arbre equilibrat de cop. L'error d'un tros es llança després
+ * d'inserir els artistes dels trossos anteriors
+*/
+void CercadorArtistesAVL::afegeixTrossos(vector<TrosArtistes>& trossos){
+    bool senseErrors = true;
+    vector<int> claus;
+    for (const TrosArtistes& tros : trossos) {
+        if (tros.error) senseErrors = false;
+        for (const Artist& a : tros.artistes) claus.push_back(a.getArtistId());
+    }
+    if (this->buida() && senseErrors) {
+        sort(claus.begin(), claus.end());
+        if (adjacent_find(claus.begin(), claus.end()) == claus.end()) {
+            vector<pair<int, Artist>> elements;
+            elements.reserve(claus.size());
+            for (TrosArtistes& tros : trossos) {
+                for (Artist& a : tros.artistes) elements.emplace_back(a.getArtistId(), std::move(a));
+            }
+            sort(elements.begin(), elements.end(), [](const pair<int, Artist>& a, const pair<int, Artist>& b) {
+                return a.first < b.first;
+            });
+            this->construeixOrdenat(elements);
 
-            int artistID = stoi(id), artistPlaycount = stoi(playcount);
-            insereixArtista(artistID, name, gender, country, styles, artistPlaycount);
-        
+            vector<const Artist*> artistes;
+            artistes.reserve(claus.size());
+            auxArtistesInordre(this->arrel, artistes);
+            indexos.afegeixLot(artistes);
+            return;
         }
-        fitxer.close();
     }
 
+    for (TrosArtistes& tros : trossos) insereixTros(tros);
+}
+
+/**
+ * Insereix els artistes d'un tros en ordre (es mouen dins dels nodes) i després llança l'error del tros si en té
+*/
+void CercadorArtistesAVL::insereixTros(TrosArtistes& tros){
+    for (Artist& a : tros.artistes) {
+        int id = a.getArtistId();
+        NodeTree<int, Artist>* n = ABT<int,Artist>::insereixAVL(id, std::move(a));
+        indexos.afegeix(n->getValue());
+    }
+    if (tros.error) rethrow_exception(tros.error);
+}
+
+/**
+ * Afegeix els artistes de diversos fitxers amb CarregadorEtapes: un fil llegeix els blocs (amb io_uring
+ * si es pot), un altre els converteix en artistes i aquest fil els insereix a mesura que arriben.
+ * Insereix en el mateix ordre i amb els mateixos errors que afegeixArtistes
+ * @return EstadistiquesEtapes temps i ocupació de cada etapa
+*/
+EstadistiquesEtapes CercadorArtistesAVL::afegeixArtistesEtapes(const list<string>& fitxers, const ConfiguracioEtapes& c){
+    return carregaPerEtapes(fitxers, [this](TrosArtistes& tros) { insereixTros(tros); }, c);
+}
+
 /**
  * Mostrar l'artista
  * @return string amb la info del artista
  * */                                                   
 string CercadorArtistesAVL::mostrarArtista(int ArtistID)const{
-    return (cercar(ArtistID)? ArtistID + "::" + this->valorDe(ArtistID).toString() + "\n" : "No s'a trobat l'artista");
+    string text;
+    if (cacheMostrar.obte(ArtistID, text)) return text;
+    if (!potExistir(ArtistID)) return "No s'a trobat l'artista";
+    NodeTree<int, Artist>* node = cercar(ArtistID);
+    if (node == nullptr) {
+        if (magatzem && magatzem->mostrarArtista(ArtistID, text)) return text;
+        if (filtreBloom) filtreBloom->anotaFalsPositiu();
+        return "No s'a trobat l'artista";
+    }
+    text.reserve(node->getValue().midaFormat() + 12);
+    node->getValue().formatAmbIdTo(text);
+    text += '\n';
+    cacheMostrar.posa(ArtistID, text, text.size());
+    return text;
+}
+
+/**
+ * Afegeix la línia de mostrarArtista al final de sortida, sense passar per la cache ni crear cap string
+ * (si sortida ja té prou capacitat). Per respondre moltes consultes amb una sola memòria intermèdia
+ * @return bool si existeix l'artista
+*/
+bool CercadorArtistesAVL::mostrarArtista(int ArtistID, string& sortida)const{
+    NodeTree<int, Artist>* node = potExistir(ArtistID) ? cercar(ArtistID) : nullptr;
+    if (node == nullptr) {
+        bool trobat = magatzem && magatzem->mostrarArtista(ArtistID, sortida);
+        if (filtreBloom && !trobat) filtreBloom->anotaFalsPositiu();
+        return trobat;
+    }
+    node->getValue().formatAmbIdTo(sortida);
+    sortida += '\n';
+    return true;
 }
 
 /**
@@ -91,31 +283,349 @@ string CercadorArtistesAVL::mostrarArtista(int ArtistID)const{
  * @return bool si exixteix l'artista
 */
 bool CercadorArtistesAVL::buscarArtista(int ArtistID){
+    if (idsEliasFano) return idsEliasFano->conte(ArtistID);
+    if (!potExistir(ArtistID)) return false;
     NodeTree<int, Artist>* node = cercar(ArtistID);
     if (node == nullptr) {
-        return false;
+        bool trobat = magatzem && magatzem->buscarArtista(ArtistID);
+        if (filtreBloom && !trobat) filtreBloom->anotaFalsPositiu();
+        return trobat;
     }
     return true;
 }
 /**
- * Busca el recompte d'artistes amb un recompte major o igual
+ * Busca el recompte d'artistes amb un recompte major o igual, amb l'índex de playcount en O(log n)
  * @return recompte d'artistes
 */
 int CercadorArtistesAVL::buscarRecompteArtistes(int playcount){
-    int num = 0;
-    auxRecompte(this->arrel, num, playcount);
-    return num;
+    return static_cast<int>(indexos.comptaPlaycount(playcount));
+}
+
+/**
+ * Busca el recompte d'artistes amb un recompte dins de [minim, maxim] en O(log n)
+ * @return recompte d'artistes
+*/
+int CercadorArtistesAVL::buscarRecompteArtistes(int minim, int maxim){
+    return static_cast<int>(indexos.comptaPlaycount(minim, maxim));
+}
+
+/**
+ * Obté els artistes amb un recompte dins de [minim, maxim], de menys a més reproduccions
+ * @return list<int> amb els identificadors dels artistes
+*/
+list<int> CercadorArtistesAVL::obtenirArtistesPerPlaycount(int minim, int maxim){
+    list<int> llista;
+    indexos.recorrePlaycount(minim, maxim, [&llista](int id, int) { llista.push_back(id); });
+    return llista;
+}
+
+/**
+ * Construeix l'arbre k-d de (id, playcount) dels índexs. Des d'aleshores es manté amb les insercions i
+ * els canvis de playcount, i les consultes per rang d'id i de playcount no recorren tots els artistes
+*/
+void CercadorArtistesAVL::activaArbreRangs(){
+    indexos.activaArbreRangs();
+}
+
+/**
+ * Busca el recompte d'artistes amb l'id dins de [idMinim, idMaxim] i el recompte dins de [minim, maxim]
+ * @return recompte d'artistes
+*/
+int CercadorArtistesAVL::buscarRecompteArtistes(int idMinim, int idMaxim, int minim, int maxim){
+    return static_cast<int>(indexos.comptaRang(idMinim, idMaxim, minim, maxim));
+}
+
+/**
+ * Obté els artistes amb l'id dins de [idMinim, idMaxim] i el recompte dins de [minim, maxim]
+ * @return list<int> amb els identificadors ordenats
+*/
+list<int> CercadorArtistesAVL::obtenirArtistesPerIdIPlaycount(int idMinim, int idMaxim, int minim, int maxim){
+    vector<int> ids;
+    indexos.recorreRang(idMinim, idMaxim, minim, maxim, [&ids](int id, int) { ids.push_back(id); });
+    sort(ids.begin(), ids.end());
+    return list<int>(ids.begin(), ids.end());
+}
+
+/**
+ * Canvia el playcount d'un artista i actualitza l'índex de playcount
+ * @return bool si existeix l'artista
+*/
+bool CercadorArtistesAVL::actualitzaPlaycount(int ArtistID, int playcount){
+    if (!potExistir(ArtistID)) return false;
+    NodeTree<int, Artist>* node = cercar(ArtistID);
+    if (node == nullptr) return false;
+    Artist& a = node->valorModificable();
+    indexos.canviaPlaycount(a, playcount);
+    a.setPlaycount(playcount);
+    if (registre) registre->registraPlaycount(a.getArtistId(), playcount);
+    return true;
+}
+
+/**
+ * Aplica un lot d'events de reproducció (artistId, +delta). El lot s'ordena per artistId i s'ajunten
+ * els events del mateix artista, així cada artista es busca i s'actualitza (amb els seus índexs) un sol cop.
+ * El playcount es manté dins de [0, INT_MAX]. Els events d'artistes que no existeixen s'ignoren
+ * @return EstadistiquesIngesta artistes actualitzats i desconeguts
+*/
+EstadistiquesIngesta CercadorArtistesAVL::aplicaReproduccions(vector<EventReproduccio>& events){
+    EstadistiquesIngesta e;
+    e.events = events.size();
+    e.lots = 1;
+    compactaEvents(events);
+    for (const EventReproduccio& ev : events) {
+        NodeTree<int, Artist>* node = potExistir(ev.artistId) ? cercar(ev.artistId) : nullptr;
+        if (node == nullptr) {
+            e.desconeguts++;
+            continue;
+        }
+        Artist& a = node->valorModificable();
+        int nou = sumaSaturada(a.getPlaycount(), ev.delta);
+        if (nou == a.getPlaycount()) continue;
+        indexos.canviaPlaycount(a, nou);
+        a.setPlaycount(nou);
+        if (registre) registre->registraPlaycount(a.getArtistId(), nou);
+        e.actualitzats++;
+    }
+    return e;
+}
+
+/**
+ * Activa el registre d'escriptura anticipada a cami: primer reprodueix la instantània (cami + ".snap")
+ * i el registre a sobre dels artistes carregats, i després registra cada insereixArtista i cada canvi
+ * de playcount. intervalMs és cada quant l'escriptor fa durables els registres (group commit)
+ * @return size_t registres reproduïts
+*/
+size_t CercadorArtistesAVL::activaRegistre(const string& cami, unsigned intervalMs){
+    registre.reset();
+    size_t reproduits = recuperaRegistre(*this, cami);
+    registre.reset(new RegistreEscriptura(cami, intervalMs));
+    camiRegistre = cami;
+    return reproduits;
+}
+
+/**
+ * Espera que tots els canvis registrats siguin al disc
+*/
+void CercadorArtistesAVL::sincronitzaRegistre(){
+    if (registre) registre->sincronitza();
+}
+
+/**
+ * Compacta el registre: escriu una instantània amb tots els artistes i buida el registre
+*/
+void CercadorArtistesAVL::compactaRegistre(){
+    if (!registre) throw logic_error("El registre no està activat\n");
+    vector<const Artist*> artistes;
+    auxArtistesInordre(this->arrel, artistes);
+    registre->sincronitza();
+    RegistreEscriptura::escriuInstantania(camiRegistre + ".snap", artistes);
+    registre->buida();
+}
+
+EstadistiquesRegistre CercadorArtistesAVL::estadistiquesRegistre() const{
+    return registre ? registre->estadistiques() : EstadistiquesRegistre();
+}
+
+/**
+ * Escriu tots els artistes de l'arbre en un magatzem en disc (MagatzemArtistes) amb blocs de midaBloc bytes
+*/
+void CercadorArtistesAVL::escriuMagatzem(const string& cami, size_t midaBloc) const{
+    vector<const Artist*> artistes;
+    auxArtistesInordre(this->arrel, artistes);
+    MagatzemArtistes::escriu(cami, artistes, midaBloc);
+}
+
+/**
+ * Obre un magatzem en disc com a zona freda de només lectura: buscarArtista, mostrarArtista i
+ * obtenirArtistesPerId també hi busquen els artistes que no són a l'arbre. La resta de consultes
+ * (filtres, recomptes, estils, noms, text i rangs) només veuen els artistes de l'arbre
+*/
+void CercadorArtistesAVL::obreMagatzem(const string& cami, size_t blocsCache){
+    magatzem.reset(new MagatzemArtistes(cami, blocsCache));
+    cacheMostrar.buida();
+    if (filtreBloom) reconstrueixFiltre(max(filtreBloom->capacitat(), indexos.mida() + magatzem->mida()));
+    if (idsEliasFano) activaConjuntIds();
+}
+
+/**
+ * Obté els artistes amb identificador dins de [minim, maxim], de l'arbre i del magatzem en disc
+ * @return list<int> identificadors ordenats sense repetits
+*/
+list<int> CercadorArtistesAVL::obtenirArtistesPerId(int minim, int maxim) const{
+    list<int> ids;
+    auxIdsRang(this->arrel, minim, maxim, ids);
+    if (magatzem) {
+        list<int> freds = magatzem->obtenirArtistes(minim, maxim);
+        ids.merge(freds);
+        ids.unique();
+    }
+    return ids;
+}
+
+/**
+ * Auxiliar que recorre en inordre només els subarbres que poden tenir claus dins de [minim, maxim]
+*/
+void CercadorArtistesAVL::auxIdsRang(NodeTree<int, Artist>* n, int minim, int maxim, list<int>& ids) const{
+    if (n == nullptr) return;
+    if (minim < n->getKey()) auxIdsRang(n->getLeft(), minim, maxim, ids);
+    if (n->getKey() >= minim && n->getKey() <= maxim) ids.push_back(n->getKey());
+    if (n->getKey() < maxim) auxIdsRang(n->getRight(), minim, maxim, ids);
+}
+
+/**
+ * Obté tots els ids, de l'arbre i del magatzem en disc, en un vector reservat d'entrada
+ * @return vector<int> identificadors ordenats sense repetits
+*/
+vector<int> CercadorArtistesAVL::obtenirIds() const{
+    vector<int> ids;
+    ids.reserve(indexos.mida() + (magatzem ? magatzem->mida() : 0));
+    auxIds(this->arrel, ids);
+    if (magatzem) {
+        size_t arbre = ids.size();
+        magatzem->recorreIds(INT_MIN, INT_MAX, [&ids](int id) { ids.push_back(id); });
+        inplace_merge(ids.begin(), ids.begin() + arbre, ids.end());
+        ids.erase(unique(ids.begin(), ids.end()), ids.end());
+    }
+    return ids;
+}
+
+/**
+ * Auxiliar que afegeix els ids de l'arbre en inordre
+*/
+void CercadorArtistesAVL::auxIds(NodeTree<int, Artist>* n, vector<int>& ids) const{
+    if (n == nullptr) return;
+    auxIds(n->getLeft(), ids);
+    ids.push_back(n->getKey());
+    auxIds(n->getRight(), ids);
+}
+
+/**
+ * Índexs secundaris del cercador, per consultar-los sense copiar els resultats en una llista
+ * @return const IndexosArtistes& índexs
+*/
+const IndexosArtistes& CercadorArtistesAVL::indexosArtistes() const{
+    return indexos;
+}
+
+/**
+ * Codifica els ids de l'arbre (en inordre) i del magatzem en un conjunt Elias-Fano. Des d'aleshores
+ * buscarArtista, obtenirPaginaIds i obtenirIdsDesDe no recorren l'arbre. Està pensat per còpies de
+ * només lectura: si s'afegeix un artista el conjunt es descarta i es torna a fer servir l'arbre.
+ * El conjunt s'afegeix a l'arbre i als índexs, així que la memòria del cercador creix: una rèplica que
+ * només guarda els ids, sense l'arbre, és ReplicaIds
+*/
+void CercadorArtistesAVL::activaConjuntIds(){
+    idsEliasFano.reset(new ConjuntEliasFano(obtenirIds()));
+}
+
+const ConjuntEliasFano* CercadorArtistesAVL::conjuntIds() const{
+    return idsEliasFano.get();
+}
+
+/**
+ * Obté la pàgina número pagina (des de 0) dels ids ordenats, amb mida ids per pàgina
+ * @return list<int> identificadors ordenats
+*/
+list<int> CercadorArtistesAVL::obtenirPaginaIds(size_t pagina, size_t mida) const{
+    list<int> ids;
+    if (mida == 0) return ids;
+    if (idsEliasFano) {
+        idsEliasFano->recorre(pagina * mida, [&ids, mida](int id) { ids.push_back(id); return ids.size() < mida; });
+        return ids;
+    }
+    ids = obtenirArtistesPerId(INT_MIN, INT_MAX);
+    if (pagina * mida >= ids.size()) return list<int>();
+    ids.erase(ids.begin(), next(ids.begin(), pagina * mida));
+    if (ids.size() > mida) ids.erase(next(ids.begin(), mida), ids.end());
+    return ids;
+}
+
+/**
+ * Obté els mida primers ids més grans o iguals que primer (paginació per clau)
+ * @return list<int> identificadors ordenats
+*/
+list<int> CercadorArtistesAVL::obtenirIdsDesDe(int primer, size_t mida) const{
+    list<int> ids;
+    if (mida == 0) return ids;
+    if (idsEliasFano) {
+        idsEliasFano->recorre(idsEliasFano->comptaMenors(primer), [&ids, mida](int id) { ids.push_back(id); return ids.size() < mida; });
+        return ids;
+    }
+    ids = obtenirArtistesPerId(primer, INT_MAX);
+    if (ids.size() > mida) ids.erase(next(ids.begin(), mida), ids.end());
+    return ids;
+}
+
+EstadistiquesMagatzem CercadorArtistesAVL::estadistiquesMagatzem() const{
+    return magatzem ? magatzem->estadistiques() : EstadistiquesMagatzem();
 }
 
 /**
- * Auxiliar void a buscarRecompteArtistes
+ * Activa un filtre de Bloom per blocs davant de l'arbre: buscarArtista, mostrarArtista i les
+ * actualitzacions de playcount d'ids que no existeixen acaben després de mirar una sola línia de cache.
+ * El filtre es construeix amb els artistes de l'arbre i del magatzem, i cada artista afegit després
+ * (també durant la càrrega) s'hi afegeix. Si supera la capacitat, es reconstrueix amb el doble
+ * @param falsPositius taxa de falsos positius desitjada
+ * @param capacitat artistes esperats (0: els que hi ha ara)
 */
-void CercadorArtistesAVL::auxRecompte(NodeTree<int, Artist>* n, int& num, int playcount){
-    if (n->getValue().getPlaycount() >= playcount){
-        num++;
+void CercadorArtistesAVL::activaFiltreBloom(double falsPositius, size_t capacitat){
+    size_t artistes = indexos.mida() + (magatzem ? magatzem->mida() : 0);
+    filtreBloom.reset(new FiltreBloom(max<size_t>({capacitat, artistes, 1024}), falsPositius));
+    reconstruccionsBloom = 0;
+    reconstrueixFiltre(filtreBloom->capacitat());
+}
+
+/**
+ * Mida, ocupació i efectivitat del filtre de Bloom (consultes descartades i falsos positius observats)
+ * @return EstadistiquesBloom estadístiques
+*/
+EstadistiquesBloom CercadorArtistesAVL::estadistiquesBloom() const{
+    if (!filtreBloom) return EstadistiquesBloom();
+    EstadistiquesBloom e = filtreBloom->estadistiques();
+    e.reconstruccions = reconstruccionsBloom;
+    return e;
+}
+
+/**
+ * Consulta el filtre de Bloom
+ * @return bool fals si segur que l'artista no existeix
+*/
+bool CercadorArtistesAVL::potExistir(int ArtistID) const{
+    return !filtreBloom || filtreBloom->potContenir(ArtistID);
+}
+
+/**
+ * Afegeix un id al filtre de Bloom i el reconstrueix amb el doble de capacitat si ja té massa claus
+*/
+void CercadorArtistesAVL::afegeixAlFiltre(int ArtistID){
+    if (filtreBloom->afegeix(ArtistID) && filtreBloom->claus() > filtreBloom->capacitat()) {
+        reconstrueixFiltre(2 * filtreBloom->capacitat());
+        reconstruccionsBloom++;
+    }
+}
+
+/**
+ * Torna a construir el filtre de Bloom amb tots els ids de l'arbre i del magatzem (les mètriques es reinicien)
+*/
+void CercadorArtistesAVL::reconstrueixFiltre(size_t capacitat){
+    unique_ptr<FiltreBloom> nou(new FiltreBloom(capacitat, filtreBloom->falsPositius()));
+    vector<const Artist*> artistes;
+    auxArtistesInordre(this->arrel, artistes);
+    for (const Artist* a : artistes) nou->afegeix(a->getArtistId());
+    if (magatzem) {
+        for (int id : magatzem->obtenirArtistes(INT_MIN, INT_MAX)) nou->afegeix(id);
     }
-    if (n->teEsquerra()) auxRecompte(n->getLeft(), num, playcount);
-    if (n->teDreta()) auxRecompte(n->getRight(), num, playcount);
+    filtreBloom = std::move(nou);
+}
+
+/**
+ * Auxiliar que recull els artistes de l'arbre en inordre
+*/
+void CercadorArtistesAVL::auxArtistesInordre(NodeTree<int, Artist>* n, vector<const Artist*>& artistes) const{
+    if (n == nullptr) return;
+    auxArtistesInordre(n->getLeft(), artistes);
+    artistes.push_back(&n->getValue());
+    auxArtistesInordre(n->getRight(), artistes);
 }
 
 /**
@@ -127,27 +637,157 @@ int CercadorArtistesAVL::height() const{
 }
 
 /**
- * Mètodes Obtenir artistes per estil
- * @return list<int> artistes amb l'estil entrat
+ * Mètodes Obtenir artistes per estil, amb l'índex invertit d'estils.
+ * Només es compten els artistes que tenen exactament aquest estil, no els que el contenen dins d'un altre.
+ * @return list<int> artistes amb l'estil entrat, ordenats per identificador
 */
 list<int> CercadorArtistesAVL::obtenirArtistesPerEstil(const string estil){
+    const vector<int>& ids = indexos.artistesPerEstil(estil);
+    return list<int>(ids.begin(), ids.end());
+}
+
+/**
+ * Obté els artistes que tenen tots els estils de "totes", algun dels de "algun" (si no és buida) i cap dels de "cap"
+ * @return list<int> artistes que compleixen la consulta, ordenats per identificador
+*/
+list<int> CercadorArtistesAVL::obtenirArtistesPerEstils(const list<string>& totes, const list<string>& algun, const list<string>& cap){
+    vector<int> ids = indexos.consultaEstils(totes, algun, cap);
+    return list<int>(ids.begin(), ids.end());
+}
+
+/**
+ * Busca els artistes pel nom, sense distingir majúscules ni accents
+ * @return list<int> artistes ordenats per identificador
+*/
+list<int> CercadorArtistesAVL::buscarArtistesPerNom(const string& nom){
+    vector<int> ids = indexos.artistesPerNom(nom);
+    return list<int>(ids.begin(), ids.end());
+}
+
+/**
+ * Autocompleta un nom: els k artistes amb més reproduccions dels noms que comencen pel prefix
+ * @return list<int> artistes de més a menys playcount
+*/
+list<int> CercadorArtistesAVL::autocompletaNom(const string& prefix, int k){
+    vector<int> ids = indexos.completaNom(prefix, k < 0 ? 0 : static_cast<size_t>(k));
+    return list<int>(ids.begin(), ids.end());
+}
+
+/**
+ * Busca els k artistes amb el nom més semblant, amb com a molt distancia lletres canviades,
+ * afegides o esborrades (sense distingir majúscules ni accents)
+ * @return list<int> artistes de menys a més distància, i a igual distància de més a menys playcount
+*/
+list<int> CercadorArtistesAVL::buscarArtistesPerNomAproximat(const string& nom, int distancia, int k){
+    if (distancia < 0 || k <= 0) return list<int>();
+    vector<int> ids = indexos.aproximaNom(nom, static_cast<unsigned>(distancia), static_cast<size_t>(k));
+    return list<int>(ids.begin(), ids.end());
+}
+
+/**
+ * Compta els artistes que compleixen un filtre de playcount, país, gènere i estils
+ * @return int nombre d'artistes
+*/
+int CercadorArtistesAVL::comptaArtistes(const FiltreArtistes& filtre, unsigned fils){
+    return static_cast<int>(indexos.compta(filtre, fils));
+}
+
+/**
+ * Obté els artistes que compleixen un filtre de playcount, país, gènere i estils
+ * @return list<int> artistes ordenats per identificador
+*/
+list<int> CercadorArtistesAVL::obtenirArtistes(const FiltreArtistes& filtre, unsigned fils){
+    vector<int> ids = PlanificadorConsultes(indexos).executa(filtre, fils);
+    return list<int>(ids.begin(), ids.end());
+}
+
+/**
+ * Explica com s'executaria un filtre: estratègia triada i estimacions de cada predicat
+ * @return string descripció del pla
+*/
+string CercadorArtistesAVL::explicaConsulta(const FiltreArtistes& filtre) const{
+    return PlanificadorConsultes(indexos).planifica(filtre).descripcio();
+}
+
+/**
+ * Obté els artistes que compleixen un filtre recorrent tot l'arbre, sense cap índex
+ * (per comparar amb el planificador)
+ * @return list<int> artistes ordenats per identificador
+*/
+list<int> CercadorArtistesAVL::obtenirArtistesSenseIndex(const FiltreArtistes& filtre){
     list<int> llista;
-    if(!this->buida()){
-        auxEstil(this->arrel, estil, llista);
-    }
+    auxFiltre(this->arrel, filtre, llista);
     return llista;
 }
 
-void CercadorArtistesAVL::auxEstil(NodeTree<int, Artist>* n, string estil, list<int>& llista){
-    if(n != nullptr){
-    if (n->getValue().getStyles().find("|"+estil) != std::string::npos
-        || n->getValue().getStyles().find(estil+",") != std::string::npos
-        || n->getValue().getStyles().find(estil+"|") != std::string::npos){
-        llista.push_back(n->getKey());
-    }
-    if (n->teEsquerra()) auxEstil(n->getLeft(), estil, llista);
-    if (n->teDreta()) auxEstil(n->getRight(), estil, llista);
+/**
+ * Obté els artistes que contenen algun (o tots) dels trossos de text del filtre als camps triats.
+ * Tots els patrons es busquen alhora amb un autòmat d'Aho-Corasick, així cada camp es llegeix un sol cop
+ * @return list<int> artistes ordenats per identificador
+*/
+list<int> CercadorArtistesAVL::obtenirArtistesPerText(const FiltreText& filtre){
+    CercaText cerca(filtre);
+    list<int> llista;
+    auxText(this->arrel, cerca, llista);
+    return llista;
+}
+
+/**
+ * Auxiliar que recorre l'arbre en inordre i comprova el filtre de text de cada artista
+*/
+void CercadorArtistesAVL::auxText(NodeTree<int, Artist>* n, const CercaText& cerca, list<int>& llista) const{
+    if (n == nullptr) return;
+    auxText(n->getLeft(), cerca, llista);
+    if (cerca.compleix(n->getValue())) llista.push_back(n->getKey());
+    auxText(n->getRight(), cerca, llista);
+}
+
+/**
+ * Auxiliar que recorre l'arbre en inordre i comprova tots els predicats del filtre
+*/
+void CercadorArtistesAVL::auxFiltre(NodeTree<int, Artist>* n, const FiltreArtistes& filtre, list<int>& llista) const{
+    if (n == nullptr) return;
+    auxFiltre(n->getLeft(), filtre, llista);
+    const Artist& a = n->getValue();
+    bool compleix = a.getPlaycount() >= filtre.minPlaycount && a.getPlaycount() <= filtre.maxPlaycount
+        && (filtre.pais.empty() || a.countryView() == filtre.pais)
+        && (filtre.genere.empty() || a.genderView() == filtre.genere);
+    for (list<string>::const_iterator it = filtre.estils.begin(); compleix && it != filtre.estils.end(); ++it) {
+        bool te = false;
+        IndexEstils::perCadaEstil(a.stylesView(), [&](string_view estil) { te = te || estil == *it; });
+        compleix = te;
     }
+    if (compleix) llista.push_back(a.getArtistId());
+    auxFiltre(n->getRight(), filtre, llista);
+}
+
+/**
+ * Suma les reproduccions dels artistes que compleixen un filtre
+ * @return long long suma de playcounts
+*/
+long long CercadorArtistesAVL::sumaPlaycount(const FiltreArtistes& filtre, unsigned fils){
+    return indexos.sumaPlaycount(filtre, fils);
+}
+
+/**
+ * Obté els k artistes amb més reproduccions que compleixen un filtre (per defecte, tots).
+ * Amb fils > 1 la taula es recorre en paral·lel i es fusionen els heaps de cada fil
+ * @return list<int> artistes de més a menys playcount
+*/
+list<int> CercadorArtistesAVL::topArtistes(int k, const FiltreArtistes& filtre, unsigned fils){
+    vector<int> ids = indexos.top(filtre, k < 0 ? 0 : static_cast<size_t>(k), fils);
+    return list<int>(ids.begin(), ids.end());
+}
+
+/**
+ * Agrupa els artistes que compleixen un filtre per país, gènere i/o estil (AGRUPA_PAIS | AGRUPA_GENERE | AGRUPA_ESTIL)
+ * amb el recompte, la suma, el mínim, el màxim i la mitjana del playcount de cada grup.
+ * Amb fils > 1 cada fil agrega un tros de la taula i al final es fusionen els grups
+ * @return list<GrupArtistes> grups ordenats per país, gènere i estil
+*/
+list<GrupArtistes> CercadorArtistesAVL::agrupaArtistes(unsigned camps, const FiltreArtistes& filtre, unsigned fils){
+    vector<GrupArtistes> grups = indexos.agrupa(filtre, camps, fils);
+    return list<GrupArtistes>(grups.begin(), grups.end());
 }
 
 /**
@@ -174,4 +814,6 @@ void CercadorArtistesAVL::auxImprimirOrdenat(NodeTree<int,Artist>* n, int num) c
     if (n->teDreta()){
         auxImprimirOrdenat(n->getRight(), num);
     }
-}
\ No newline at end of file
+}
+
+#endif /* CERCADORARTISTESAVL_H */
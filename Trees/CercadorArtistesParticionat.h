@@ -0,0 +1,509 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Sharded search engine (Cercador d'artistes particionat).
+ * The artists are split into N independent search engines (particions, shards), each one with its
+ * own tree, indexes and lock, by id range (PER_RANG) or by a hash of the id (PER_HASH).
+ * - The operations of one artist (insert, search, show, change the playcount) go to its shard only,
+ *   so threads working on different shards never wait for each other.
+ * - The queries over many artists (styles, playcount ranges, filters, top, id ranges) are sent to
+ *   all the shards in parallel with a PoolFils, and the results of every shard are merged with a
+ *   k-way merge on a heap, so they come out in the same order as with a single search engine.
+ * With PER_RANG the limits of the shards are the quantiles of the ids of the first load (into empty
+ * shards), so every shard gets the same number of artists; the ids inserted before that go to the
+ * shards of an even split of [0, INT_MAX]. The id range queries only ask the shards of the range.
+ * With PER_HASH the shards are balanced whatever the ids are, but every query asks all the shards.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - Operations of one artist: O(log(n / N)) plus choosing the shard (O(1) by hash, O(log N) by range).
+ * - Queries over many artists: the query of every shard in parallel, plus O(k log N) to merge k results
+ *   (O(k) when the shards are by range and the results are ordered by id).
+ * - afegeixArtistes: reading in parallel, O(n) to split the artists, and building every shard in parallel.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * particions : The shards, each one with its search engine and its mutex (a cache line apart).
+ * tipus : PER_RANG or PER_HASH.
+ * limits : With PER_RANG, the first id of the shards 1..N-1.
+ * mtxLimits : Protects limits. The operations that choose a shard by id hold it shared until they finish;
+ *             afegeixArtistes holds it exclusive while it sets the limits and splits and builds the
+ *             shards, so no operation can use the old limits while they change.
+ * pool : Threads that run the queries of the shards.
+ *
+ * ################################################
+ */
+
+#ifndef CERCADORARTISTESPARTICIONAT_H
+#define CERCADORARTISTESPARTICIONAT_H
+#include "CercadorArtistesAVL.h"
+#include "CarregadorArtistes.h"
+#include "IngestaEvents.h"
+#include "PoolFils.h"
+#include <vector>
+#include <list>
+#include <queue>
+#include <mutex>
+#include <shared_mutex>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * Fusiona k seqüències ordenades amb un heap dels primers elements de cada una (k-way merge) i crida
+ * a f(element) en ordre fins que f retorna false. menor(a, b) és l'ordre de les seqüències
+*/
+template <class T, class Menor, class F>
+void fusionaOrdenades(const vector<vector<T>>& sequencies, Menor menor, F f) {
+    typedef pair<size_t, size_t> Posicio; // (seqüència, posició)
+    auto despres = [&](const Posicio& a, const Posicio& b) {
+        return menor(sequencies[b.first][b.second], sequencies[a.first][a.second]);
+    };
+    priority_queue<Posicio, vector<Posicio>, decltype(despres)> heap(despres);
+    for (size_t s = 0; s < sequencies.size(); s++) {
+        if (!sequencies[s].empty()) heap.push(Posicio(s, 0));
+    }
+    while (!heap.empty()) {
+        Posicio p = heap.top();
+        heap.pop();
+        if (!f(sequencies[p.first][p.second])) return;
+        if (++p.second < sequencies[p.first].size()) heap.push(p);
+    }
+}
+
+template <class Cercador = CercadorArtistesAVL>
+class CercadorArtistesParticionat {
+public:
+    enum Particionament { PER_RANG, PER_HASH };
+
+    explicit CercadorArtistesParticionat(unsigned particions = 0, Particionament tipus = PER_RANG, unsigned fils = 0);
+    CercadorArtistesParticionat(const CercadorArtistesParticionat&) = delete;
+    CercadorArtistesParticionat& operator=(const CercadorArtistesParticionat&) = delete;
+
+    void afegeixArtistes(const list<string>& fitxers); // Llegeix en paral·lel i construeix les particions en paral·lel
+    void insereixArtista(int ArtistaID, string name, string gender, string country, string styles, int counts);
+    string mostrarArtista(int ArtistaID) const;
+    bool mostrarArtista(int ArtistaID, string& sortida) const;
+    bool buscarArtista(int ArtistaID);
+    bool actualitzaPlaycount(int ArtistaID, int playcount);
+    EstadistiquesIngesta aplicaReproduccions(vector<EventReproduccio>& events); // cada partició aplica els seus events en paral·lel
+
+    int buscarRecompteArtistes(int minim, int maxim);
+    list<int> obtenirArtistesPerPlaycount(int minim, int maxim); // ordenats per (playcount, id)
+    list<int> obtenirArtistesPerEstil(const string& estil);
+    list<int> obtenirArtistesPerEstils(const list<string>& totes, const list<string>& algun, const list<string>& cap);
+    list<int> obtenirArtistesPerId(int minim, int maxim) const; // només les particions del rang amb PER_RANG
+    int comptaArtistes(const FiltreArtistes& filtre);
+    list<int> obtenirArtistes(const FiltreArtistes& filtre);
+    long long sumaPlaycount(const FiltreArtistes& filtre);
+    list<int> topArtistes(int k, const FiltreArtistes& filtre = FiltreArtistes());
+    void configuraCache(size_t maxEntrades, size_t maxBytes = SIZE_MAX);
+    void activaFiltreBloom(double falsPositius = 0.01);
+
+    unsigned particions() const;
+    unsigned particioDe(int ArtistaID) const;
+    vector<size_t> midaParticions() const;
+    size_t mida() const;
+
+private:
+    struct alignas(64) Particio {
+        mutable mutex mtx;
+        Cercador cercador;
+    };
+
+    vector<unique_ptr<Particio>> parts;
+    Particionament tipus;
+    vector<int> limits;
+    mutable shared_mutex mtxLimits;
+    mutable PoolFils pool;
+
+    unsigned indexParticio(int ArtistaID) const;
+
+    template <class F>
+    auto perCadaParticio(F f, unsigned primera = 0, unsigned ultima = UINT_MAX) const -> vector<decltype(f(declval<Cercador&>(), 0u))>;
+    list<int> fusionaPerId(const vector<vector<int>>& ids) const;
+    static vector<int> aVector(const list<int>& llista);
+    static uint64_t barreja(uint64_t clau);
+};
+
+/**
+ * Constructor amb el nombre de particions (0: una per fil del pool), com es reparteixen els ids i
+ * els fils del pool de consultes (0: hardware_concurrency)
+*/
+template <class Cercador>
+CercadorArtistesParticionat<Cercador>::CercadorArtistesParticionat(unsigned particions, Particionament tipus, unsigned fils):
+    tipus(tipus), pool(fils) {
+    if (particions == 0) particions = pool.mida();
+    for (unsigned i = 0; i < particions; i++) parts.push_back(make_unique<Particio>());
+    // Fins a la primera càrrega, els rangs parteixen [0, INT_MAX] en trossos iguals
+    for (unsigned i = 1; i < particions; i++) limits.push_back(static_cast<int>(static_cast<long long>(INT_MAX) * i / particions));
+}
+
+/**
+ * Finalitzador de splitmix64
+ * @return uint64_t clau barrejada
+*/
+template <class Cercador>
+uint64_t CercadorArtistesParticionat<Cercador>::barreja(uint64_t clau) {
+    clau ^= clau >> 30;
+    clau *= 0xbf58476d1ce4e5b9ULL;
+    clau ^= clau >> 27;
+    clau *= 0x94d049bb133111ebULL;
+    return clau ^ (clau >> 31);
+}
+
+/**
+ * Partició on va un id
+ * @return unsigned índex de la partició
+*/
+template <class Cercador>
+unsigned CercadorArtistesParticionat<Cercador>::particioDe(int ArtistaID) const {
+    shared_lock<shared_mutex> rangs(mtxLimits);
+    return indexParticio(ArtistaID);
+}
+
+/**
+ * Partició on va un id, amb mtxLimits ja bloquejat
+ * @return unsigned índex de la partició
+*/
+template <class Cercador>
+unsigned CercadorArtistesParticionat<Cercador>::indexParticio(int ArtistaID) const {
+    if (tipus == PER_HASH) {
+        return static_cast<unsigned>(((barreja(static_cast<uint32_t>(ArtistaID)) >> 32) * parts.size()) >> 32);
+    }
+    return static_cast<unsigned>(upper_bound(limits.begin(), limits.end(), ArtistaID) - limits.begin());
+}
+
+template <class Cercador>
+unsigned CercadorArtistesParticionat<Cercador>::particions() const {
+    return static_cast<unsigned>(parts.size());
+}
+
+/**
+ * Crida a f(cercador, particio) a les particions [primera, ultima] en paral·lel, cada una amb el seu lock, i
+ * espera totes les respostes. Si alguna llança una excepció, es llança la de la primera partició
+ * @return vector amb el resultat de cada partició, en ordre de partició
+*/
+template <class Cercador>
+template <class F>
+auto CercadorArtistesParticionat<Cercador>::perCadaParticio(F f, unsigned primera, unsigned ultima) const
+    -> vector<decltype(f(declval<Cercador&>(), 0u))> {
+    typedef decltype(f(declval<Cercador&>(), 0u)) Resultat;
+    ultima = min<unsigned>(ultima, particions() - 1);
+    vector<future<Resultat>> pendents;
+    for (unsigned p = primera; p <= ultima; p++) {
+        Particio* part = parts[p].get();
+        pendents.push_back(pool.envia([part, p, &f]() -> Resultat {
+            lock_guard<mutex> lock(part->mtx);
+            return f(part->cercador, p);
+        }));
+    }
+    vector<Resultat> resultats;
+    resultats.reserve(pendents.size());
+    exception_ptr error;
+    for (future<Resultat>& pendent : pendents) {
+        try {
+            resultats.push_back(pendent.get());
+        } catch (...) {
+            if (!error) error = current_exception();
+            resultats.emplace_back();
+        }
+    }
+    if (error) rethrow_exception(error);
+    return resultats;
+}
+
+template <class Cercador>
+vector<int> CercadorArtistesParticionat<Cercador>::aVector(const list<int>& llista) {
+    return vector<int>(llista.begin(), llista.end());
+}
+
+/**
+ * Ajunta els ids ordenats de cada partició. Amb PER_RANG les particions ja estan en ordre d'id i
+ * n'hi ha prou de concatenar-les; amb PER_HASH es fusionen amb el heap
+ * @return list<int> ids ordenats
+*/
+template <class Cercador>
+list<int> CercadorArtistesParticionat<Cercador>::fusionaPerId(const vector<vector<int>>& ids) const {
+    list<int> llista;
+    if (tipus == PER_RANG) {
+        for (const vector<int>& v : ids) llista.insert(llista.end(), v.begin(), v.end());
+        return llista;
+    }
+    fusionaOrdenades(ids, less<int>(), [&llista](int id) { llista.push_back(id); return true; });
+    return llista;
+}
+
+/**
+ * Afegeix els artistes de diversos fitxers: es llegeixen en paral·lel, es reparteixen per partició
+ * mantenint l'ordre dels fitxers i cada partició es construeix en paral·lel amb afegeixTrossos.
+ * Amb PER_RANG i totes les particions buides, els límits passen a ser els quantils dels ids llegits.
+ * Mentre es reparteixen i es construeixen les particions, les operacions d'un artista esperen (mtxLimits).
+ * Un error de lectura es llança després d'afegir les files anteriors
+*/
+template <class Cercador>
+void CercadorArtistesParticionat<Cercador>::afegeixArtistes(const list<string>& fitxers) {
+    vector<TrosArtistes> trossos = llegeixArtistesParallel(fitxers, pool);
+    exception_ptr errorLectura;
+    size_t total = 0;
+    for (size_t t = 0; t < trossos.size(); t++) {
+        total += trossos[t].artistes.size();
+        if (trossos[t].error) {
+            errorLectura = trossos[t].error;
+            trossos.resize(t + 1);
+            break;
+        }
+    }
+
+    // Els límits no poden canviar mentre es reparteixen els artistes ni mentre una altra operació els fa servir
+    unique_lock<shared_mutex> rangs(mtxLimits);
+    if (tipus == PER_RANG && particions() > 1 && mida() == 0 && total > 0) {
+        vector<int> ids;
+        ids.reserve(total);
+        for (const TrosArtistes& tros : trossos) {
+            for (const Artist& a : tros.artistes) ids.push_back(a.getArtistId());
+        }
+        sort(ids.begin(), ids.end());
+        for (unsigned i = 1; i < particions(); i++) limits[i - 1] = ids[ids.size() * i / particions()];
+        // Amb pocs artistes dos límits poden coincidir: les particions del mig queden buides
+    }
+
+    vector<vector<TrosArtistes>> perParticio(particions(), vector<TrosArtistes>(1));
+    for (TrosArtistes& tros : trossos) {
+        for (Artist& a : tros.artistes) perParticio[indexParticio(a.getArtistId())][0].artistes.push_back(move(a));
+    }
+    trossos.clear();
+    perCadaParticio([&perParticio](Cercador& cercador, unsigned p) {
+        cercador.afegeixTrossos(perParticio[p]);
+        return true;
+    });
+    if (errorLectura) rethrow_exception(errorLectura);
+}
+
+/**
+ * Insereix un artista a la seva partició
+*/
+template <class Cercador>
+void CercadorArtistesParticionat<Cercador>::insereixArtista(int ArtistaID, string name, string gender, string country, string styles, int counts) {
+    shared_lock<shared_mutex> rangs(mtxLimits);
+    Particio& part = *parts[indexParticio(ArtistaID)];
+    lock_guard<mutex> lock(part.mtx);
+    part.cercador.insereixArtista(ArtistaID, move(name), move(gender), move(country), move(styles), counts);
+}
+
+template <class Cercador>
+string CercadorArtistesParticionat<Cercador>::mostrarArtista(int ArtistaID) const {
+    shared_lock<shared_mutex> rangs(mtxLimits);
+    const Particio& part = *parts[indexParticio(ArtistaID)];
+    lock_guard<mutex> lock(part.mtx);
+    return part.cercador.mostrarArtista(ArtistaID);
+}
+
+/**
+ * Afegeix la línia de l'artista a sortida, com mostrarArtista(id, sortida) del cercador
+ * @return bool si existeix l'artista
+*/
+template <class Cercador>
+bool CercadorArtistesParticionat<Cercador>::mostrarArtista(int ArtistaID, string& sortida) const {
+    shared_lock<shared_mutex> rangs(mtxLimits);
+    const Particio& part = *parts[indexParticio(ArtistaID)];
+    lock_guard<mutex> lock(part.mtx);
+    return part.cercador.mostrarArtista(ArtistaID, sortida);
+}
+
+template <class Cercador>
+bool CercadorArtistesParticionat<Cercador>::buscarArtista(int ArtistaID) {
+    shared_lock<shared_mutex> rangs(mtxLimits);
+    Particio& part = *parts[indexParticio(ArtistaID)];
+    lock_guard<mutex> lock(part.mtx);
+    return part.cercador.buscarArtista(ArtistaID);
+}
+
+template <class Cercador>
+bool CercadorArtistesParticionat<Cercador>::actualitzaPlaycount(int ArtistaID, int playcount) {
+    shared_lock<shared_mutex> rangs(mtxLimits);
+    Particio& part = *parts[indexParticio(ArtistaID)];
+    lock_guard<mutex> lock(part.mtx);
+    return part.cercador.actualitzaPlaycount(ArtistaID, playcount);
+}
+
+/**
+ * Reparteix un lot d'events per partició i cada partició aplica els seus en paral·lel
+ * @return EstadistiquesIngesta artistes actualitzats i desconeguts del lot
+*/
+template <class Cercador>
+EstadistiquesIngesta CercadorArtistesParticionat<Cercador>::aplicaReproduccions(vector<EventReproduccio>& events) {
+    shared_lock<shared_mutex> rangs(mtxLimits);
+    vector<vector<EventReproduccio>> perParticio(particions());
+    for (const EventReproduccio& ev : events) perParticio[indexParticio(ev.artistId)].push_back(ev);
+    EstadistiquesIngesta total;
+    total.events = events.size();
+    total.lots = 1;
+    vector<EstadistiquesIngesta> parcials = perCadaParticio([&perParticio](Cercador& cercador, unsigned p) {
+        return perParticio[p].empty() ? EstadistiquesIngesta() : cercador.aplicaReproduccions(perParticio[p]);
+    });
+    for (const EstadistiquesIngesta& e : parcials) {
+        total.actualitzats += e.actualitzats;
+        total.desconeguts += e.desconeguts;
+    }
+    return total;
+}
+
+template <class Cercador>
+int CercadorArtistesParticionat<Cercador>::buscarRecompteArtistes(int minim, int maxim) {
+    int total = 0;
+    for (int n : perCadaParticio([minim, maxim](Cercador& cercador, unsigned) {
+        return cercador.buscarRecompteArtistes(minim, maxim);
+    })) total += n;
+    return total;
+}
+
+/**
+ * Artistes amb playcount dins de [minim, maxim]: cada partició recorre el seu índex de playcount i
+ * es fusionen per (playcount, id)
+ * @return list<int> ids ordenats per playcount i, a igual playcount, per id
+*/
+template <class Cercador>
+list<int> CercadorArtistesParticionat<Cercador>::obtenirArtistesPerPlaycount(int minim, int maxim) {
+    vector<vector<pair<int, int>>> parcials = perCadaParticio([minim, maxim](Cercador& cercador, unsigned) {
+        vector<pair<int, int>> artistes;
+        cercador.indexosArtistes().recorrePlaycount(minim, maxim, [&artistes](int id, int playcount) {
+            artistes.emplace_back(playcount, id);
+        });
+        return artistes;
+    });
+    list<int> llista;
+    fusionaOrdenades(parcials, less<pair<int, int>>(), [&llista](const pair<int, int>& p) {
+        llista.push_back(p.second);
+        return true;
+    });
+    return llista;
+}
+
+template <class Cercador>
+list<int> CercadorArtistesParticionat<Cercador>::obtenirArtistesPerEstil(const string& estil) {
+    return fusionaPerId(perCadaParticio([&estil](Cercador& cercador, unsigned) {
+        return aVector(cercador.obtenirArtistesPerEstil(estil));
+    }));
+}
+
+template <class Cercador>
+list<int> CercadorArtistesParticionat<Cercador>::obtenirArtistesPerEstils(const list<string>& totes, const list<string>& algun, const list<string>& cap) {
+    return fusionaPerId(perCadaParticio([&](Cercador& cercador, unsigned) {
+        return aVector(cercador.obtenirArtistesPerEstils(totes, algun, cap));
+    }));
+}
+
+/**
+ * Ids dins de [minim, maxim]. Amb PER_RANG només es consulten les particions que tallen el rang
+ * @return list<int> ids ordenats
+*/
+template <class Cercador>
+list<int> CercadorArtistesParticionat<Cercador>::obtenirArtistesPerId(int minim, int maxim) const {
+    if (maxim < minim) return list<int>();
+    unsigned primera = 0, ultima = particions() - 1;
+    shared_lock<shared_mutex> rangs(mtxLimits);
+    if (tipus == PER_RANG) {
+        primera = indexParticio(minim);
+        ultima = indexParticio(maxim);
+    }
+    return fusionaPerId(perCadaParticio([minim, maxim](Cercador& cercador, unsigned) {
+        return aVector(cercador.obtenirArtistesPerId(minim, maxim));
+    }, primera, ultima));
+}
+
+template <class Cercador>
+int CercadorArtistesParticionat<Cercador>::comptaArtistes(const FiltreArtistes& filtre) {
+    int total = 0;
+    for (int n : perCadaParticio([&filtre](Cercador& cercador, unsigned) { return cercador.comptaArtistes(filtre); })) total += n;
+    return total;
+}
+
+/**
+ * Artistes que compleixen un filtre, amb el pla de cada partició
+ * @return list<int> ids ordenats
+*/
+template <class Cercador>
+list<int> CercadorArtistesParticionat<Cercador>::obtenirArtistes(const FiltreArtistes& filtre) {
+    return fusionaPerId(perCadaParticio([&filtre](Cercador& cercador, unsigned) {
+        return aVector(cercador.obtenirArtistes(filtre));
+    }));
+}
+
+template <class Cercador>
+long long CercadorArtistesParticionat<Cercador>::sumaPlaycount(const FiltreArtistes& filtre) {
+    long long total = 0;
+    for (long long n : perCadaParticio([&filtre](Cercador& cercador, unsigned) { return cercador.sumaPlaycount(filtre); })) total += n;
+    return total;
+}
+
+/**
+ * Els k artistes amb més playcount que compleixen el filtre: cada partició dona el seu top k i es
+ * fusionen fins a tenir-ne k
+ * @return list<int> ids de més a menys playcount, a igual playcount per id
+*/
+template <class Cercador>
+list<int> CercadorArtistesParticionat<Cercador>::topArtistes(int k, const FiltreArtistes& filtre) {
+    list<int> llista;
+    if (k <= 0) return llista;
+    vector<vector<pair<int, int>>> parcials = perCadaParticio([k, &filtre](Cercador& cercador, unsigned) {
+        return cercador.indexosArtistes().topAmbPlaycount(filtre, static_cast<size_t>(k));
+    });
+    auto abans = [](const pair<int, int>& a, const pair<int, int>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    };
+    fusionaOrdenades(parcials, abans, [&llista, k](const pair<int, int>& p) {
+        llista.push_back(p.second);
+        return static_cast<int>(llista.size()) < k;
+    });
+    return llista;
+}
+
+template <class Cercador>
+void CercadorArtistesParticionat<Cercador>::configuraCache(size_t maxEntrades, size_t maxBytes) {
+    perCadaParticio([=](Cercador& cercador, unsigned) {
+        cercador.configuraCache(maxEntrades, maxBytes);
+        return true;
+    });
+}
+
+template <class Cercador>
+void CercadorArtistesParticionat<Cercador>::activaFiltreBloom(double falsPositius) {
+    perCadaParticio([falsPositius](Cercador& cercador, unsigned) {
+        cercador.activaFiltreBloom(falsPositius);
+        return true;
+    });
+}
+
+/**
+ * Artistes de cada partició, per veure si estan equilibrades
+ * @return vector<size_t> mida de cada partició
+*/
+template <class Cercador>
+vector<size_t> CercadorArtistesParticionat<Cercador>::midaParticions() const {
+    vector<size_t> mides;
+    for (const unique_ptr<Particio>& part : parts) {
+        lock_guard<mutex> lock(part->mtx);
+        mides.push_back(part->cercador.indexosArtistes().mida());
+    }
+    return mides;
+}
+
+template <class Cercador>
+size_t CercadorArtistesParticionat<Cercador>::mida() const {
+    size_t total = 0;
+    for (size_t m : midaParticions()) total += m;
+    return total;
+}
+
+#endif /* CERCADORARTISTESPARTICIONAT_H */
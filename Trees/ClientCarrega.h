@@ -0,0 +1,179 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Load generator for the query server (Client de càrrega).
+ * It opens several connections to a ServidorConsultes, one thread per connection, and sends
+ * the queries of a list with up to "pipeline" queries waiting for an answer on each connection.
+ * It measures the time from sending every query to reading its answer line, to report the
+ * throughput and the tail latency of the server.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - carregaServidor: O(connexions * peticions) queries. It uses 4 bytes per query for the latencies.
+ *
+ * ################################################
+ */
+
+#ifndef CLIENTCARREGA_H
+#define CLIENTCARREGA_H
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <exception>
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+struct EstadistiquesClient {
+    size_t peticions = 0;
+    size_t errors = 0;          // Respostes "error: ..."
+    double segons = 0;
+    double peticionsPerSegon = 0;
+    double p50 = 0;             // Microsegons
+    double p99 = 0;
+    double p999 = 0;
+};
+
+#if !defined(_WIN32)
+
+/**
+ * Obre una connexió bloquejant al socket del servidor
+ * @return int descriptor de la connexió
+*/
+int connectaServidor(const string& cami) {
+    sockaddr_un adreca;
+    memset(&adreca, 0, sizeof(adreca));
+    adreca.sun_family = AF_UNIX;
+    if (cami.size() >= sizeof(adreca.sun_path)) throw invalid_argument("Cami del socket massa llarg\n");
+    memcpy(adreca.sun_path, cami.c_str(), cami.size() + 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&adreca), sizeof(adreca)) < 0) {
+        string error = strerror(errno);
+        if (fd >= 0) ::close(fd);
+        throw runtime_error("No es pot connectar a " + cami + ": " + error);
+    }
+    return fd;
+}
+
+/**
+ * Envia peticions consultes per una connexió amb com a molt pipeline pendents de resposta
+ * i guarda la latència de cadascuna en nanosegons
+*/
+void carregaConnexio(const string& cami, const vector<string>& consultes, size_t primera, size_t peticions,
+    size_t pipeline, vector<uint32_t>& latencies, size_t& errors) {
+    int fd = connectaServidor(cami);
+    deque<chrono::steady_clock::time_point> enviades;
+    string sortida, entrada;
+    char buffer[1 << 16];
+    size_t nEnviades = 0, nRebudes = 0;
+    latencies.reserve(peticions);
+
+    while (nRebudes < peticions) {
+        // Omple la finestra de peticions pendents i l'envia amb un sol write
+        sortida.clear();
+        chrono::steady_clock::time_point ara = chrono::steady_clock::now();
+        while (nEnviades < peticions && nEnviades - nRebudes < pipeline) {
+            sortida += consultes[(primera + nEnviades) % consultes.size()];
+            sortida += '\n';
+            enviades.push_back(ara);
+            nEnviades++;
+        }
+        for (size_t fet = 0; fet < sortida.size();) {
+            ssize_t w = ::send(fd, sortida.data() + fet, sortida.size() - fet, MSG_NOSIGNAL);
+            if (w <= 0) {
+                if (w < 0 && errno == EINTR) continue;
+                ::close(fd);
+                throw runtime_error("El servidor ha tancat la connexio\n");
+            }
+            fet += static_cast<size_t>(w);
+        }
+
+        ssize_t r = ::read(fd, buffer, sizeof(buffer));
+        if (r <= 0) {
+            if (r < 0 && errno == EINTR) continue;
+            ::close(fd);
+            throw runtime_error("El servidor ha tancat la connexio\n");
+        }
+        entrada.append(buffer, static_cast<size_t>(r));
+        ara = chrono::steady_clock::now();
+        size_t inici = 0, salt;
+        while ((salt = entrada.find('\n', inici)) != string::npos) {
+            if (entrada.compare(inici, 7, "error: ") == 0) errors++;
+            long long ns = chrono::duration_cast<chrono::nanoseconds>(ara - enviades.front()).count();
+            latencies.push_back(static_cast<uint32_t>(min<long long>(ns, UINT32_MAX)));
+            enviades.pop_front();
+            nRebudes++;
+            inici = salt + 1;
+        }
+        entrada.erase(0, inici);
+    }
+    ::close(fd);
+}
+
+/**
+ * Genera càrrega sobre el servidor amb diverses connexions en paral·lel
+ * @return EstadistiquesClient peticions per segon i percentils de latència
+*/
+EstadistiquesClient carregaServidor(const string& cami, const vector<string>& consultes, unsigned connexions,
+    size_t peticionsPerConnexio, size_t pipeline) {
+    if (consultes.empty()) throw invalid_argument("No hi ha consultes\n");
+    if (connexions == 0) connexions = 1;
+    if (pipeline == 0) pipeline = 1;
+
+    vector<vector<uint32_t>> latencies(connexions);
+    vector<size_t> errors(connexions, 0);
+    vector<exception_ptr> excepcions(connexions);
+    vector<thread> fils;
+    chrono::steady_clock::time_point inici = chrono::steady_clock::now();
+    for (unsigned i = 0; i < connexions; i++) {
+        fils.emplace_back([&, i]() {
+            try {
+                carregaConnexio(cami, consultes, i * peticionsPerConnexio, peticionsPerConnexio, pipeline, latencies[i], errors[i]);
+            } catch (...) {
+                excepcions[i] = current_exception();
+            }
+        });
+    }
+    for (thread& f : fils) f.join();
+    double segons = chrono::duration<double>(chrono::steady_clock::now() - inici).count();
+    for (exception_ptr& e : excepcions) {
+        if (e) rethrow_exception(e);
+    }
+
+    EstadistiquesClient e;
+    vector<uint32_t> totes;
+    for (unsigned i = 0; i < connexions; i++) {
+        totes.insert(totes.end(), latencies[i].begin(), latencies[i].end());
+        e.errors += errors[i];
+    }
+    e.peticions = totes.size();
+    e.segons = segons;
+    e.peticionsPerSegon = (segons > 0) ? e.peticions / segons : 0;
+    if (!totes.empty()) {
+        sort(totes.begin(), totes.end());
+        e.p50 = totes[totes.size() / 2] / 1000.0;
+        e.p99 = totes[min(totes.size() - 1, totes.size() * 99 / 100)] / 1000.0;
+        e.p999 = totes[min(totes.size() - 1, totes.size() * 999 / 1000)] / 1000.0;
+    }
+    return e;
+}
+
+#endif
+
+#endif /* CLIENTCARREGA_H */
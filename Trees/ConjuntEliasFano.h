@@ -0,0 +1,350 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Static set of integers encoded with Elias-Fano (Conjunt Elias-Fano).
+ * The keys are sorted and stored relative to the smallest one (v = clau - minim). Every v is split
+ * into its l low bits and its high part v >> l, with l = floor(log2(U / n)) (U is the range of the
+ * keys and n the number of keys):
+ * - The low bits of all the keys are packed one after the other (n * l bits).
+ * - The high parts are written in unary in a bit vector: the key i sets bit (v_i >> l) + i, so the
+ *   ones are the keys and the zeros separate the buckets of keys with the same high part (2n bits at most).
+ * The position of every 256th one and every 256th zero is sampled, so finding the i-th one (seleccio)
+ * or the start of the bucket of a key (comptaMenors, conte, seguentMajorOIgual) reads a few words.
+ * It uses about 2 + log2(U / n) bits per key instead of a node of the tree per key, so it can answer
+ * membership, rank and pagination over the ids of a read-only copy of the catalogue.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - Building (constructor): O(n + U / 2^l) = O(n).
+ * - seleccio: O(1) (at most 256 ones, 4 to 5 words, after the sample).
+ * - conte, comptaMenors, seguentMajorOIgual: O(1) to find the bucket plus the keys of the bucket (1 to 2 on average).
+ *   If the keys are clustered both are O(log n): the samples of ones give the bounds of the bucket and
+ *   the low bits of a long bucket are binary searched.
+ * - l is chosen with the range U, so a skewed universe costs space: 1M dense ids plus one id near INT_MAX
+ *   give l = 11 and about 13 bits per id (instead of 2 to 3), and buckets of about 2048 ids.
+ * - recorre: O(1) per key reported after the first one.
+ * - n * (2 + l) bits plus 64 bits per 256 ones and per 256 zeros of samples.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * minim, maxim : Smallest and biggest keys, the keys are stored as key - minim.
+ * n, bitsBaixos : Number of keys and number of low bits per key (l).
+ * baixos : Packed low bits of the keys.
+ * alts : Bit vector of the high parts in unary.
+ * mostresUns, mostresZeros : Position in alts of the ones and the zeros number 0, 256, 512, ...
+ *
+ * ################################################
+ *
+ * ################################################
+ * METHODS
+ *
+ * CONSTRUCTORS  ##################################
+ *
+ * ConjuntEliasFano : Default constructor (empty set), or builds the set from sorted keys without repeats.
+ *
+ * CONSULTORS #####################################
+ *
+ * mida : Returns the number of keys.
+ * conte : Returns true if the key is in the set.
+ * comptaMenors : Returns the number of keys smaller than a value (rank).
+ * seleccio : Returns the i-th smallest key (0-based, select).
+ * seguentMajorOIgual : Finds the smallest key greater or equal than a value (nextGEQ).
+ * bitsPerClau, memoria : Returns the bits used per key and the total bytes.
+ *
+ * OPERATIONS #####################################
+ *
+ * recorre : Calls a function with the keys from the i-th one, in increasing order, while it returns true.
+ *
+ * ################################################
+ */
+
+#ifndef CONJUNTELIASFANO_H
+#define CONJUNTELIASFANO_H
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+
+class ConjuntEliasFano {
+public:
+    static const size_t MOSTREIG = 256;
+
+    ConjuntEliasFano();
+    explicit ConjuntEliasFano(const vector<int>& claus);
+
+    size_t mida() const;
+    bool conte(int clau) const;
+    size_t comptaMenors(int clau) const;
+    int seleccio(size_t i) const;
+    bool seguentMajorOIgual(int clau, int& seguent) const;
+    template <class F>
+    void recorre(size_t i, F f) const;
+
+    double bitsPerClau() const;
+    size_t memoria() const;
+
+private:
+    int64_t minim;
+    int64_t maxim;
+    size_t n;
+    unsigned bitsBaixos;
+    vector<uint64_t> baixos;
+    vector<uint64_t> alts;
+    vector<uint64_t> mostresUns;
+    vector<uint64_t> mostresZeros;
+
+    uint64_t baix(size_t i) const;
+    uint64_t posicioUn(size_t i) const;
+    uint64_t posicioZero(uint64_t j) const;
+    size_t primerNoMenor(int clau, bool& igual) const;
+
+    static unsigned seleccioEnParaula(uint64_t paraula, unsigned r);
+};
+
+/**
+ * Constructor sense paràmetres. El conjunt és buit
+*/
+ConjuntEliasFano::ConjuntEliasFano(): minim(0), maxim(-1), n(0), bitsBaixos(0) {}
+
+/**
+ * Constructor que codifica les claus, que han d'estar ordenades i sense repetits
+*/
+ConjuntEliasFano::ConjuntEliasFano(const vector<int>& claus): minim(0), maxim(-1), n(claus.size()), bitsBaixos(0) {
+    if (n == 0) return;
+    minim = claus.front();
+    maxim = claus.back();
+    uint64_t univers = static_cast<uint64_t>(maxim - minim) + 1;
+    while (bitsBaixos < 62 && (univers >> (bitsBaixos + 1)) >= n) bitsBaixos++;
+
+    baixos.assign((n * bitsBaixos + 63) / 64 + 1, 0);
+    size_t bitsAlts = n + static_cast<size_t>(static_cast<uint64_t>(maxim - minim) >> bitsBaixos) + 1;
+    alts.assign((bitsAlts + 63) / 64, 0);
+    uint64_t mascara = (uint64_t(1) << bitsBaixos) - 1;
+    int64_t anterior = INT64_MIN;
+    for (size_t i = 0; i < n; i++) {
+        if (claus[i] <= anterior) throw invalid_argument("Les claus del conjunt Elias-Fano han d'estar ordenades i sense repetits\n");
+        anterior = claus[i];
+        uint64_t v = static_cast<uint64_t>(claus[i] - minim);
+        if (bitsBaixos > 0) {
+            size_t posicio = i * bitsBaixos;
+            baixos[posicio / 64] |= (v & mascara) << (posicio % 64);
+            if (posicio % 64 + bitsBaixos > 64) baixos[posicio / 64 + 1] |= (v & mascara) >> (64 - posicio % 64);
+        }
+        uint64_t alt = (v >> bitsBaixos) + i;
+        alts[alt / 64] |= uint64_t(1) << (alt % 64);
+    }
+
+    // Mostres de la posició dels uns i dels zeros número 0, MOSTREIG, 2 * MOSTREIG...
+    size_t uns = 0, zeros = 0;
+    for (size_t posicio = 0; posicio < bitsAlts; posicio++) {
+        if ((alts[posicio / 64] >> (posicio % 64)) & 1) {
+            if (uns++ % MOSTREIG == 0) mostresUns.push_back(posicio);
+        } else if (zeros++ % MOSTREIG == 0) mostresZeros.push_back(posicio);
+    }
+}
+
+size_t ConjuntEliasFano::mida() const {
+    return n;
+}
+
+/**
+ * Bits baixos de la clau i
+ * @return uint64_t els bitsBaixos bits
+*/
+uint64_t ConjuntEliasFano::baix(size_t i) const {
+    if (bitsBaixos == 0) return 0;
+    size_t posicio = i * bitsBaixos;
+    uint64_t v = baixos[posicio / 64] >> (posicio % 64);
+    if (posicio % 64 + bitsBaixos > 64) v |= baixos[posicio / 64 + 1] << (64 - posicio % 64);
+    return v & ((uint64_t(1) << bitsBaixos) - 1);
+}
+
+/**
+ * Posició del bit número r (0-based) que val 1 dins d'una paraula
+ * @return unsigned posició dins de la paraula
+*/
+unsigned ConjuntEliasFano::seleccioEnParaula(uint64_t paraula, unsigned r) {
+    // Primer es busca el byte amb popcount i després el bit
+    for (unsigned byte = 0; byte < 8; byte++) {
+        unsigned uns = static_cast<unsigned>(__builtin_popcountll((paraula >> (byte * 8)) & 0xFF));
+        if (r < uns) {
+            uint64_t b = (paraula >> (byte * 8)) & 0xFF;
+            for (unsigned k = 0; k < r; k++) b &= b - 1;
+            return byte * 8 + static_cast<unsigned>(__builtin_ctzll(b));
+        }
+        r -= uns;
+    }
+    return 64;
+}
+
+/**
+ * Posició a alts de l'u número i
+ * @return uint64_t posició
+*/
+uint64_t ConjuntEliasFano::posicioUn(size_t i) const {
+    uint64_t posicio = mostresUns[i / MOSTREIG];
+    unsigned r = static_cast<unsigned>(i % MOSTREIG);
+    size_t w = posicio / 64;
+    uint64_t paraula = alts[w] & (~uint64_t(0) << (posicio % 64));
+    while (true) {
+        unsigned uns = static_cast<unsigned>(__builtin_popcountll(paraula));
+        if (r < uns) return w * 64 + seleccioEnParaula(paraula, r);
+        r -= uns;
+        paraula = alts[++w];
+    }
+}
+
+/**
+ * Posició a alts del zero número j
+ * @return uint64_t posició
+*/
+uint64_t ConjuntEliasFano::posicioZero(uint64_t j) const {
+    uint64_t posicio = mostresZeros[j / MOSTREIG];
+    unsigned r = static_cast<unsigned>(j % MOSTREIG);
+    // En una zona densa hi pot haver milers d'uns entre dues mostres de zeros. Les mostres d'uns que hi
+    // cauen diuen quants zeros tenen al davant: es comença des de l'última amb com a molt j zeros
+    uint64_t seguent = (j / MOSTREIG + 1 < mostresZeros.size()) ? mostresZeros[j / MOSTREIG + 1] : alts.size() * 64;
+    if (seguent - posicio > 4 * MOSTREIG) {
+        size_t esq = static_cast<size_t>((posicio - (j - r)) / MOSTREIG);
+        size_t dre = min(mostresUns.size(), static_cast<size_t>((seguent - (j - r)) / MOSTREIG) + 1);
+        while (esq < dre) {
+            size_t mig = esq + (dre - esq) / 2;
+            if (mostresUns[mig] - mig * MOSTREIG <= j) esq = mig + 1;
+            else dre = mig;
+        }
+        if (esq > 0 && mostresUns[esq - 1] > posicio) {
+            posicio = mostresUns[esq - 1];
+            r = static_cast<unsigned>(j - (posicio - (esq - 1) * MOSTREIG));
+        }
+    }
+    size_t w = posicio / 64;
+    uint64_t paraula = ~alts[w] & (~uint64_t(0) << (posicio % 64));
+    while (true) {
+        unsigned zeros = static_cast<unsigned>(__builtin_popcountll(paraula));
+        if (r < zeros) return w * 64 + seleccioEnParaula(paraula, r);
+        r -= zeros;
+        paraula = ~alts[++w];
+    }
+}
+
+/**
+ * Índex de la primera clau que no és menor que clau, i si és igual
+ * @return size_t índex (n si totes són menors)
+*/
+size_t ConjuntEliasFano::primerNoMenor(int clau, bool& igual) const {
+    igual = false;
+    if (n == 0 || clau <= minim) {
+        igual = n > 0 && clau == minim;
+        return 0;
+    }
+    if (clau > maxim) return n;
+    uint64_t v = static_cast<uint64_t>(clau - minim);
+    uint64_t alt = v >> bitsBaixos;
+    // Les claus amb part alta alt comencen després del zero número alt - 1, que acaba el grup anterior
+    uint64_t posicio = (alt == 0) ? 0 : posicioZero(alt - 1) + 1;
+    size_t i = static_cast<size_t>(posicio - alt);
+    uint64_t baixBuscat = v & ((uint64_t(1) << bitsBaixos) - 1);
+    // Els grups solen tenir 1 o 2 claus i es recorren. Un univers esbiaixat (ids densos i un id aïllat
+    // molt gran) fa grups de milers de claus: la resta del grup es busca per cerca binària
+    for (unsigned k = 0; k < 8; k++, i++, posicio++) {
+        if (i >= n || !((alts[posicio / 64] >> (posicio % 64)) & 1)) return i;
+        uint64_t b = baix(i);
+        if (b >= baixBuscat) {
+            igual = (b == baixBuscat);
+            return i;
+        }
+    }
+    size_t fi = static_cast<size_t>(posicioZero(alt) - alt);
+    size_t finalGrup = fi;
+    while (i < fi) {
+        size_t mig = i + (fi - i) / 2;
+        if (baix(mig) < baixBuscat) i = mig + 1;
+        else fi = mig;
+    }
+    igual = i < finalGrup && baix(i) == baixBuscat;
+    return i;
+}
+
+/**
+ * Mira si la clau és al conjunt
+ * @return bool si hi és
+*/
+bool ConjuntEliasFano::conte(int clau) const {
+    bool igual;
+    primerNoMenor(clau, igual);
+    return igual;
+}
+
+/**
+ * Nombre de claus més petites que clau (rank)
+ * @return size_t nombre de claus
+*/
+size_t ConjuntEliasFano::comptaMenors(int clau) const {
+    bool igual;
+    return primerNoMenor(clau, igual);
+}
+
+/**
+ * Clau número i en ordre creixent (select)
+ * @return int clau
+*/
+int ConjuntEliasFano::seleccio(size_t i) const {
+    if (i >= n) throw out_of_range("Index fora del conjunt\n");
+    return static_cast<int>(minim + static_cast<int64_t>(((posicioUn(i) - i) << bitsBaixos) | baix(i)));
+}
+
+/**
+ * Busca la clau més petita que és més gran o igual que clau (nextGEQ)
+ * @return bool si n'hi ha alguna; seguent és la clau trobada
+*/
+bool ConjuntEliasFano::seguentMajorOIgual(int clau, int& seguent) const {
+    bool igual;
+    size_t i = primerNoMenor(clau, igual);
+    if (i >= n) return false;
+    seguent = igual ? clau : seleccio(i);
+    return true;
+}
+
+/**
+ * Crida a f(clau) amb les claus des de la número i en ordre creixent fins que f retorna false o s'acaben
+*/
+template <class F>
+void ConjuntEliasFano::recorre(size_t i, F f) const {
+    if (i >= n) return;
+    uint64_t posicio = posicioUn(i);
+    while (true) {
+        if (!f(static_cast<int>(minim + static_cast<int64_t>(((posicio - i) << bitsBaixos) | baix(i))))) return;
+        if (++i >= n) return;
+        // L'u següent: es salten els zeros dels grups buits
+        posicio++;
+        uint64_t paraula = alts[posicio / 64] & (~uint64_t(0) << (posicio % 64));
+        size_t w = posicio / 64;
+        while (paraula == 0) paraula = alts[++w];
+        posicio = w * 64 + static_cast<unsigned>(__builtin_ctzll(paraula));
+    }
+}
+
+/**
+ * Bits que fa servir el conjunt per cada clau, comptant les mostres
+ * @return double bits per clau
+*/
+double ConjuntEliasFano::bitsPerClau() const {
+    return n == 0 ? 0 : 8.0 * memoria() / n;
+}
+
+/**
+ * Bytes que fan servir les dades del conjunt
+ * @return size_t bytes
+*/
+size_t ConjuntEliasFano::memoria() const {
+    return (baixos.size() + alts.size() + mostresUns.size() + mostresZeros.size()) * sizeof(uint64_t);
+}
+
+#endif /* CONJUNTELIASFANO_H */
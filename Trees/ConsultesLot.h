@@ -0,0 +1,374 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Batch query engine (Consultes per lots).
+ * This class runs a file (or a stream) of queries against a search engine without the menus.
+ * The queries are read in windows of FINESTRA lines, every window is split between the threads
+ * of a pool, and the answers are written in the same order as the queries through a buffered
+ * writer. It measures the latency of every query to report queries per second, p50 and p99.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - executa: O(q * c / fils), where q is the number of queries and c the cost of one query.
+ * - Memory: O(FINESTRA) lines and answers, plus 4 bytes per query for the latencies.
+ *
+ * ################################################
+ * FORMAT
+ *
+ * One query per line. A line that starts with a digit is a lookup by id (only the first field is
+ * read, so cercaArtists.csv can be used as it is). The other lines are "tipus,argument":
+ *   id,1370          -> 1 or 0
+ *   mostra,1370      -> 1370::name::gender::country::styles::playcount, or 0
+ *   estil,pop        -> ids with the style
+ *   nom,Rosalía      -> ids with the name
+ *   prefix,ros,5     -> the 5 ids with more playcount whose name starts with "ros"
+ *   aprox,rosalai,2,5 -> the 5 ids with the closest names at edit distance <= 2 from "rosalai"
+ *   text,gaze|core   -> ids with "gaze" or "core" in some field (case insensitive)
+ *   recompte,100000  -> number of artists with more playcount
+ *   rang,1,5000,1000,100000 -> ids from 1 to 5000 with a playcount from 1000 to 100000
+ * Empty lines, lines that start with '#' and the header "artist_id,..." are skipped.
+ * Every answer is written as "consulta<TAB>resposta". A wrong query answers "error: ...".
+ *
+ * ################################################
+ * METHODS
+ *
+ * ConsultesLot : Creates the engine over a search engine with a pool of fils threads.
+ * executa : Runs the queries of a string_view or of an istream and writes the answers.
+ * executaFitxer : Maps a file of queries and runs it. "-" reads the standard input.
+ *
+ * respondreConsulta (function) : Answers one query of the format above. It is also used by the server.
+ *
+ * ################################################
+ */
+
+#ifndef CONSULTESLOT_H
+#define CONSULTESLOT_H
+#include "PoolFils.h"
+#include "LectorCSV.h"
+#include "Artist.h"
+#include "IndexEstils.h"
+#include "PatronsText.h"
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <list>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+struct EstadistiquesLot {
+    size_t consultes = 0;
+    size_t trobades = 0;    // Consultes amb algun resultat
+    size_t errors = 0;
+    double segons = 0;
+    double consultesPerSegon = 0;
+    double p50 = 0;         // Microsegons
+    double p99 = 0;         // Microsegons
+};
+
+/**
+ * Escriptor amb memòria intermèdia: acumula el text i l'escriu al stream en trossos grans
+*/
+class EscriptorBuffer {
+public:
+    explicit EscriptorBuffer(ostream& sortida, size_t capacitat = 1 << 20);
+    EscriptorBuffer(const EscriptorBuffer&) = delete;
+    EscriptorBuffer& operator=(const EscriptorBuffer&) = delete;
+    ~EscriptorBuffer();
+
+    void escriu(string_view text);
+    void buida();
+
+private:
+    ostream& sortida;
+    string buffer;
+    size_t capacitat;
+};
+
+EscriptorBuffer::EscriptorBuffer(ostream& sortida, size_t capacitat): sortida(sortida), capacitat(capacitat) {
+    buffer.reserve(capacitat);
+}
+
+EscriptorBuffer::~EscriptorBuffer() {
+    buida();
+}
+
+/**
+ * Afegeix text a la memòria intermèdia i l'escriu si s'omple
+*/
+void EscriptorBuffer::escriu(string_view text) {
+    if (buffer.size() + text.size() > capacitat) buida();
+    if (text.size() >= capacitat) sortida.write(text.data(), static_cast<streamsize>(text.size()));
+    else buffer.append(text);
+}
+
+/**
+ * Escriu tot el que queda a la memòria intermèdia
+*/
+void EscriptorBuffer::buida() {
+    if (buffer.empty()) return;
+    sortida.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+    buffer.clear();
+}
+
+/**
+ * Respon una consulta sobre un cercador i afegeix la resposta al final de resposta
+ * @return bool si la consulta té algun resultat
+*/
+template <class Cercador>
+bool respondreConsulta(Cercador& cercador, string_view consulta, string& resposta) {
+    if (consulta.empty()) throw invalid_argument("Consulta buida");
+    size_t coma = consulta.find(',');
+    string_view tipus = consulta.substr(0, coma);
+    string_view argument = (coma == string_view::npos) ? string_view() : consulta.substr(coma + 1);
+    if (tipus.empty()) throw invalid_argument("Falta el tipus de consulta");
+
+    if (tipus[0] >= '0' && tipus[0] <= '9') {
+        argument = tipus;
+        tipus = "id";
+    }
+    if (tipus == "id") {
+        bool trobat = cercador.buscarArtista(LectorCSV::llegeixEnter(argument));
+        resposta += trobat ? '1' : '0';
+        return trobat;
+    }
+    if (tipus == "mostra") {
+        // La línia de l'artista s'escriu directament a la resposta, sense el salt de línia
+        bool trobat = cercador.mostrarArtista(LectorCSV::llegeixEnter(argument), resposta);
+        if (trobat) resposta.pop_back();
+        else resposta += '0';
+        return trobat;
+    }
+    if (tipus == "recompte") {
+        int n = cercador.buscarRecompteArtistes(LectorCSV::llegeixEnter(argument));
+        Artist::afegeixEnter(resposta, n);
+        return n > 0;
+    }
+
+    list<int> ids;
+    if (tipus == "estil") ids = cercador.obtenirArtistesPerEstil(string(argument));
+    else if (tipus == "nom") ids = cercador.buscarArtistesPerNom(string(argument));
+    else if (tipus == "prefix") {
+        size_t ultima = argument.rfind(',');
+        if (ultima == string_view::npos) throw invalid_argument("Falta el nombre de resultats del prefix");
+        ids = cercador.autocompletaNom(string(argument.substr(0, ultima)), LectorCSV::llegeixEnter(argument.substr(ultima + 1)));
+    }
+    else if (tipus == "text") {
+        FiltreText filtre;
+        IndexEstils::perCadaEstil(argument, [&filtre](string_view patro) { filtre.patrons.emplace_back(patro); });
+        ids = cercador.obtenirArtistesPerText(filtre);
+    }
+    else if (tipus == "aprox") {
+        size_t ultima = argument.rfind(',');
+        size_t penultima = (ultima == string_view::npos || ultima == 0) ? string_view::npos : argument.rfind(',', ultima - 1);
+        if (penultima == string_view::npos) throw invalid_argument("Falten la distancia i el nombre de resultats");
+        ids = cercador.buscarArtistesPerNomAproximat(string(argument.substr(0, penultima)),
+            LectorCSV::llegeixEnter(argument.substr(penultima + 1, ultima - penultima - 1)),
+            LectorCSV::llegeixEnter(argument.substr(ultima + 1)));
+    }
+    else if (tipus == "rang") {
+        int limits[4];
+        for (int i = 0; i < 4; i++) {
+            size_t seguent = (i < 3) ? argument.find(',') : argument.size();
+            if (seguent == string_view::npos) throw invalid_argument("Falten limits del rang");
+            limits[i] = LectorCSV::llegeixEnter(argument.substr(0, seguent));
+            argument = argument.substr(min(seguent + 1, argument.size()));
+        }
+        ids = cercador.obtenirArtistesPerIdIPlaycount(limits[0], limits[1], limits[2], limits[3]);
+    }
+    else throw invalid_argument("Consulta desconeguda");
+    bool primer = true;
+    for (int id : ids) {
+        if (!primer) resposta += ' ';
+        Artist::afegeixEnter(resposta, id);
+        primer = false;
+    }
+    return !ids.empty();
+}
+
+template <class Cercador>
+class ConsultesLot {
+public:
+    static const size_t FINESTRA = 1 << 16;
+
+    explicit ConsultesLot(Cercador& cercador, unsigned fils = 0);
+
+    EstadistiquesLot executa(string_view consultes, ostream& sortida);
+    EstadistiquesLot executa(istream& entrada, ostream& sortida);
+    EstadistiquesLot executaFitxer(const string& fitxer, ostream& sortida);
+
+private:
+    Cercador& cercador;
+    PoolFils pool;
+
+    struct Tros {
+        string sortida;
+        vector<uint32_t> latencies;
+        size_t trobades = 0;
+        size_t errors = 0;
+    };
+
+    static bool ignora(string_view linia);
+    void executaFinestra(const vector<string_view>& linies, EscriptorBuffer& escriptor,
+        vector<uint32_t>& latencies, EstadistiquesLot& e);
+    static EstadistiquesLot resumeix(EstadistiquesLot e, vector<uint32_t>& latencies, double segons);
+};
+
+/**
+ * Constructor amb el cercador on es fan les consultes i el nombre de fils (0: tots els nuclis)
+*/
+template <class Cercador>
+ConsultesLot<Cercador>::ConsultesLot(Cercador& cercador, unsigned fils): cercador(cercador), pool(fils) {}
+
+/**
+ * Línies que no són consultes: buides, comentaris i la capçalera dels fitxers d'artistes
+ * @return bool si s'ha de saltar la línia
+*/
+template <class Cercador>
+bool ConsultesLot<Cercador>::ignora(string_view linia) {
+    return linia.empty() || linia[0] == '#' || linia.compare(0, 9, "artist_id") == 0;
+}
+
+/**
+ * Respon una finestra de consultes repartida entre els fils i escriu les respostes en ordre
+*/
+template <class Cercador>
+void ConsultesLot<Cercador>::executaFinestra(const vector<string_view>& linies, EscriptorBuffer& escriptor,
+    vector<uint32_t>& latencies, EstadistiquesLot& e) {
+    if (linies.empty()) return;
+    vector<Tros> trossos(pool.mida());
+    pool.perCadaBloc(linies.size(), [&](size_t bloc, size_t inici, size_t fi) {
+        Tros& t = trossos[bloc];
+        t.latencies.reserve(fi - inici);
+        for (size_t i = inici; i < fi; i++) {
+            t.sortida.append(linies[i]);
+            t.sortida += '\t';
+            chrono::steady_clock::time_point abans = chrono::steady_clock::now();
+            try {
+                if (respondreConsulta(cercador, linies[i], t.sortida)) t.trobades++;
+            } catch (const exception& ex) {
+                t.sortida += "error: ";
+                t.sortida += ex.what();
+                while (!t.sortida.empty() && t.sortida.back() == '\n') t.sortida.pop_back();
+                t.errors++;
+            }
+            chrono::steady_clock::time_point despres = chrono::steady_clock::now();
+            long long ns = chrono::duration_cast<chrono::nanoseconds>(despres - abans).count();
+            t.latencies.push_back(static_cast<uint32_t>(min<long long>(ns, UINT32_MAX)));
+            t.sortida += '\n';
+        }
+    });
+    for (Tros& t : trossos) {
+        escriptor.escriu(t.sortida);
+        latencies.insert(latencies.end(), t.latencies.begin(), t.latencies.end());
+        e.trobades += t.trobades;
+        e.errors += t.errors;
+    }
+    e.consultes += linies.size();
+}
+
+/**
+ * Calcula les consultes per segon i els percentils de latència
+ * @return EstadistiquesLot estadístiques finals
+*/
+template <class Cercador>
+EstadistiquesLot ConsultesLot<Cercador>::resumeix(EstadistiquesLot e, vector<uint32_t>& latencies, double segons) {
+    e.segons = segons;
+    e.consultesPerSegon = (segons > 0) ? e.consultes / segons : 0;
+    if (latencies.empty()) return e;
+    size_t i50 = latencies.size() / 2, i99 = min(latencies.size() - 1, latencies.size() * 99 / 100);
+    nth_element(latencies.begin(), latencies.begin() + i50, latencies.end());
+    e.p50 = latencies[i50] / 1000.0;
+    nth_element(latencies.begin() + i50, latencies.begin() + i99, latencies.end());
+    e.p99 = latencies[i99] / 1000.0;
+    return e;
+}
+
+/**
+ * Respon totes les consultes d'un text (una per línia)
+ * @return EstadistiquesLot estadístiques de l'execució
+*/
+template <class Cercador>
+EstadistiquesLot ConsultesLot<Cercador>::executa(string_view consultes, ostream& sortida) {
+    chrono::steady_clock::time_point inici = chrono::steady_clock::now();
+    EstadistiquesLot e;
+    vector<uint32_t> latencies;
+    EscriptorBuffer escriptor(sortida);
+    vector<string_view> linies;
+    linies.reserve(FINESTRA);
+
+    while (!consultes.empty()) {
+        size_t salt = consultes.find('\n');
+        string_view linia = consultes.substr(0, salt);
+        consultes = (salt == string_view::npos) ? string_view() : consultes.substr(salt + 1);
+        if (!linia.empty() && linia.back() == '\r') linia.remove_suffix(1);
+        if (ignora(linia)) continue;
+        linies.push_back(linia);
+        if (linies.size() == FINESTRA) {
+            executaFinestra(linies, escriptor, latencies, e);
+            linies.clear();
+        }
+    }
+    executaFinestra(linies, escriptor, latencies, e);
+    escriptor.buida();
+    sortida.flush();
+    return resumeix(e, latencies, chrono::duration<double>(chrono::steady_clock::now() - inici).count());
+}
+
+/**
+ * Respon les consultes llegides d'un stream. Es llegeix per finestres, així es poden
+ * reproduir registres de consultes molt llargs o que arriben per una canonada
+ * @return EstadistiquesLot estadístiques de l'execució
+*/
+template <class Cercador>
+EstadistiquesLot ConsultesLot<Cercador>::executa(istream& entrada, ostream& sortida) {
+    chrono::steady_clock::time_point inici = chrono::steady_clock::now();
+    EstadistiquesLot e;
+    vector<uint32_t> latencies;
+    EscriptorBuffer escriptor(sortida);
+    vector<string> text;
+    vector<string_view> linies;
+    text.reserve(FINESTRA);
+    linies.reserve(FINESTRA);
+
+    string linia;
+    while (getline(entrada, linia)) {
+        if (!linia.empty() && linia.back() == '\r') linia.pop_back();
+        if (ignora(linia)) continue;
+        text.push_back(move(linia));
+        if (text.size() == FINESTRA) {
+            linies.assign(text.begin(), text.end());
+            executaFinestra(linies, escriptor, latencies, e);
+            text.clear();
+        }
+    }
+    linies.assign(text.begin(), text.end());
+    executaFinestra(linies, escriptor, latencies, e);
+    escriptor.buida();
+    sortida.flush();
+    return resumeix(e, latencies, chrono::duration<double>(chrono::steady_clock::now() - inici).count());
+}
+
+/**
+ * Respon les consultes d'un fitxer, que es mapeja a memòria. "-" llegeix l'entrada estàndard
+ * @return EstadistiquesLot estadístiques de l'execució
+*/
+template <class Cercador>
+EstadistiquesLot ConsultesLot<Cercador>::executaFitxer(const string& fitxer, ostream& sortida) {
+    if (fitxer == "-") return executa(cin, sortida);
+    LectorCSV lector(fitxer);
+    if (!lector.obert()) {
+        cerr << "Error: Unable to open file " << fitxer << endl;
+        return EstadistiquesLot();
+    }
+    return executa(lector.contingut(), sortida);
+}
+
+#endif /* CONSULTESLOT_H */
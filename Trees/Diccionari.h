@@ -0,0 +1,128 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * String dictionary (Diccionari).
+ * This class interns strings: every different string gets a small integer code, and the
+ * string is kept only once. Artist uses it to store gender, country and styles as codes.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - codi (intern a string): O(1) average (HashTable lookup) under a shared lock, so the threads that parse
+ *   at the same time do not wait for each other. Only a new string takes the exclusive lock and is copied.
+ * - busca (code of a string without adding it): O(1) average under the shared lock.
+ * - text (string of a code): O(1) and without locks, so it can be used from many threads.
+ * - The dictionary uses O(d) space for d different strings.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * codis : HashTable from every string to its code. The keys are string_view of the strings of blocs,
+ *         so a string_view can be looked up without building a string.
+ * blocs : The strings, stored in blocks of MIDA_BLOC that never move, so a string can be read
+ *         while another thread is adding new ones.
+ * nombre : Number of codes given. It is atomic so text() can read it without the mutex.
+ *
+ * The code 0 is always the empty string.
+ *
+ * ################################################
+ */
+
+#ifndef DICCIONARI_H
+#define DICCIONARI_H
+#include "../Hash_Tables/HashTable.h"
+#include <string>
+#include <cstdint>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <stdexcept>
+
+using namespace std;
+
+class Diccionari {
+public:
+    static const uint32_t MIDA_BLOC = 1024;
+    static const uint32_t MAX_BLOCS = 1024;
+
+    Diccionari();
+    Diccionari(const Diccionari&) = delete;
+    Diccionari& operator=(const Diccionari&) = delete;
+
+    uint32_t codi(string_view text);
+    bool busca(string_view text, uint32_t& codi) const;
+    const string& text(uint32_t codi) const;
+    uint32_t mida() const;
+
+private:
+    HashTable<string_view, uint32_t> codis;
+    unique_ptr<string[]> blocs[MAX_BLOCS];
+    atomic<uint32_t> nombre;
+    mutable shared_mutex mtx;
+};
+
+/**
+ * Constructor. El codi 0 és el text buit
+*/
+Diccionari::Diccionari(): codis(64), nombre(0) {
+    codi("");
+}
+
+/**
+ * Retorna el codi d'un text i l'afegeix al diccionari si no hi era
+ * @return uint32_t codi del text
+*/
+uint32_t Diccionari::codi(string_view text) {
+    {
+        shared_lock<shared_mutex> lock(mtx);
+        if (codis.contains(text)) return codis.get(text);
+    }
+    lock_guard<shared_mutex> lock(mtx);
+    // Un altre fil el pot haver afegit entre els dos bloquejos
+    if (codis.contains(text)) return codis.get(text);
+
+    uint32_t nou = nombre.load(memory_order_relaxed);
+    if (nou >= MIDA_BLOC * MAX_BLOCS) throw length_error("Diccionari ple\n");
+    if (nou % MIDA_BLOC == 0) blocs[nou / MIDA_BLOC].reset(new string[MIDA_BLOC]);
+    string& guardat = blocs[nou / MIDA_BLOC][nou % MIDA_BLOC];
+    guardat.assign(text.data(), text.size());
+    codis.insert(string_view(guardat), nou);
+    // El text ja és al seu lloc quan els altres fils veuen el nou nombre
+    nombre.store(nou + 1, memory_order_release);
+    return nou;
+}
+
+/**
+ * Busca el codi d'un text sense afegir-lo
+ * @return bool si el text és al diccionari
+*/
+bool Diccionari::busca(string_view text, uint32_t& codi) const {
+    shared_lock<shared_mutex> lock(mtx);
+    if (!codis.contains(text)) return false;
+    codi = codis.get(text);
+    return true;
+}
+
+/**
+ * Retorna el text d'un codi
+ * @return string& text guardat al diccionari
+*/
+const string& Diccionari::text(uint32_t codi) const {
+    if (codi >= nombre.load(memory_order_acquire)) throw out_of_range("Codi inexistent al diccionari\n");
+    return blocs[codi / MIDA_BLOC][codi % MIDA_BLOC];
+}
+
+/**
+ * Nombre de textos diferents del diccionari
+ * @return uint32_t nombre de codis
+*/
+uint32_t Diccionari::mida() const {
+    return nombre.load(memory_order_acquire);
+}
+
+#endif /* DICCIONARI_H */
@@ -0,0 +1,242 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Blocked Bloom filter of artist ids (Filtre de Bloom per blocs).
+ * It answers "this id is surely not here" or "this id may be here". The filter is split in blocks
+ * of 512 bits (one cache line, 64 bytes): the hash of an id chooses one block, and all the k bits
+ * of the id are inside that block, so a lookup reads a single cache line.
+ * Putting all the bits of a key in one block makes the filter a bit worse than a classic Bloom
+ * filter with the same memory, so the size is chosen with the false positive rate of the blocked
+ * filter (the keys of a block follow a Poisson distribution), not with the classic formula.
+ * Ids can't be removed: a removed id stays as a false positive.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - afegeix, potContenir: O(k) bit operations on one cache line.
+ * - The filter uses about 1.5 to 1.7 times -log2(p) bits per key of the capacity (1.3 MB for 1M ids and p = 1%).
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * blocs : Blocks of 512 bits aligned to a cache line.
+ * k : Bits set by every key.
+ * capacitat : Number of keys for which the filter has the false positive rate falsPositius.
+ * nClaus : Keys added that have set some new bit (an id added twice only counts once).
+ * consultes, descartades, falsosPositius : Metrics of the lookups. The caller says which
+ *     "may be here" answers were false positives with anotaFalsPositiu.
+ *
+ * ################################################
+ */
+
+#ifndef FILTREBLOOM_H
+#define FILTREBLOOM_H
+#include <vector>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+
+struct EstadistiquesBloom {
+    size_t capacitat = 0;
+    size_t claus = 0;
+    size_t bytes = 0;
+    unsigned funcions = 0;          // Bits per clau (k)
+    double objectiu = 0;            // Taxa de falsos positius configurada
+    double estimada = 0;            // Taxa esperada amb les claus actuals
+    size_t consultes = 0;
+    size_t descartades = 0;         // Consultes que el filtre ha respost sense buscar a l'índex
+    size_t falsosPositius = 0;      // Consultes que han passat el filtre però l'id no existia
+    size_t reconstruccions = 0;
+
+    double taxaFalsosPositius() const;
+};
+
+class FiltreBloom {
+public:
+    FiltreBloom(size_t capacitat, double falsPositius = 0.01);
+    FiltreBloom(const FiltreBloom&) = delete;
+    FiltreBloom& operator=(const FiltreBloom&) = delete;
+
+    bool afegeix(int artistId);
+    bool potContenir(int artistId) const;
+    void anotaFalsPositiu() const;
+    size_t capacitat() const;
+    size_t claus() const;
+    double falsPositius() const;
+    EstadistiquesBloom estadistiques() const;
+
+private:
+    static const unsigned BITS_BLOC = 512;
+
+    struct alignas(64) Bloc {
+        uint64_t paraules[BITS_BLOC / 64] = {};
+    };
+
+    vector<Bloc> blocs;
+    unsigned k;
+    size_t capacitatMaxima;
+    double objectiu;
+    size_t nClaus;
+    mutable atomic<size_t> consultes, descartades, falsosPositius;
+
+    static uint64_t barreja(uint64_t clau);
+    template <class F>
+    bool perCadaBit(uint64_t h, F f) const;
+    static double taxaBlocs(double bitsPerClau, unsigned k);
+};
+
+/**
+ * Taxa de falsos positius observada: falsos positius entre les consultes d'ids que no existeixen
+ * @return double taxa observada
+*/
+double EstadistiquesBloom::taxaFalsosPositius() const {
+    size_t negatives = descartades + falsosPositius;
+    return negatives == 0 ? 0 : static_cast<double>(falsosPositius) / negatives;
+}
+
+/**
+ * Constructor amb el nombre de claus esperades i la taxa de falsos positius desitjada (entre 0 i 1).
+ * Tria els bits per clau i k mínims que donen la taxa amb el filtre per blocs
+*/
+FiltreBloom::FiltreBloom(size_t capacitat, double falsPositius):
+    k(1), capacitatMaxima(capacitat == 0 ? 1 : capacitat), objectiu(falsPositius), nClaus(0),
+    consultes(0), descartades(0), falsosPositius(0) {
+    if (!(falsPositius > 0 && falsPositius < 1))
+        throw invalid_argument("La taxa de falsos positius ha de ser entre 0 i 1\n");
+    // Es comença per la fórmula del filtre clàssic i s'afegeixen bits fins que el filtre per blocs l'arriba
+    double bitsPerClau = max(1.0, -log(falsPositius) / (log(2.0) * log(2.0)));
+    for (;; bitsPerClau += 0.25) {
+        unsigned millor = 1;
+        for (unsigned i = 2; i <= 16; i++) {
+            if (taxaBlocs(bitsPerClau, i) < taxaBlocs(bitsPerClau, millor)) millor = i;
+        }
+        k = millor;
+        if (taxaBlocs(bitsPerClau, k) <= falsPositius || bitsPerClau >= 64) break;
+    }
+    size_t nBlocs = static_cast<size_t>(ceil(capacitatMaxima * bitsPerClau / BITS_BLOC));
+    blocs.resize(max<size_t>(1, nBlocs));
+}
+
+/**
+ * Taxa esperada del filtre per blocs amb bitsPerClau i k: cada bloc rep un nombre de claus de
+ * Poisson amb mitjana BITS_BLOC / bitsPerClau, i dins del bloc és un filtre clàssic de BITS_BLOC bits
+ * @return double taxa de falsos positius
+*/
+double FiltreBloom::taxaBlocs(double bitsPerClau, unsigned k) {
+    double mitjana = BITS_BLOC / bitsPerClau;
+    double taxa = 0, probabilitat = exp(-mitjana);
+    size_t maxim = static_cast<size_t>(mitjana + 12 * sqrt(mitjana) + 12);
+    for (size_t i = 0; i <= maxim; i++) {
+        if (i > 0) probabilitat *= mitjana / i;
+        double ocupats = 1 - pow(1 - 1.0 / BITS_BLOC, static_cast<double>(k) * i);
+        taxa += probabilitat * pow(ocupats, k);
+    }
+    return taxa;
+}
+
+/**
+ * Barreja els bits d'una clau (finalitzador de splitmix64)
+ * @return uint64_t clau barrejada
+*/
+uint64_t FiltreBloom::barreja(uint64_t clau) {
+    clau ^= clau >> 30;
+    clau *= 0xbf58476d1ce4e5b9ULL;
+    clau ^= clau >> 27;
+    clau *= 0x94d049bb133111ebULL;
+    return clau ^ (clau >> 31);
+}
+
+/**
+ * Crida a f(bit) amb els k bits d'una clau dins del seu bloc, fins que f retorna false.
+ * Cada bit són 9 bits independents d'un hash de 64 bits (7 per hash, i després es torna a barrejar)
+ * @return bool si f ha retornat true per tots els bits
+*/
+template <class F>
+bool FiltreBloom::perCadaBit(uint64_t h, F f) const {
+    uint64_t bits = barreja(h);
+    for (unsigned i = 0; i < k; i++) {
+        if (i > 0 && i % 7 == 0) bits = barreja(h + i);
+        if (!f(static_cast<uint32_t>(bits % BITS_BLOC))) return false;
+        bits /= BITS_BLOC;
+    }
+    return true;
+}
+
+/**
+ * Afegeix un id. No és segur cridar-lo alhora que potContenir des d'un altre fil
+ * @return bool si ha posat algun bit nou (si no, l'id ja hi era o és un fals positiu)
+*/
+bool FiltreBloom::afegeix(int artistId) {
+    uint64_t h = barreja(static_cast<uint32_t>(artistId));
+    Bloc& bloc = blocs[((h >> 32) * blocs.size()) >> 32];
+    bool nou = false;
+    perCadaBit(h, [&](uint32_t bit) {
+        uint64_t mascara = uint64_t(1) << (bit % 64);
+        nou |= !(bloc.paraules[bit / 64] & mascara);
+        bloc.paraules[bit / 64] |= mascara;
+        return true;
+    });
+    if (nou) nClaus++;
+    return nou;
+}
+
+/**
+ * Consulta un id. Si retorna false segur que no s'ha afegit
+ * @return bool si l'id pot ser-hi
+*/
+bool FiltreBloom::potContenir(int artistId) const {
+    uint64_t h = barreja(static_cast<uint32_t>(artistId));
+    const Bloc& bloc = blocs[((h >> 32) * blocs.size()) >> 32];
+    consultes.fetch_add(1, memory_order_relaxed);
+    bool hiEs = perCadaBit(h, [&bloc](uint32_t bit) {
+        return (bloc.paraules[bit / 64] & (uint64_t(1) << (bit % 64))) != 0;
+    });
+    if (!hiEs) descartades.fetch_add(1, memory_order_relaxed);
+    return hiEs;
+}
+
+/**
+ * Anota que una consulta que ha passat el filtre era d'un id que no existia
+*/
+void FiltreBloom::anotaFalsPositiu() const {
+    falsosPositius.fetch_add(1, memory_order_relaxed);
+}
+
+size_t FiltreBloom::capacitat() const {
+    return capacitatMaxima;
+}
+
+size_t FiltreBloom::claus() const {
+    return nClaus;
+}
+
+double FiltreBloom::falsPositius() const {
+    return objectiu;
+}
+
+/**
+ * Mida, ocupació i mètriques de les consultes del filtre
+ * @return EstadistiquesBloom estadístiques
+*/
+EstadistiquesBloom FiltreBloom::estadistiques() const {
+    EstadistiquesBloom e;
+    e.capacitat = capacitatMaxima;
+    e.claus = nClaus;
+    e.bytes = blocs.size() * sizeof(Bloc);
+    e.funcions = k;
+    e.objectiu = objectiu;
+    e.estimada = taxaBlocs(nClaus == 0 ? 1e9 : static_cast<double>(blocs.size()) * BITS_BLOC / nClaus, k);
+    e.consultes = consultes.load(memory_order_relaxed);
+    e.descartades = descartades.load(memory_order_relaxed);
+    e.falsosPositius = falsosPositius.load(memory_order_relaxed);
+    return e;
+}
+
+#endif /* FILTREBLOOM_H */
@@ -0,0 +1,221 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Synthetic catalogue generator (Generador d'artistes).
+ * It writes CSV files with the same columns as the files of Data/ (artist_id,name,gender,country,
+ * styles,playcount) and any number of rows, to see how the search engines behave with big catalogues.
+ * - The ids are 1..n in the order chosen: ORDENAT (sorted), ALEATORI (a random permutation) or
+ *   AGRUPAT (runs of midaGrup consecutive ids, with the runs in random order).
+ * - The playcounts follow Zipf's law: the artist of rank r has maxPlaycount / r^zipf plays, and
+ *   the ranks are a random permutation, so a few artists have most of the plays.
+ * - Genders, countries and styles (1 to 5 per artist) follow the frequencies of Data/usArtists.csv.
+ * The permutations are a Feistel network over the ids, so no table of n ids is kept in memory.
+ * The same configuration and llavor always write the same file.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - generaArtistes: O(n) time and O(1) space (the rows are written in blocks of 1 MB).
+ *
+ * ################################################
+ */
+
+#ifndef GENERADORARTISTES_H
+#define GENERADORARTISTES_H
+#include <string>
+#include <vector>
+#include <random>
+#include <fstream>
+#include <cmath>
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+
+struct ConfiguracioGenerador {
+    enum OrdreIds { ORDENAT, ALEATORI, AGRUPAT };
+
+    size_t files = 1000;
+    OrdreIds ordre = ALEATORI;
+    size_t midaGrup = 1024;         // Ids consecutius de cada grup (AGRUPAT)
+    double zipf = 1.0;              // Exponent de la llei de Zipf dels playcounts
+    int maxPlaycount = 400000000;   // Playcount de l'artista més escoltat
+    uint64_t llavor = 1;
+
+    static OrdreIds ordreDeText(const string& text);
+};
+
+/**
+ * Permutació pseudoaleatòria de [0, n) sense taula: una xarxa de Feistel de 4 rondes sobre el
+ * menor nombre parell de bits que cobreix n, i els valors que queden fora de [0, n) es tornen a xifrar
+*/
+class PermutacioIds {
+public:
+    PermutacioIds(uint64_t n, uint64_t llavor);
+    uint64_t operator()(uint64_t i) const;
+
+private:
+    uint64_t n;
+    unsigned bitsMeitat;
+    uint64_t mascara;
+    uint64_t claus[4];
+
+    static uint64_t barreja(uint64_t x);
+    uint64_t xifra(uint64_t x) const;
+};
+
+void generaArtistes(ostream& sortida, const ConfiguracioGenerador& c);
+void generaArtistes(const string& cami, const ConfiguracioGenerador& c);
+
+/**
+ * Tradueix "ordenat", "aleatori" o "agrupat" a l'ordre dels ids
+ * @return OrdreIds ordre
+*/
+ConfiguracioGenerador::OrdreIds ConfiguracioGenerador::ordreDeText(const string& text) {
+    if (text == "ordenat") return ORDENAT;
+    if (text == "aleatori") return ALEATORI;
+    if (text == "agrupat") return AGRUPAT;
+    throw invalid_argument("Ordre d'ids desconegut (ordenat, aleatori o agrupat): " + text + "\n");
+}
+
+PermutacioIds::PermutacioIds(uint64_t n, uint64_t llavor): n(max<uint64_t>(n, 1)), bitsMeitat(1) {
+    while ((uint64_t(1) << (2 * bitsMeitat)) < this->n) bitsMeitat++;
+    mascara = (uint64_t(1) << bitsMeitat) - 1;
+    for (int r = 0; r < 4; r++) claus[r] = barreja(llavor * 4 + r + 1);
+}
+
+/**
+ * Finalitzador de splitmix64
+ * @return uint64_t bits barrejats
+*/
+uint64_t PermutacioIds::barreja(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+uint64_t PermutacioIds::xifra(uint64_t x) const {
+    uint64_t esquerra = x >> bitsMeitat, dreta = x & mascara;
+    for (int r = 0; r < 4; r++) {
+        uint64_t nova = esquerra ^ (barreja(dreta ^ claus[r]) & mascara);
+        esquerra = dreta;
+        dreta = nova;
+    }
+    return (esquerra << bitsMeitat) | dreta;
+}
+
+/**
+ * Imatge de i dins de [0, n). Com que el domini de la xarxa és com a molt 4 vegades n, cal
+ * tornar a xifrar de mitjana menys de 4 cops
+ * @return uint64_t posició permutada
+*/
+uint64_t PermutacioIds::operator()(uint64_t i) const {
+    uint64_t x = xifra(i);
+    while (x >= n) x = xifra(x);
+    return x;
+}
+
+/**
+ * Escriu un catàleg sintètic en format CSV (amb la capçalera)
+*/
+void generaArtistes(ostream& sortida, const ConfiguracioGenerador& c) {
+    if (c.files > static_cast<size_t>(INT_MAX)) throw invalid_argument("Massa files: els ids han de cabre en un int\n");
+    static const char* const GENERES[] = {"undefined", "male", "female", "non-binary", "genderfluid", "trans woman"};
+    static const double PES_GENERES[] = {2635, 1045, 398, 4, 2, 2};
+    static const char* const PAISOS[] = {"United States", "United Kingdom", "Spain", "Canada", "Germany", "France",
+        "Sweden", "Australia", "Japan", "Brazil", "Mexico", "Italy", "Norway", "Netherlands", "Argentina",
+        "South Korea", "Finland", "Ireland", "Colombia", "Belgium", "Puerto Rico", "Chile", "Denmark", "Poland"};
+    static const char* const ESTILS[] = {"rock", "rap", "pop", "electronic", "experimental", "folk", "punk", "soul",
+        "hardcore", "emo", "metal", "jazz", "ambient", "country", "metalcore", "funk", "blues", "screamo",
+        "shoegaze", "electronica", "industrial", "synthpop", "grindcore", "electro", "noise", "reggae", "drone",
+        "comedy", "ska", "mathcore"};
+    static const double PES_ESTILS[] = {918, 718, 585, 493, 365, 347, 315, 314, 279, 209, 192, 190, 138, 132, 131,
+        123, 112, 101, 82, 66, 63, 58, 58, 41, 39, 35, 35, 35, 32, 32};
+    static const double PES_NOMBRE_ESTILS[] = {2109, 1326, 534, 104, 17};
+    static const char* const ADJECTIUS[] = {"Black", "Crimson", "Silver", "Golden", "Velvet", "Electric", "Broken",
+        "Midnight", "Wild", "Lost", "Young", "Little", "Big", "Neon", "Hollow", "Paper", "Glass", "Iron", "Blue",
+        "Red", "Secret", "Holy", "Dead", "Sweet", "Lonely", "Burning", "Cosmic", "Quiet", "Savage", "Gentle"};
+    static const char* const NOMS[] = {"Owls", "Tide", "Hearts", "Wolves", "Ghosts", "Rivers", "Kings", "Echoes",
+        "Machines", "Saints", "Lights", "Foxes", "Dreams", "Shadows", "Bones", "Waves", "Roses", "Tigers",
+        "Stars", "Horses", "Mirrors", "Angels", "Giants", "Birds", "Flames", "Sons", "Daughters", "Storms"};
+    const size_t N_PAISOS = sizeof(PAISOS) / sizeof(PAISOS[0]);
+
+    mt19937_64 aleatori(c.llavor);
+    discrete_distribution<int> genere(begin(PES_GENERES), end(PES_GENERES));
+    discrete_distribution<int> estil(begin(PES_ESTILS), end(PES_ESTILS));
+    discrete_distribution<int> nombreEstils(begin(PES_NOMBRE_ESTILS), end(PES_NOMBRE_ESTILS));
+    vector<double> pesPaisos(N_PAISOS);
+    for (size_t i = 0; i < N_PAISOS; i++) pesPaisos[i] = 1.0 / pow(i + 1.0, 1.5);
+    discrete_distribution<int> pais(pesPaisos.begin(), pesPaisos.end());
+    uniform_int_distribution<size_t> adjectiu(0, sizeof(ADJECTIUS) / sizeof(ADJECTIUS[0]) - 1);
+    uniform_int_distribution<size_t> nom(0, sizeof(NOMS) / sizeof(NOMS[0]) - 1);
+
+    // Amb AGRUPAT només es barregen els grups complets, i l'últim grup incomplet queda al final
+    size_t midaGrup = max<size_t>(c.midaGrup, 1);
+    size_t grups = c.files / midaGrup;
+    PermutacioIds permutacioIds(c.files, c.llavor), permutacioGrups(grups, c.llavor + 1), rangs(c.files, c.llavor + 2);
+
+    string bloc = "artist_id,name,gender,country,styles,playcount\n";
+    bloc.reserve((1 << 20) + 256);
+    char nombre[16];
+    auto escriuEnter = [&](uint64_t valor) {
+        char* fi = to_chars(nombre, nombre + sizeof(nombre), valor).ptr;
+        bloc.append(nombre, fi);
+    };
+    for (size_t i = 0; i < c.files; i++) {
+        uint64_t posicio = i;
+        if (c.ordre == ConfiguracioGenerador::ALEATORI) posicio = permutacioIds(i);
+        else if (c.ordre == ConfiguracioGenerador::AGRUPAT && i / midaGrup < grups)
+            posicio = permutacioGrups(i / midaGrup) * midaGrup + i % midaGrup;
+        escriuEnter(posicio + 1);
+        bloc += ',';
+        bloc += ADJECTIUS[adjectiu(aleatori)];
+        bloc += ' ';
+        bloc += NOMS[nom(aleatori)];
+        bloc += ',';
+        bloc += GENERES[genere(aleatori)];
+        bloc += ',';
+        bloc += PAISOS[pais(aleatori)];
+        bloc += ',';
+        int escollits[5], n = nombreEstils(aleatori) + 1;
+        for (int e = 0; e < n; e++) {
+            // Els estils d'un artista no es repeteixen
+            int candidat;
+            do { candidat = estil(aleatori); } while (find(escollits, escollits + e, candidat) != escollits + e);
+            escollits[e] = candidat;
+            if (e > 0) bloc += '|';
+            bloc += ESTILS[candidat];
+        }
+        bloc += ',';
+        double rang = static_cast<double>(rangs(i) + 1);
+        escriuEnter(static_cast<uint64_t>(max(1.0, floor(c.maxPlaycount / pow(rang, c.zipf)))));
+        bloc += '\n';
+        if (bloc.size() >= (1 << 20)) {
+            sortida.write(bloc.data(), static_cast<streamsize>(bloc.size()));
+            bloc.clear();
+        }
+    }
+    sortida.write(bloc.data(), static_cast<streamsize>(bloc.size()));
+}
+
+/**
+ * Escriu un catàleg sintètic al fitxer cami
+*/
+void generaArtistes(const string& cami, const ConfiguracioGenerador& c) {
+    ofstream sortida(cami, ios::binary | ios::trunc);
+    if (!sortida.is_open()) throw runtime_error("Error: Unable to open file " + cami + "\n");
+    generaArtistes(sortida, c);
+    sortida.flush();
+    if (!sortida) throw runtime_error("No s'ha pogut escriure " + cami + "\n");
+}
+
+#endif /* GENERADORARTISTES_H */
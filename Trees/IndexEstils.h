@@ -0,0 +1,351 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Inverted index of styles (Índex d'estils).
+ * This class maps every style token (the styles of an artist are split on '|') to the sorted
+ * list of the identifiers of the artists that have it (posting list), and answers
+ * AND / OR / NOT queries over several styles with set operations on those lists.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - afegeix: O(t) amortized, where t is the number of styles of the artist (the ids are appended).
+ *   The styles string is only split the first time its dictionary code (Artist::getStylesCode) is seen.
+ * - The lists are sorted the first time they are read after an insertion: O(m log m) for a list of m ids,
+ *   and O(m) if the ids were added in increasing order.
+ * - llista: O(1) after the list is sorted.
+ * - interseccio: O(a + b), 4 ids at a time with SSE2 when it is available,
+ *   or O(a log b) with galloping search when one list is much shorter.
+ * - unio, diferencia: O(a + b).
+ * - consulta: O(sum of the sizes of the lists involved).
+ * - The index uses O(total number of (style, artist) pairs) space.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * codis : HashTable from a style token to its position in llistes.
+ * llistes : Posting list of every style, with its token and a flag that says if it is already sorted.
+ * tots : Posting list of all the artists, used by the NOT queries.
+ * estilsPerConjunt : For every styles code, the positions in llistes of its style tokens.
+ *
+ * ################################################
+ *
+ * ################################################
+ * METHODS
+ *
+ * MODIFIERS  #####################################
+ *
+ * afegeix : Adds an artist id to the list of each of its styles.
+ *
+ * CONSULTORS #####################################
+ *
+ * llista : Returns the sorted posting list of a style (empty if the style does not exist).
+ * nombreEstils : Returns the number of different styles.
+ * posicio : Returns the position of a style token (its number inside the index).
+ * posicions : Returns the positions of the style tokens of a styles code already added.
+ * nom : Returns the style token of a position.
+ *
+ * OPERATIONS #####################################
+ *
+ * consulta : Returns the artists that have all the styles of "totes", at least one of "algun"
+ *            (if it is not empty) and none of "cap".
+ * interseccio, unio, diferencia : Set operations on sorted lists.
+ * perCadaEstil : Calls a function with every style token of a styles string.
+ *
+ * ################################################
+ */
+
+#ifndef INDEXESTILS_H
+#define INDEXESTILS_H
+#include "../Hash_Tables/HashTable.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define INDEXESTILS_SSE2
+#endif
+
+using namespace std;
+
+class IndexEstils {
+public:
+    IndexEstils();
+    IndexEstils(const IndexEstils&) = delete;
+    IndexEstils& operator=(const IndexEstils&) = delete;
+
+    void afegeix(int artistId, uint32_t codiEstils, string_view styles);
+
+    const vector<int>& llista(const string& estil) const;
+    bool posicio(const string& estil, uint32_t& posicio) const;
+    const vector<uint32_t>& posicions(uint32_t codiEstils) const;
+    const string& nom(uint32_t posicio) const;
+    size_t nombreEstils() const;
+    vector<int> consulta(const list<string>& totes, const list<string>& algun, const list<string>& cap) const;
+
+    static vector<int> interseccio(const vector<int>& a, const vector<int>& b);
+    static vector<int> unio(const vector<int>& a, const vector<int>& b);
+    static vector<int> diferencia(const vector<int>& a, const vector<int>& b);
+    template <class F>
+    static void perCadaEstil(string_view styles, F f);
+
+private:
+    struct LlistaEstil {
+        string nom;
+        vector<int> ids;
+        bool ordenada = true;
+    };
+
+    HashTable<string, size_t> codis;
+    mutable vector<LlistaEstil> llistes;
+    mutable LlistaEstil tots;
+    mutable mutex mtxOrdena;
+    mutable atomic<size_t> perOrdenar; // Llistes que encara s'han d'ordenar
+    vector<vector<uint32_t>> estilsPerConjunt;
+    vector<bool> conjuntConegut;
+
+    void afegeixA(LlistaEstil& l, int artistId);
+    const vector<int>& ordenada(LlistaEstil& l) const;
+    static void interseccioEscalar(const int* a, size_t na, const int* b, size_t nb, size_t i, size_t j, vector<int>& resultat);
+    static vector<int> interseccioGalop(const vector<int>& petita, const vector<int>& gran);
+};
+
+/**
+ * Constructor sense paràmetres
+*/
+IndexEstils::IndexEstils(): codis(64), perOrdenar(0) {}
+
+/**
+ * Crida a f(estil) per cada estil d'un string d'estils separats per '|'
+*/
+template <class F>
+void IndexEstils::perCadaEstil(string_view styles, F f) {
+    while (!styles.empty()) {
+        size_t barra = styles.find('|');
+        string_view estil = styles.substr(0, barra);
+        if (!estil.empty()) f(estil);
+        if (barra == string_view::npos) break;
+        styles.remove_prefix(barra + 1);
+    }
+}
+
+/**
+ * Afegeix l'artista a la llista de cadascun dels seus estils.
+ * codiEstils és el codi de diccionari del text dels estils: si ja s'ha vist, no cal tornar a partir el text.
+*/
+void IndexEstils::afegeix(int artistId, uint32_t codiEstils, string_view styles) {
+    afegeixA(tots, artistId);
+    if (codiEstils >= conjuntConegut.size()) {
+        conjuntConegut.resize(codiEstils + 1, false);
+        estilsPerConjunt.resize(codiEstils + 1);
+    }
+    if (!conjuntConegut[codiEstils]) {
+        vector<uint32_t>& posicions = estilsPerConjunt[codiEstils];
+        perCadaEstil(styles, [this, &posicions](string_view estil) {
+            string clau(estil);
+            if (!codis.contains(clau)) {
+                codis.insert(clau, llistes.size());
+                llistes.emplace_back();
+                llistes.back().nom = clau;
+            }
+            uint32_t posicio = static_cast<uint32_t>(codis.get(clau));
+            // Un estil repetit dins del mateix text només es compta un cop
+            if (find(posicions.begin(), posicions.end(), posicio) == posicions.end()) posicions.push_back(posicio);
+        });
+        conjuntConegut[codiEstils] = true;
+    }
+    for (uint32_t posicio : estilsPerConjunt[codiEstils]) afegeixA(llistes[posicio], artistId);
+}
+
+void IndexEstils::afegeixA(LlistaEstil& l, int artistId) {
+    if (l.ordenada && !l.ids.empty() && artistId < l.ids.back()) {
+        l.ordenada = false;
+        perOrdenar++;
+    }
+    l.ids.push_back(artistId);
+}
+
+/**
+ * Ordena la llista si cal. Les lectures concurrents estan protegides amb un mutex
+ * @return vector<int> ids ordenats
+*/
+const vector<int>& IndexEstils::ordenada(LlistaEstil& l) const {
+    if (perOrdenar == 0) return l.ids;
+    lock_guard<mutex> lock(mtxOrdena);
+    if (!l.ordenada) {
+        sort(l.ids.begin(), l.ids.end());
+        l.ids.erase(unique(l.ids.begin(), l.ids.end()), l.ids.end());
+        l.ordenada = true;
+        perOrdenar--;
+    }
+    return l.ids;
+}
+
+/**
+ * Retorna la llista ordenada d'artistes d'un estil
+ * @return vector<int> ids dels artistes amb l'estil
+*/
+const vector<int>& IndexEstils::llista(const string& estil) const {
+    static const vector<int> buida;
+    if (!codis.contains(estil)) return buida;
+    return ordenada(llistes[codis.get(estil)]);
+}
+
+/**
+ * Busca la posició d'un estil dins de l'índex
+ * @return bool si l'estil existeix
+*/
+bool IndexEstils::posicio(const string& estil, uint32_t& posicio) const {
+    if (!codis.contains(estil)) return false;
+    posicio = static_cast<uint32_t>(codis.get(estil));
+    return true;
+}
+
+/**
+ * Retorna les posicions dels estils d'un codi d'estils que ja s'ha afegit
+ * @return vector<uint32_t> posicions dels estils
+*/
+const vector<uint32_t>& IndexEstils::posicions(uint32_t codiEstils) const {
+    static const vector<uint32_t> cap;
+    return (codiEstils < estilsPerConjunt.size()) ? estilsPerConjunt[codiEstils] : cap;
+}
+
+/**
+ * Retorna el text de l'estil d'una posició
+ * @return string estil
+*/
+const string& IndexEstils::nom(uint32_t posicio) const {
+    return llistes.at(posicio).nom;
+}
+
+size_t IndexEstils::nombreEstils() const {
+    return llistes.size();
+}
+
+/**
+ * Consulta combinada: (AND de totes) AND (OR de algun) AND NOT (OR de cap)
+ * @return vector<int> ids ordenats dels artistes que compleixen la consulta
+*/
+vector<int> IndexEstils::consulta(const list<string>& totes, const list<string>& algun, const list<string>& cap) const {
+    // Les interseccions es fan de la llista més curta a la més llarga
+    vector<const vector<int>*> conjunts;
+    for (const string& estil : totes) conjunts.push_back(&llista(estil));
+    sort(conjunts.begin(), conjunts.end(), [](const vector<int>* a, const vector<int>* b) { return a->size() < b->size(); });
+
+    vector<int> resultat;
+    if (!algun.empty()) {
+        for (const string& estil : algun) resultat = unio(resultat, llista(estil));
+        for (const vector<int>* c : conjunts) resultat = interseccio(resultat, *c);
+    }
+    else if (!conjunts.empty()) {
+        resultat = *conjunts.front();
+        for (size_t i = 1; i < conjunts.size() && !resultat.empty(); i++) resultat = interseccio(resultat, *conjunts[i]);
+    }
+    else resultat = ordenada(tots);
+
+    for (const string& estil : cap) {
+        if (resultat.empty()) break;
+        resultat = diferencia(resultat, llista(estil));
+    }
+    return resultat;
+}
+
+/**
+ * Intersecció de dues llistes ordenades i sense repetits
+ * @return vector<int> ids que són a les dues llistes
+*/
+vector<int> IndexEstils::interseccio(const vector<int>& a, const vector<int>& b) {
+    if (a.size() > b.size()) return interseccio(b, a);
+    if (a.empty()) return vector<int>();
+    // Si una llista és molt més curta és millor buscar cada id amb cerca exponencial
+    if (a.size() * 32 < b.size()) return interseccioGalop(a, b);
+
+    vector<int> resultat;
+    resultat.reserve(a.size());
+    size_t i = 0, j = 0;
+#ifdef INDEXESTILS_SSE2
+    // Es comparen 4 ids de cada llista alhora: tots els parells amb 4 rotacions del bloc de b
+    while (i + 4 <= a.size() && j + 4 <= b.size()) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.data() + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.data() + j));
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(va, vb), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x39))),
+            _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x4E)), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x93))));
+        int mascara = _mm_movemask_ps(_mm_castsi128_ps(m));
+        for (int k = 0; k < 4; k++) {
+            if (mascara & (1 << k)) resultat.push_back(a[i + k]);
+        }
+        int maxA = a[i + 3], maxB = b[j + 3];
+        if (maxA <= maxB) i += 4;
+        if (maxB <= maxA) j += 4;
+    }
+#endif
+    interseccioEscalar(a.data(), a.size(), b.data(), b.size(), i, j, resultat);
+    return resultat;
+}
+
+void IndexEstils::interseccioEscalar(const int* a, size_t na, const int* b, size_t nb, size_t i, size_t j, vector<int>& resultat) {
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) i++;
+        else if (b[j] < a[i]) j++;
+        else {
+            resultat.push_back(a[i]);
+            i++;
+            j++;
+        }
+    }
+}
+
+/**
+ * Intersecció buscant cada id de la llista petita a la gran amb cerca exponencial
+ * @return vector<int> ids que són a les dues llistes
+*/
+vector<int> IndexEstils::interseccioGalop(const vector<int>& petita, const vector<int>& gran) {
+    vector<int> resultat;
+    auto inici = gran.begin();
+    for (int id : petita) {
+        size_t salt = 1;
+        auto fi = inici;
+        while (fi != gran.end() && *fi < id) {
+            inici = fi;
+            fi = (static_cast<size_t>(gran.end() - fi) > salt) ? fi + salt : gran.end();
+            salt *= 2;
+        }
+        inici = lower_bound(inici, fi, id);
+        if (inici == gran.end()) break;
+        if (*inici == id) resultat.push_back(id);
+    }
+    return resultat;
+}
+
+/**
+ * Unió de dues llistes ordenades
+ * @return vector<int> ids que són en alguna de les dues llistes
+*/
+vector<int> IndexEstils::unio(const vector<int>& a, const vector<int>& b) {
+    vector<int> resultat;
+    resultat.reserve(a.size() + b.size());
+    set_union(a.begin(), a.end(), b.begin(), b.end(), back_inserter(resultat));
+    return resultat;
+}
+
+/**
+ * Diferència de dues llistes ordenades
+ * @return vector<int> ids de a que no són a b
+*/
+vector<int> IndexEstils::diferencia(const vector<int>& a, const vector<int>& b) {
+    vector<int> resultat;
+    resultat.reserve(a.size());
+    set_difference(a.begin(), a.end(), b.begin(), b.end(), back_inserter(resultat));
+    return resultat;
+}
+
+#endif /* INDEXESTILS_H */
@@ -0,0 +1,476 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Secondary indexes of the artist search engines (Índexs secundaris).
+ * CercadorArtistes and CercadorArtistesAVL index the artists by artistId in their tree.
+ * This class keeps the other indexes, so both search engines can answer queries on other
+ * fields without walking the whole tree. The search engine must call afegeix every time it
+ * inserts an artist and canviaPlaycount (before changing the Artist) every time it changes a playcount.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - afegeix and canviaPlaycount: O(log n + m), where m is the length of the name.
+ * - afegeixLot: O(n log n) to sort the keys plus O(n) to build the indexes if they are empty.
+ * - comptaPlaycount: O(log n).
+ * - recorrePlaycount: O(log n + k), where k is the number of artists reported.
+ * - comptaRang, recorreRang: see ArbreKD once activaArbreRangs has been called, else O(n) scans of the table.
+ * - artistesPerEstil: O(1) (O(m log m) the first time after inserting unsorted ids), consultaEstils: see IndexEstils.
+ * - artistesPerNom: O(m), completaNom, aproximaNom: see TrieNoms.
+ * - top: O(k + log n) with the playcount index if the filter only has a minimum playcount, else see TaulaArtistes.
+ * - mida, artistesAmbPais, artistesAmbGenere: O(1) (statistics for the query planner).
+ * - compta, filtra, sumaPlaycount: O(n / fils) vectorized scans of the columnar table.
+ * - agrupa: O(n / fils) hash aggregation of the table (see TaulaArtistes) plus O(g log g) to sort the g groups.
+ * - O(n) space.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * indexPlaycount : Order statistic tree of (playcount, artistId) pairs.
+ * indexEstils : Inverted index from every style token to the sorted ids of its artists.
+ * indexNoms : Radix trie of the normalized names, with the best playcount of every subtree.
+ * perPais, perGenere : Number of artists of every country and gender code.
+ * observadors : Functions called with every artist added or changed (for example to invalidate caches).
+ * arbreRangs : k-d tree of (artistId, playcount) points for the queries on both fields, null until activated.
+ * taula : Columnar copy of ids, playcounts, countries, genders and styles for the filter and aggregate scans.
+ *
+ * ################################################
+ */
+
+#ifndef INDEXOSARTISTES_H
+#define INDEXOSARTISTES_H
+#include "Artist.h"
+#include "ArbreEstadistic.h"
+#include "IndexEstils.h"
+#include "TaulaArtistes.h"
+#include "TrieNoms.h"
+#include "ArbreKD.h"
+#include <vector>
+#include <climits>
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <memory>
+
+using namespace std;
+
+class IndexosArtistes {
+public:
+    IndexosArtistes();
+
+    void afegeix(const Artist& a);
+    void afegeixLot(const vector<const Artist*>& artistes);
+    void canviaPlaycount(const Artist& a, int nou);
+    void afegeixObservador(function<void(const Artist&)> observador);
+
+    size_t comptaPlaycount(int minim, int maxim = INT_MAX) const;
+    template <class F>
+    void recorrePlaycount(int minim, int maxim, F f) const;
+
+    void activaArbreRangs();
+    bool arbreRangsActiu() const;
+    size_t comptaRang(int idMinim, int idMaxim, int minim, int maxim) const;
+    template <class F>
+    void recorreRang(int idMinim, int idMaxim, int minim, int maxim, F f) const;
+
+    const vector<int>& artistesPerEstil(const string& estil) const;
+    vector<int> consultaEstils(const list<string>& totes, const list<string>& algun, const list<string>& cap) const;
+
+    vector<int> artistesPerNom(const string& nom) const;
+    vector<int> completaNom(const string& prefix, size_t k) const;
+    vector<int> aproximaNom(const string& nom, unsigned distancia, size_t k) const;
+
+    FiltreCodis tradueix(const FiltreArtistes& f) const;
+    size_t compta(const FiltreArtistes& f, unsigned fils = 1) const;
+    vector<int> filtra(const FiltreArtistes& f, unsigned fils = 1) const;
+    long long sumaPlaycount(const FiltreArtistes& f, unsigned fils = 1) const;
+    vector<int> top(const FiltreArtistes& f, size_t k, unsigned fils = 1) const;
+    vector<pair<int, int>> topAmbPlaycount(const FiltreArtistes& f, size_t k, unsigned fils = 1) const;
+    vector<GrupArtistes> agrupa(const FiltreArtistes& f, unsigned camps, unsigned fils = 1) const;
+    const TaulaArtistes& taulaArtistes() const;
+
+    size_t mida() const;
+    size_t artistesAmbPais(uint32_t codi) const;
+    size_t artistesAmbGenere(uint32_t codi) const;
+
+private:
+    ArbreEstadistic<pair<int, int>> indexPlaycount; // (playcount, artistId)
+    IndexEstils indexEstils;
+    TrieNoms indexNoms;
+    TaulaArtistes taula;
+    unique_ptr<ArbreKD> arbreRangs;                 // (artistId, playcount), nul si no està activat
+    vector<size_t> perPais;
+    vector<size_t> perGenere;
+    list<function<void(const Artist&)>> observadors;
+
+    void comptaCodis(const Artist& a);
+
+    void avisa(const Artist& a) const;
+};
+
+/**
+ * Constructor sense paràmetres
+*/
+IndexosArtistes::IndexosArtistes() {}
+
+/**
+ * Afegeix un artista acabat d'inserir a tots els índexs
+*/
+void IndexosArtistes::afegeix(const Artist& a) {
+    indexPlaycount.insereix(make_pair(a.getPlaycount(), a.getArtistId()));
+    indexEstils.afegeix(a.getArtistId(), a.getStylesCode(), a.stylesView());
+    indexNoms.insereix(a.nameView(), a.getArtistId(), a.getPlaycount());
+    taula.afegeix(a, indexEstils.posicions(a.getStylesCode()));
+    if (arbreRangs) arbreRangs->afegeix(a.getArtistId(), a.getPlaycount());
+    comptaCodis(a);
+    avisa(a);
+}
+
+/**
+ * Afegeix molts artistes de cop. Si els índexs són buits es construeixen ordenats en O(n)
+*/
+void IndexosArtistes::afegeixLot(const vector<const Artist*>& artistes) {
+    if (!indexPlaycount.esBuit()) {
+        // Amb molts artistes surt més a compte tornar a construir l'arbre k-d un sol cop al final
+        bool reconstrueix = arbreRangs && artistes.size() > ArbreKD::MIN_PENDENTS;
+        if (reconstrueix) arbreRangs.reset();
+        for (const Artist* a : artistes) afegeix(*a);
+        if (reconstrueix) activaArbreRangs();
+        return;
+    }
+    vector<pair<int, int>> claus;
+    claus.reserve(artistes.size());
+    for (const Artist* a : artistes) {
+        claus.emplace_back(a->getPlaycount(), a->getArtistId());
+        indexEstils.afegeix(a->getArtistId(), a->getStylesCode(), a->stylesView());
+        indexNoms.insereix(a->nameView(), a->getArtistId(), a->getPlaycount());
+        taula.afegeix(*a, indexEstils.posicions(a->getStylesCode()));
+        comptaCodis(*a);
+        avisa(*a);
+    }
+    indexNoms.compacta();
+    sort(claus.begin(), claus.end());
+    claus.erase(unique(claus.begin(), claus.end()), claus.end());
+    indexPlaycount.construeixOrdenat(claus);
+    if (arbreRangs) activaArbreRangs();
+}
+
+/**
+ * Actualitza els índexs quan canvia el playcount d'un artista. a és l'artista amb el playcount anterior
+*/
+void IndexosArtistes::canviaPlaycount(const Artist& a, int nou) {
+    indexPlaycount.esborra(make_pair(a.getPlaycount(), a.getArtistId()));
+    indexPlaycount.insereix(make_pair(nou, a.getArtistId()));
+    indexNoms.canviaPlaycount(a.nameView(), a.getArtistId(), nou);
+    taula.canviaPlaycount(a.getArtistId(), nou);
+    if (arbreRangs) arbreRangs->canvia(a.getArtistId(), a.getPlaycount(), nou);
+    avisa(a);
+}
+
+/**
+ * Afegeix una funció que es crida amb cada artista afegit o modificat
+*/
+void IndexosArtistes::afegeixObservador(function<void(const Artist&)> observador) {
+    observadors.push_back(observador);
+}
+
+/**
+ * Crida a tots els observadors amb l'artista afegit o modificat
+*/
+void IndexosArtistes::avisa(const Artist& a) const {
+    for (const function<void(const Artist&)>& observador : observadors) observador(a);
+}
+
+/**
+ * Compta els artistes amb playcount dins de [minim, maxim]
+ * @return size_t nombre d'artistes
+*/
+size_t IndexosArtistes::comptaPlaycount(int minim, int maxim) const {
+    if (maxim < minim) return 0;
+    return indexPlaycount.comptaMenorsOIguals(make_pair(maxim, INT_MAX))
+         - indexPlaycount.comptaMenors(make_pair(minim, INT_MIN));
+}
+
+/**
+ * Crida a f(artistId, playcount) per cada artista amb playcount dins de [minim, maxim], de menys a més playcount
+*/
+template <class F>
+void IndexosArtistes::recorrePlaycount(int minim, int maxim, F f) const {
+    if (maxim < minim) return;
+    indexPlaycount.recorreRang(make_pair(minim, INT_MIN), make_pair(maxim, INT_MAX),
+        [&f](const pair<int, int>& clau) { f(clau.second, clau.first); });
+}
+
+/**
+ * Construeix l'arbre k-d de (artistId, playcount) amb els artistes de la taula. Des d'aleshores
+ * afegeix i canviaPlaycount el mantenen i comptaRang i recorreRang no recorren tota la taula
+*/
+void IndexosArtistes::activaArbreRangs() {
+    const vector<int>& ids = taula.columnaIds();
+    const vector<int>& playcounts = taula.columnaPlaycounts();
+    vector<PuntKD> punts(ids.size());
+    for (size_t i = 0; i < ids.size(); i++) punts[i] = PuntKD{ids[i], playcounts[i]};
+    if (!arbreRangs) arbreRangs.reset(new ArbreKD());
+    arbreRangs->construeix(std::move(punts));
+}
+
+bool IndexosArtistes::arbreRangsActiu() const {
+    return arbreRangs != nullptr;
+}
+
+/**
+ * Compta els artistes amb l'id dins de [idMinim, idMaxim] i el playcount dins de [minim, maxim]
+ * @return size_t nombre d'artistes
+*/
+size_t IndexosArtistes::comptaRang(int idMinim, int idMaxim, int minim, int maxim) const {
+    if (arbreRangs) return arbreRangs->compta(idMinim, idMaxim, minim, maxim);
+    const vector<int>& ids = taula.columnaIds();
+    const vector<int>& playcounts = taula.columnaPlaycounts();
+    size_t total = 0;
+    for (size_t i = 0; i < ids.size(); i++) {
+        total += (ids[i] >= idMinim) & (ids[i] <= idMaxim) & (playcounts[i] >= minim) & (playcounts[i] <= maxim);
+    }
+    return total;
+}
+
+/**
+ * Crida a f(artistId, playcount) amb cada artista dins dels dos rangs, sense cap ordre
+*/
+template <class F>
+void IndexosArtistes::recorreRang(int idMinim, int idMaxim, int minim, int maxim, F f) const {
+    if (arbreRangs) {
+        arbreRangs->recorre(idMinim, idMaxim, minim, maxim, f);
+        return;
+    }
+    const vector<int>& ids = taula.columnaIds();
+    const vector<int>& playcounts = taula.columnaPlaycounts();
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (ids[i] >= idMinim && ids[i] <= idMaxim && playcounts[i] >= minim && playcounts[i] <= maxim) f(ids[i], playcounts[i]);
+    }
+}
+
+/**
+ * Retorna els artistes que tenen exactament l'estil entrat (un dels estils separats per '|')
+ * @return vector<int> ids ordenats
+*/
+const vector<int>& IndexosArtistes::artistesPerEstil(const string& estil) const {
+    return indexEstils.llista(estil);
+}
+
+/**
+ * Consulta d'estils combinada: tots els estils de "totes", algun de "algun" i cap de "cap"
+ * @return vector<int> ids ordenats
+*/
+vector<int> IndexosArtistes::consultaEstils(const list<string>& totes, const list<string>& algun, const list<string>& cap) const {
+    return indexEstils.consulta(totes, algun, cap);
+}
+
+/**
+ * Retorna els artistes amb aquest nom, sense distingir majúscules ni accents
+ * @return vector<int> ids ordenats
+*/
+vector<int> IndexosArtistes::artistesPerNom(const string& nom) const {
+    return indexNoms.cerca(nom);
+}
+
+/**
+ * Retorna els k artistes amb més playcount dels noms que comencen pel prefix
+ * @return vector<int> ids de més a menys playcount
+*/
+vector<int> IndexosArtistes::completaNom(const string& prefix, size_t k) const {
+    return indexNoms.completa(prefix, k);
+}
+
+/**
+ * Retorna els k artistes amb el nom més semblant: a distància d'edició com a molt distancia
+ * @return vector<int> ids per distància i, a igual distància, de més a menys playcount
+*/
+vector<int> IndexosArtistes::aproximaNom(const string& nom, unsigned distancia, size_t k) const {
+    return indexNoms.aproximada(nom, distancia, k);
+}
+
+/**
+ * Tradueix un filtre amb textos a codis de diccionari. Si algun text no existeix, cap artista el compleix
+ * @return FiltreCodis filtre per a la taula
+*/
+FiltreCodis IndexosArtistes::tradueix(const FiltreArtistes& f) const {
+    FiltreCodis codis;
+    codis.minPlaycount = f.minPlaycount;
+    codis.maxPlaycount = f.maxPlaycount;
+    uint32_t c;
+    if (!f.pais.empty()) {
+        if (Artist::paisos().busca(f.pais, c)) codis.pais = static_cast<int>(c);
+        else codis.impossible = true;
+    }
+    if (!f.genere.empty()) {
+        if (Artist::generes().busca(f.genere, c)) codis.genere = static_cast<int>(c);
+        else codis.impossible = true;
+    }
+    for (const string& estil : f.estils) {
+        if (indexEstils.posicio(estil, c)) codis.estils.push_back(c);
+        else codis.impossible = true;
+    }
+    return codis;
+}
+
+/**
+ * Compta els artistes que compleixen el filtre recorrent la taula per columnes
+ * @return size_t nombre d'artistes
+*/
+size_t IndexosArtistes::compta(const FiltreArtistes& f, unsigned fils) const {
+    return taula.compta(tradueix(f), fils);
+}
+
+/**
+ * Retorna els artistes que compleixen el filtre
+ * @return vector<int> ids ordenats
+*/
+vector<int> IndexosArtistes::filtra(const FiltreArtistes& f, unsigned fils) const {
+    return taula.filtra(tradueix(f), fils);
+}
+
+/**
+ * Suma el playcount dels artistes que compleixen el filtre
+ * @return long long suma de reproduccions
+*/
+long long IndexosArtistes::sumaPlaycount(const FiltreArtistes& f, unsigned fils) const {
+    return taula.sumaPlaycount(tradueix(f), fils);
+}
+
+/**
+ * Retorna els k artistes amb més playcount que compleixen el filtre. Sense filtres de país, gènere,
+ * estils ni playcount màxim es recorre l'índex de playcount de més a menys; si no, la taula
+ * @return vector<int> ids de més a menys playcount (a igual playcount, per id)
+*/
+vector<int> IndexosArtistes::top(const FiltreArtistes& f, size_t k, unsigned fils) const {
+    vector<int> ids;
+    for (const pair<int, int>& p : topAmbPlaycount(f, k, fils)) ids.push_back(p.second);
+    return ids;
+}
+
+/**
+ * Com top, però amb el playcount de cada artista (per fusionar el top de diversos cercadors)
+ * @return vector<pair<int, int>> (playcount, artistId) de més a menys playcount, a igual playcount per id
+*/
+vector<pair<int, int>> IndexosArtistes::topAmbPlaycount(const FiltreArtistes& f, size_t k, unsigned fils) const {
+    if (k == 0) return vector<pair<int, int>>();
+    if (!f.pais.empty() || !f.genere.empty() || !f.estils.empty() || f.maxPlaycount != INT_MAX) {
+        return taula.top(tradueix(f), k, fils);
+    }
+
+    // L'índex dona els empats per id de més gran a més petit. Es baixa fins a la k-èsima clau, cada grup
+    // empatat sencer es gira, i els llocs del grup de l'última (que pot ser a mitges) s'omplen recorrent
+    // el seu playcount de menys a més id, perquè l'ordre sigui el mateix que el de la taula
+    vector<pair<int, int>> millors;
+    millors.reserve(k);
+    indexPlaycount.recorreDescendent([&](const pair<int, int>& clau) {
+        if (clau.first < f.minPlaycount) return false;
+        millors.push_back(clau);
+        return millors.size() < k;
+    });
+    if (millors.empty()) return millors;
+    int ultim = millors.back().first;
+    size_t lliures = 0;
+    while (!millors.empty() && millors.back().first == ultim) {
+        millors.pop_back();
+        lliures++;
+    }
+    for (size_t inici = 0; inici < millors.size(); ) {
+        size_t fi = inici;
+        while (fi < millors.size() && millors[fi].first == millors[inici].first) fi++;
+        reverse(millors.begin() + inici, millors.begin() + fi);
+        inici = fi;
+    }
+    indexPlaycount.recorreDesDe(make_pair(ultim, INT_MIN), [&](const pair<int, int>& clau) {
+        millors.push_back(clau);
+        return --lliures > 0;
+    });
+    return millors;
+}
+
+/**
+ * Agrupa els artistes que compleixen el filtre per país, gènere i/o estil (CampsAgrupacio) i calcula
+ * recompte, suma, mínim, màxim i mitjana del playcount de cada grup. Amb AGRUPA_ESTIL un artista
+ * compta a cada un dels seus estils, i els artistes sense estils no surten
+ * @return vector<GrupArtistes> grups ordenats per país, gènere i estil
+*/
+vector<GrupArtistes> IndexosArtistes::agrupa(const FiltreArtistes& f, unsigned camps, unsigned fils) const {
+    vector<pair<uint64_t, AgregatPlaycount>> grups = taula.agrupa(tradueix(f), camps, fils);
+
+    // La taula agrupa per codi d'estils: es reparteix cada grup entre els estils del codi
+    if (camps & AGRUPA_ESTIL) {
+        HashTable<uint64_t, uint32_t> posicions(64);
+        vector<pair<uint64_t, AgregatPlaycount>> perEstil;
+        for (const pair<uint64_t, AgregatPlaycount>& g : grups) {
+            for (uint32_t estil : indexEstils.posicions(static_cast<uint32_t>(g.first))) {
+                uint64_t clau = (g.first & ~uint64_t(UINT32_MAX)) | estil;
+                if (posicions.contains(clau)) perEstil[posicions.get(clau)].second.fusiona(g.second);
+                else {
+                    posicions.insert(clau, static_cast<uint32_t>(perEstil.size()));
+                    perEstil.emplace_back(clau, g.second);
+                }
+            }
+        }
+        grups.swap(perEstil);
+    }
+
+    vector<GrupArtistes> resultat;
+    resultat.reserve(grups.size());
+    for (const pair<uint64_t, AgregatPlaycount>& g : grups) {
+        GrupArtistes grup;
+        if (camps & AGRUPA_PAIS) grup.pais = Artist::paisos().text(static_cast<uint32_t>(g.first >> 48));
+        if (camps & AGRUPA_GENERE) grup.genere = Artist::generes().text(static_cast<uint32_t>((g.first >> 32) & UINT16_MAX));
+        if (camps & AGRUPA_ESTIL) grup.estil = indexEstils.nom(static_cast<uint32_t>(g.first));
+        grup.agregat = g.second;
+        resultat.push_back(grup);
+    }
+    sort(resultat.begin(), resultat.end(), [](const GrupArtistes& a, const GrupArtistes& b) {
+        if (a.pais != b.pais) return a.pais < b.pais;
+        if (a.genere != b.genere) return a.genere < b.genere;
+        return a.estil < b.estil;
+    });
+    return resultat;
+}
+
+const TaulaArtistes& IndexosArtistes::taulaArtistes() const {
+    return taula;
+}
+
+/**
+ * Suma un artista als comptadors de país i gènere
+*/
+void IndexosArtistes::comptaCodis(const Artist& a) {
+    if (a.getCountryCode() >= perPais.size()) perPais.resize(a.getCountryCode() + 1, 0);
+    if (a.getGenderCode() >= perGenere.size()) perGenere.resize(a.getGenderCode() + 1, 0);
+    perPais[a.getCountryCode()]++;
+    perGenere[a.getGenderCode()]++;
+}
+
+/**
+ * Nombre d'artistes dels índexs
+ * @return size_t nombre d'artistes
+*/
+size_t IndexosArtistes::mida() const {
+    return taula.mida();
+}
+
+/**
+ * Nombre d'artistes d'un país (codi del diccionari de països)
+ * @return size_t nombre d'artistes
+*/
+size_t IndexosArtistes::artistesAmbPais(uint32_t codi) const {
+    return (codi < perPais.size()) ? perPais[codi] : 0;
+}
+
+/**
+ * Nombre d'artistes d'un gènere (codi del diccionari de gèneres)
+ * @return size_t nombre d'artistes
+*/
+size_t IndexosArtistes::artistesAmbGenere(uint32_t codi) const {
+    return (codi < perGenere.size()) ? perGenere[codi] : 0;
+}
+
+#endif /* INDEXOSARTISTES_H */
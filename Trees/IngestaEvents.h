@@ -0,0 +1,241 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Ingestion of play events (Ingesta d'events de reproducció).
+ * A play event says that an artist has been played delta more times. Instead of reloading the
+ * CSV, the events are grouped in batches and applied to the search engine: every batch is sorted
+ * by artistId and the events of the same artist are added together, so each artist of the batch
+ * is looked up and updated only once (in place, together with its secondary indexes).
+ *
+ * Several producer threads can send events at the same time. The events are split by artistId
+ * into partitions, each one with its own mutex, so the producers only wait for the producers of
+ * the same partition. When a partition has LOT events, the producer that fills it sorts and
+ * compacts the batch without any lock, and then applies it to the search engine holding the
+ * engine mutex (the trees and the indexes are not thread safe).
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - envia: O(1) amortized plus the lock of one partition. Every LOT events, O(LOT log LOT) to sort
+ *   the batch and O(d (log n + m)) to apply it, where d is the number of different artists of the batch.
+ * - buida: applies all the pending events of every partition.
+ * - The pending events use O(particions * LOT) space.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * cercador : Search engine (CercadorArtistes or CercadorArtistesAVL) that receives the events.
+ * particions : Pending events of every partition, with its mutex.
+ * mtxCercador : Only one batch is applied to the search engine at a time.
+ * totals : Statistics of all the applied batches.
+ *
+ * Queries to the search engine must not run while events are being applied.
+ *
+ * ################################################
+ */
+
+#ifndef INGESTAEVENTS_H
+#define INGESTAEVENTS_H
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <climits>
+#include <algorithm>
+
+using namespace std;
+
+struct EventReproduccio {
+    int artistId;
+    int delta;
+};
+
+struct EstadistiquesIngesta {
+    size_t events = 0;          // Events rebuts
+    size_t lots = 0;            // Lots aplicats
+    size_t actualitzats = 0;    // Artistes actualitzats (un cop per lot encara que tinguin molts events)
+    size_t desconeguts = 0;     // Artistes dels events que no són al cercador
+
+    void suma(const EstadistiquesIngesta& altre);
+};
+
+void compactaEvents(vector<EventReproduccio>& events);
+int sumaSaturada(long long playcount, long long delta);
+
+template <class Cercador>
+class IngestaEvents {
+public:
+    static const size_t LOT = 4096;
+
+    IngestaEvents(Cercador& cercador, unsigned particions = 16);
+    IngestaEvents(const IngestaEvents&) = delete;
+    IngestaEvents& operator=(const IngestaEvents&) = delete;
+    ~IngestaEvents();
+
+    void envia(int artistId, int delta);
+    void envia(const EventReproduccio* events, size_t n);
+    void buida();
+    EstadistiquesIngesta estadistiques() const;
+
+private:
+    struct alignas(64) Particio {
+        mutex mtx;
+        vector<EventReproduccio> pendents;
+    };
+
+    Cercador& cercador;
+    unsigned nParticions;
+    unique_ptr<Particio[]> particions;
+    mutable mutex mtxCercador;
+    EstadistiquesIngesta totals;
+
+    Particio& particio(int artistId);
+    void afegeix(Particio& p, const EventReproduccio* events, size_t n);
+    void aplica(vector<EventReproduccio>& lot);
+};
+
+void EstadistiquesIngesta::suma(const EstadistiquesIngesta& altre) {
+    events += altre.events;
+    lots += altre.lots;
+    actualitzats += altre.actualitzats;
+    desconeguts += altre.desconeguts;
+}
+
+/**
+ * Ordena els events per artistId i ajunta els del mateix artista en un sol event amb la suma dels deltes
+ * (saturada al rang d'int). Si ja estan ordenats no els torna a ordenar
+*/
+void compactaEvents(vector<EventReproduccio>& events) {
+    if (events.empty()) return;
+    if (!is_sorted(events.begin(), events.end(),
+        [](const EventReproduccio& a, const EventReproduccio& b) { return a.artistId < b.artistId; })) {
+        sort(events.begin(), events.end(),
+            [](const EventReproduccio& a, const EventReproduccio& b) { return a.artistId < b.artistId; });
+    }
+    size_t escrits = 0;
+    for (size_t i = 0; i < events.size();) {
+        long long delta = 0;
+        size_t j = i;
+        for (; j < events.size() && events[j].artistId == events[i].artistId; j++) delta += events[j].delta;
+        events[escrits].artistId = events[i].artistId;
+        events[escrits].delta = static_cast<int>(max<long long>(INT_MIN, min<long long>(INT_MAX, delta)));
+        escrits++;
+        i = j;
+    }
+    events.resize(escrits);
+}
+
+/**
+ * Suma un delta a un playcount sense sortir de [0, INT_MAX]
+ * @return int nou playcount
+*/
+int sumaSaturada(long long playcount, long long delta) {
+    return static_cast<int>(max<long long>(0, min<long long>(INT_MAX, playcount + delta)));
+}
+
+/**
+ * Constructor amb el cercador que rep els events i el nombre de particions
+*/
+template <class Cercador>
+IngestaEvents<Cercador>::IngestaEvents(Cercador& cercador, unsigned particions):
+    cercador(cercador), nParticions(particions == 0 ? 1 : particions), particions(new Particio[nParticions]) {
+    for (unsigned i = 0; i < nParticions; i++) this->particions[i].pendents.reserve(LOT);
+}
+
+/**
+ * Destructor: aplica els events pendents
+*/
+template <class Cercador>
+IngestaEvents<Cercador>::~IngestaEvents() {
+    buida();
+}
+
+template <class Cercador>
+typename IngestaEvents<Cercador>::Particio& IngestaEvents<Cercador>::particio(int artistId) {
+    return particions[static_cast<unsigned>(artistId) % nParticions];
+}
+
+/**
+ * Compacta un lot fora de cap mutex i l'aplica al cercador amb el mutex del cercador
+*/
+template <class Cercador>
+void IngestaEvents<Cercador>::aplica(vector<EventReproduccio>& lot) {
+    size_t events = lot.size();
+    compactaEvents(lot);
+    lock_guard<mutex> lock(mtxCercador);
+    EstadistiquesIngesta e = cercador.aplicaReproduccions(lot);
+    e.events = events;
+    totals.suma(e);
+}
+
+/**
+ * Envia un event. Es pot cridar des de diversos fils alhora
+*/
+template <class Cercador>
+void IngestaEvents<Cercador>::envia(int artistId, int delta) {
+    EventReproduccio event = {artistId, delta};
+    afegeix(particio(artistId), &event, 1);
+}
+
+/**
+ * Envia n events. Es pot cridar des de diversos fils alhora.
+ * Els events es reparteixen primer per partició, i així cada partició es bloqueja un sol cop
+*/
+template <class Cercador>
+void IngestaEvents<Cercador>::envia(const EventReproduccio* events, size_t n) {
+    vector<vector<EventReproduccio>> perParticio(nParticions);
+    for (size_t i = 0; i < n; i++) {
+        perParticio[static_cast<unsigned>(events[i].artistId) % nParticions].push_back(events[i]);
+    }
+    for (unsigned i = 0; i < nParticions; i++) {
+        if (!perParticio[i].empty()) afegeix(particions[i], perParticio[i].data(), perParticio[i].size());
+    }
+}
+
+/**
+ * Afegeix events als pendents d'una partició. Si la partició arriba a LOT events,
+ * el fil que l'ha omplert s'emporta el lot i l'aplica
+*/
+template <class Cercador>
+void IngestaEvents<Cercador>::afegeix(Particio& p, const EventReproduccio* events, size_t n) {
+    vector<EventReproduccio> lot;
+    {
+        lock_guard<mutex> lock(p.mtx);
+        p.pendents.insert(p.pendents.end(), events, events + n);
+        if (p.pendents.size() < LOT) return;
+        lot.reserve(LOT);
+        lot.swap(p.pendents);
+    }
+    aplica(lot);
+}
+
+/**
+ * Aplica tots els events pendents de totes les particions
+*/
+template <class Cercador>
+void IngestaEvents<Cercador>::buida() {
+    vector<EventReproduccio> lot;
+    for (unsigned i = 0; i < nParticions; i++) {
+        {
+            lock_guard<mutex> lock(particions[i].mtx);
+            lot.swap(particions[i].pendents);
+            particions[i].pendents.reserve(LOT);
+        }
+        if (!lot.empty()) aplica(lot);
+        lot.clear();
+    }
+}
+
+/**
+ * Estadístiques dels lots aplicats (els events pendents encara no hi compten)
+ * @return EstadistiquesIngesta estadístiques
+*/
+template <class Cercador>
+EstadistiquesIngesta IngestaEvents<Cercador>::estadistiques() const {
+    lock_guard<mutex> lock(mtxCercador);
+    return totals;
+}
+
+#endif /* INGESTAEVENTS_H */
@@ -0,0 +1,327 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * CSV reader for artist files (Lector CSV).
+ * This class maps an artist file into memory and tokenizes it in place.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - Opening the file is O(1) with mmap (O(n) with the read fallback used on Windows).
+ * - Parsing all the rows is O(n) time in the size of the file and O(1) extra space:
+ *   fields are string_views pointing into the mapped file and integers are parsed with from_chars,
+ *   so no temporary strings or streams are created per row.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * A LectorCSV has a pointer to the first byte of the file, the size of the file, and
+ * whether the memory comes from mmap or from a read buffer.
+ * A FilaArtista has the six columns of a row (artist_id,name,gender,country,styles,playcount):
+ * the two integers already parsed and the four texts as string_views into the file.
+ *
+ * ################################################
+ *
+ * ################################################
+ * METHODS
+ *
+ * CONSTRUCTORS  ##################################
+ *
+ * LectorCSV : Opens and maps the file. If it cannot be opened, obert() returns false.
+ * ~LectorCSV : Unmaps the file.
+ *
+ * CONSULTORS #####################################
+ *
+ * obert : Returns true if the file has been opened.
+ * contingut : Returns the whole file as a string_view.
+ *
+ * OPERATIONS #####################################
+ *
+ * perCadaFila : Skips the header and calls a function with every row of the file.
+ * recorreTros : Calls a function with every row of a piece of the file.
+ * trossos : Splits the rows of the file into n pieces cut at newline boundaries, to parse them in parallel.
+ * llegeixFila : Parses the row that starts at a position and moves the position to the next row.
+ * llegeixEnter : Parses an integer with from_chars. Throws invalid_argument like stoi.
+ * teCometes : Returns true if a field is quoted.
+ * text : Returns a field as a string, removing the CSV quotes ("" -> ") if it had them.
+ * retalla : Returns a field without the spaces and tabs at the start and at the end.
+ *
+ * ################################################
+ */
+
+#ifndef LECTORCSV_H
+#define LECTORCSV_H
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+struct FilaArtista {
+    int artistId;
+    string_view name;
+    string_view gender;
+    string_view country;
+    string_view styles;
+    int playcount;
+};
+
+class LectorCSV {
+public:
+    LectorCSV(const string& filename);
+    LectorCSV(const LectorCSV&) = delete;
+    LectorCSV& operator=(const LectorCSV&) = delete;
+    ~LectorCSV();
+
+    bool obert() const;
+    string_view contingut() const;
+
+    template <class F>
+    size_t perCadaFila(F f) const; // O(n)
+    template <class F>
+    static size_t recorreTros(string_view tros, F f); // O(mida del tros)
+    vector<string_view> trossos(size_t n) const; // O(n)
+
+    static const char* iniciFiles(const char* p, const char* fi);
+    static bool llegeixFila(const char*& p, const char* fi, FilaArtista& fila);
+    static int llegeixEnter(string_view camp);
+    static bool teCometes(string_view camp);
+    static string text(string_view camp);
+    static string_view retalla(string_view camp);
+
+private:
+    const char* dades;
+    size_t mida;
+    bool mapejat;
+    bool esObert;
+    string memoria; // Només es fa servir si no es pot fer mmap
+
+    static string_view llegeixCamp(const char*& p, const char* fiLinia);
+};
+
+/**
+ * Constructor que obre el fitxer i el mapeja a memòria
+*/
+LectorCSV::LectorCSV(const string& filename): dades(nullptr), mida(0), mapejat(false), esObert(false) {
+#if !defined(_WIN32)
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (::fstat(fd, &st) == 0) {
+            esObert = true;
+            mida = static_cast<size_t>(st.st_size);
+            if (mida > 0) {
+                void* p = ::mmap(nullptr, mida, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED) {
+                    ::madvise(p, mida, MADV_SEQUENTIAL);
+                    dades = static_cast<const char*>(p);
+                    mapejat = true;
+                }
+            }
+        }
+        ::close(fd);
+        if (esObert && mida > 0 && !mapejat) esObert = false;
+    }
+    if (esObert) return;
+#endif
+    ifstream fitxer(filename, ios::binary);
+    if (!fitxer.is_open()) return;
+    memoria.assign(istreambuf_iterator<char>(fitxer), istreambuf_iterator<char>());
+    dades = memoria.data();
+    mida = memoria.size();
+    esObert = true;
+}
+
+/**
+ * Destructor
+*/
+LectorCSV::~LectorCSV() {
+#if !defined(_WIN32)
+    if (mapejat) ::munmap(const_cast<char*>(dades), mida);
+#endif
+}
+
+bool LectorCSV::obert() const {
+    return esObert;
+}
+
+string_view LectorCSV::contingut() const {
+    return string_view(dades, mida);
+}
+
+/**
+ * Recorre totes les files del fitxer (menys la capçalera) i crida a f(const FilaArtista&)
+ * @return nombre de files llegides
+*/
+template <class F>
+size_t LectorCSV::perCadaFila(F f) const {
+    const char* fi = dades + mida;
+    const char* p = iniciFiles(dades, fi);
+    return recorreTros(string_view(p, fi - p), f);
+}
+
+/**
+ * Recorre les files d'un tros del fitxer i crida a f(const FilaArtista&)
+ * @return nombre de files llegides
+*/
+template <class F>
+size_t LectorCSV::recorreTros(string_view tros, F f) {
+    size_t files = 0;
+    const char* p = tros.data();
+    const char* fi = p + tros.size();
+    FilaArtista fila;
+    while (llegeixFila(p, fi, fila)) {
+        f(fila);
+        files++;
+    }
+    return files;
+}
+
+/**
+ * Divideix les files del fitxer (sense la capçalera) en n trossos de mida semblant.
+ * Cada tall es fa just després d'un salt de línia, així cap fila queda partida.
+ * @return vector amb els trossos en l'ordre del fitxer
+*/
+vector<string_view> LectorCSV::trossos(size_t n) const {
+    vector<string_view> resultat;
+    const char* fi = dades + mida;
+    const char* inici = iniciFiles(dades, fi);
+    size_t total = fi - inici;
+    if (n == 0) n = 1;
+    for (size_t i = 0; i < n && inici < fi; i++) {
+        // Els talls anteriors s'han allargat fins al salt de línia, així que el tros pot arribar al final
+        const char* tall = (i + 1 == n || total / n >= static_cast<size_t>(fi - inici)) ? fi : inici + (total / n);
+        if (tall < fi) {
+            const char* salt = static_cast<const char*>(memchr(tall, '\n', fi - tall));
+            tall = (salt == nullptr) ? fi : salt + 1;
+        }
+        resultat.emplace_back(inici, tall - inici);
+        inici = tall;
+    }
+    return resultat;
+}
+
+/**
+ * Salta la capçalera del fitxer
+ * @return posició de la primera fila de dades
+*/
+const char* LectorCSV::iniciFiles(const char* p, const char* fi) {
+    if (p == nullptr) return fi;
+    const char* salt = static_cast<const char*>(memchr(p, '\n', fi - p));
+    return (salt == nullptr) ? fi : salt + 1;
+}
+
+/**
+ * Llegeix la fila que comença a p i deixa p al començament de la següent. Les línies buides se salten.
+ * @return false si no queden files
+*/
+bool LectorCSV::llegeixFila(const char*& p, const char* fi, FilaArtista& fila) {
+    while (p < fi && (*p == '\n' || *p == '\r')) p++;
+    if (p >= fi) return false;
+
+    // Els camps es busquen dins de la línia, així una fila incompleta no continua a la següent
+    const char* salt = static_cast<const char*>(memchr(p, '\n', fi - p));
+    const char* fiLinia = (salt == nullptr) ? fi : salt;
+    if (fiLinia > p && fiLinia[-1] == '\r') fiLinia--;
+
+    fila.artistId = llegeixEnter(llegeixCamp(p, fiLinia));
+    fila.name = llegeixCamp(p, fiLinia);
+    fila.gender = llegeixCamp(p, fiLinia);
+    fila.country = llegeixCamp(p, fiLinia);
+    fila.styles = llegeixCamp(p, fiLinia);
+    fila.playcount = llegeixEnter(string_view(p, fiLinia - p));
+
+    p = (salt == nullptr) ? fi : salt + 1;
+    return true;
+}
+
+/**
+ * Llegeix un camp fins a la coma següent i deixa p després de la coma.
+ * Els camps entre cometes es retornen amb les cometes, per poder treure-les amb text().
+ * @return string_view del camp dins del fitxer
+*/
+string_view LectorCSV::llegeixCamp(const char*& p, const char* fiLinia) {
+    const char* inici = p;
+    if (p < fiLinia && *p == '"') {
+        p++;
+        while (p < fiLinia) {
+            if (*p == '"') {
+                if (p + 1 < fiLinia && p[1] == '"') p += 2;
+                else { p++; break; }
+            }
+            else p++;
+        }
+    }
+    const char* coma = static_cast<const char*>(memchr(p, ',', fiLinia - p));
+    p = (coma == nullptr) ? fiLinia : coma;
+
+    string_view camp(inici, p - inici);
+    if (p < fiLinia) p++;
+    return camp;
+}
+
+/**
+ * Converteix un camp a enter amb from_chars
+ * @return int valor del camp
+*/
+int LectorCSV::llegeixEnter(string_view camp) {
+    const char* inici = camp.data();
+    const char* fi = inici + camp.size();
+    while (inici < fi && (*inici == ' ' || *inici == '\t')) inici++;
+    if (inici < fi && *inici == '+') inici++;
+    int valor = 0;
+    from_chars_result r = from_chars(inici, fi, valor);
+    if (r.ec == errc::invalid_argument) throw invalid_argument("Enter invàlid: " + string(camp));
+    if (r.ec == errc::result_out_of_range) throw out_of_range("Enter fora de rang: " + string(camp));
+    return valor;
+}
+
+/**
+ * Mètode per veure si el camp està entre cometes
+ * @return bool si el camp està entre cometes
+*/
+bool LectorCSV::teCometes(string_view camp) {
+    return !camp.empty() && camp.front() == '"';
+}
+
+/**
+ * Retorna el camp com a string, traient les cometes del CSV si en té
+ * @return string amb el text del camp
+*/
+string LectorCSV::text(string_view camp) {
+    if (camp.size() < 2 || camp.front() != '"' || camp.back() != '"') return string(camp);
+    string resultat;
+    resultat.reserve(camp.size() - 2);
+    for (size_t i = 1; i + 1 < camp.size(); i++) {
+        resultat.push_back(camp[i]);
+        if (camp[i] == '"' && camp[i + 1] == '"') i++;
+    }
+    return resultat;
+}
+
+/**
+ * Treu els espais i tabuladors del començament i del final d'un camp (" United States" -> "United States")
+ * @return string_view del camp retallat, dins del mateix text
+*/
+string_view LectorCSV::retalla(string_view camp) {
+    size_t inici = 0, fi = camp.size();
+    while (inici < fi && (camp[inici] == ' ' || camp[inici] == '\t')) inici++;
+    while (fi > inici && (camp[fi - 1] == ' ' || camp[fi - 1] == '\t')) fi--;
+    return camp.substr(inici, fi - inici);
+}
+
+#endif /* LECTORCSV_H */
@@ -0,0 +1,542 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * On-disk artist store (Magatzem d'artistes en disc).
+ * A read-only file with the artists sorted by artistId, like a sorted string table (SSTable).
+ * The artists are written in compressed blocks of about midaBloc bytes, and only a sparse index
+ * (the first and last id of every block) is kept in memory, so a huge catalogue can stay on disk
+ * instead of in the nodes of a tree. A point lookup reads at most one block, and the last blocks
+ * read are kept in a CacheLRU. The records of a block are decoded while they are read, and an
+ * Artist is only built for the records that the query returns.
+ * The search engines use the store as a cold zone only for the queries by id: buscarArtista,
+ * mostrarArtista and obtenirArtistesPerId (and the Bloom filter and the Elias-Fano set of ids). The
+ * filters, counts, style, name, text and range queries only see the artists of the tree, because
+ * they would have to read and decode the whole file.
+ * ################################################
+ *
+ * ################################################
+ * FORMAT
+ *
+ * File: "MAGART01", the data blocks, the index and a footer of 32 bytes.
+ * Block: nombre d'artistes (varint), the block dictionary (number of texts, and every text as
+ *   varint length + bytes) with the genders, countries and styles of the block, and then every artist:
+ *   id - previous id (varint, the first one from the first id of the block), playcount (varint),
+ *   name (varint length + bytes), and the positions of its gender, country and styles in the dictionary.
+ * Index: for every block, first id, last id (int32), offset (uint64), size and number of artists (uint32).
+ * Footer: index offset (uint64), number of blocks (uint32), 0 (uint32), number of artists (uint64), "MAGART01".
+ * The integers are written in the byte order of the machine.
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - escriu: O(n) with the artists already sorted.
+ * - Opening the store: O(b) to read the index of b blocks. The store uses O(b) memory plus the cache.
+ * - busca: O(log b) in the index plus, if the block is not in the cache, reading and decoding one block.
+ * - recorre (range scan): O(log b + blocks of the range).
+ * - compta: O(log b) with the number of artists of every block, plus at most two blocks for the ends.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * index : First id, last id, position, size and number of artists of every block.
+ * inicis : First id of every block, to binary search the block of an id.
+ * cache : Blocks most recently read (compressed, as they are in the file).
+ * lectures, bytesLlegits : Blocks read from the disk.
+ *
+ * The queries can be called from several threads (pread and the mutex of the cache).
+ *
+ * ################################################
+ */
+
+#ifndef MAGATZEMARTISTES_H
+#define MAGATZEMARTISTES_H
+#include "Artist.h"
+#include "CacheLRU.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <list>
+#include <memory>
+#include <fstream>
+#include <atomic>
+#include <mutex>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+struct EstadistiquesMagatzem {
+    size_t artistes = 0;
+    size_t blocs = 0;
+    size_t lectures = 0;        // Blocs llegits del disc
+    size_t bytesLlegits = 0;
+    EstadistiquesCache cache;
+};
+
+class MagatzemArtistes {
+public:
+    static const size_t MIDA_BLOC = 16 << 10;
+    static const size_t MIDA_BLOC_MINIMA = 4 << 10;
+    static const size_t MIDA_BLOC_MAXIMA = 64 << 10;
+
+    explicit MagatzemArtistes(const string& cami, size_t blocsCache = 256);
+    MagatzemArtistes(const MagatzemArtistes&) = delete;
+    MagatzemArtistes& operator=(const MagatzemArtistes&) = delete;
+    ~MagatzemArtistes();
+
+    static void escriu(const string& cami, const vector<const Artist*>& artistes, size_t midaBloc = MIDA_BLOC);
+
+    size_t mida() const;
+    bool buscarArtista(int artistId) const;
+    bool busca(int artistId, Artist& a) const;
+    string mostrarArtista(int artistId) const;
+    bool mostrarArtista(int artistId, string& sortida) const;
+    size_t compta(int minim, int maxim) const;
+    list<int> obtenirArtistes(int minim, int maxim) const;
+    template <class F>
+    void recorre(int minim, int maxim, F f) const;
+    template <class F>
+    void recorreIds(int minim, int maxim, F f) const;
+    EstadistiquesMagatzem estadistiques() const;
+
+private:
+    static const char MAGIC[8];
+    static const size_t MIDA_PEU = 32;
+
+    struct EntradaIndex {
+        int primer;
+        int ultim;
+        uint64_t posicio;
+        uint32_t mida;
+        uint32_t artistes;
+    };
+    typedef shared_ptr<const string> Bloc;
+
+    string cami;
+    vector<EntradaIndex> index;
+    vector<int> inicis;
+    size_t total;
+    mutable CacheLRU<uint32_t, Bloc> cache;
+    mutable atomic<size_t> lectures, bytesLlegits;
+#if !defined(_WIN32)
+    int fd;
+#else
+    mutable ifstream fitxer;
+    mutable mutex mtxFitxer;
+#endif
+
+    void llegeix(uint64_t posicio, size_t mida, char* desti) const;
+    Bloc bloc(uint32_t b) const;
+    size_t blocDe(int artistId) const;
+
+    static void escriuVarint(string& sortida, uint32_t valor);
+    static bool llegeixVarint(string_view& entrada, uint32_t& valor);
+    static bool llegeixText(string_view& entrada, string_view& text);
+    static void codificaBloc(const vector<const Artist*>& artistes, size_t inici, size_t fi, string& sortida);
+    template <class F>
+    static void recorreBloc(string_view dades, int primer, F f);
+};
+
+const char MagatzemArtistes::MAGIC[8] = {'M', 'A', 'G', 'A', 'R', 'T', '0', '1'};
+
+/**
+ * Escriu un enter sense signe en format varint (7 bits per byte, el bit alt indica que en segueix un altre)
+*/
+void MagatzemArtistes::escriuVarint(string& sortida, uint32_t valor) {
+    while (valor >= 0x80) {
+        sortida += static_cast<char>((valor & 0x7F) | 0x80);
+        valor >>= 7;
+    }
+    sortida += static_cast<char>(valor);
+}
+
+/**
+ * Llegeix un varint del principi de l'entrada i l'avança
+ * @return bool si el varint era complet
+*/
+bool MagatzemArtistes::llegeixVarint(string_view& entrada, uint32_t& valor) {
+    valor = 0;
+    for (int desplacament = 0; desplacament < 35 && !entrada.empty(); desplacament += 7) {
+        uint8_t byte = static_cast<uint8_t>(entrada[0]);
+        entrada.remove_prefix(1);
+        valor |= static_cast<uint32_t>(byte & 0x7F) << desplacament;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool MagatzemArtistes::llegeixText(string_view& entrada, string_view& text) {
+    uint32_t mida;
+    if (!llegeixVarint(entrada, mida) || entrada.size() < mida) return false;
+    text = entrada.substr(0, mida);
+    entrada.remove_prefix(mida);
+    return true;
+}
+
+/**
+ * Codifica els artistes [inici, fi) en un bloc amb el seu diccionari de gèneres, països i estils
+*/
+void MagatzemArtistes::codificaBloc(const vector<const Artist*>& artistes, size_t inici, size_t fi, string& sortida) {
+    // Els codis de diccionari globals d'Artist (camp i codi) es tradueixen a posicions del diccionari del bloc
+    vector<string_view> textos;
+    HashTable<uint64_t, uint32_t> posicions(64);
+    auto posicio = [&](uint64_t camp, uint32_t codi, string_view text) {
+        uint64_t clau = (camp << 32) | codi;
+        if (!posicions.contains(clau)) {
+            posicions.insert(clau, static_cast<uint32_t>(textos.size()));
+            textos.push_back(text);
+        }
+        return posicions.get(clau);
+    };
+    string registres;
+    int anterior = artistes[inici]->getArtistId();
+    for (size_t i = inici; i < fi; i++) {
+        const Artist& a = *artistes[i];
+        escriuVarint(registres, static_cast<uint32_t>(a.getArtistId()) - static_cast<uint32_t>(anterior));
+        escriuVarint(registres, static_cast<uint32_t>(a.getPlaycount()));
+        string_view nom = a.nameView();
+        escriuVarint(registres, static_cast<uint32_t>(nom.size()));
+        registres += nom;
+        escriuVarint(registres, posicio(0, a.getGenderCode(), a.genderView()));
+        escriuVarint(registres, posicio(1, a.getCountryCode(), a.countryView()));
+        escriuVarint(registres, posicio(2, a.getStylesCode(), a.stylesView()));
+        anterior = a.getArtistId();
+    }
+    escriuVarint(sortida, static_cast<uint32_t>(fi - inici));
+    escriuVarint(sortida, static_cast<uint32_t>(textos.size()));
+    for (string_view text : textos) {
+        escriuVarint(sortida, static_cast<uint32_t>(text.size()));
+        sortida += text;
+    }
+    sortida += registres;
+}
+
+/**
+ * Descodifica els registres d'un bloc en ordre i crida a f(id, playcount, nom, genere, pais, estils)
+ * amb textos que apunten dins del bloc. Si f retorna false, s'atura
+*/
+template <class F>
+void MagatzemArtistes::recorreBloc(string_view dades, int primer, F f) {
+    uint32_t n, nTextos;
+    if (!llegeixVarint(dades, n) || !llegeixVarint(dades, nTextos)) throw runtime_error("Bloc del magatzem malmès\n");
+    vector<string_view> textos(nTextos);
+    for (string_view& text : textos) {
+        if (!llegeixText(dades, text)) throw runtime_error("Bloc del magatzem malmès\n");
+    }
+    uint32_t id = static_cast<uint32_t>(primer);
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t delta, playcount, genere, pais, estils;
+        string_view nom;
+        if (!llegeixVarint(dades, delta) || !llegeixVarint(dades, playcount) || !llegeixText(dades, nom)
+            || !llegeixVarint(dades, genere) || !llegeixVarint(dades, pais) || !llegeixVarint(dades, estils)
+            || genere >= nTextos || pais >= nTextos || estils >= nTextos)
+            throw runtime_error("Bloc del magatzem malmès\n");
+        id += delta;
+        if (!f(static_cast<int>(id), static_cast<int>(playcount), nom, textos[genere], textos[pais], textos[estils])) return;
+    }
+}
+
+/**
+ * Escriu un magatzem amb els artistes, que han d'estar ordenats per id sense repetits.
+ * S'escriu a un fitxer temporal que després substitueix l'anterior
+*/
+void MagatzemArtistes::escriu(const string& cami, const vector<const Artist*>& artistes, size_t midaBloc) {
+    if (midaBloc < MIDA_BLOC_MINIMA || midaBloc > MIDA_BLOC_MAXIMA)
+        throw invalid_argument("La mida de bloc ha de ser entre 4 KB i 64 KB\n");
+    for (size_t i = 1; i < artistes.size(); i++) {
+        if (artistes[i]->getArtistId() <= artistes[i - 1]->getArtistId())
+            throw invalid_argument("Els artistes no estan ordenats per identificador\n");
+    }
+
+    string temporal = cami + ".tmp";
+    ofstream sortida(temporal, ios::binary | ios::trunc);
+    if (!sortida) throw runtime_error("Error: Unable to open file " + temporal);
+    sortida.write(MAGIC, sizeof(MAGIC));
+    uint64_t posicio = sizeof(MAGIC);
+    string index, bloc;
+    uint32_t nBlocs = 0;
+
+    // Un bloc s'acaba quan els seus artistes ja ocupen midaBloc sense comprimir
+    for (size_t inici = 0; inici < artistes.size();) {
+        size_t fi = inici, cru = 0;
+        while (fi < artistes.size() && cru < midaBloc) {
+            const Artist& a = *artistes[fi];
+            cru += 16 + a.nameView().size() + a.genderView().size() + a.countryView().size() + a.stylesView().size();
+            fi++;
+        }
+        bloc.clear();
+        codificaBloc(artistes, inici, fi, bloc);
+        sortida.write(bloc.data(), bloc.size());
+
+        EntradaIndex e = {artistes[inici]->getArtistId(), artistes[fi - 1]->getArtistId(), posicio,
+            static_cast<uint32_t>(bloc.size()), static_cast<uint32_t>(fi - inici)};
+        index.append(reinterpret_cast<const char*>(&e.primer), sizeof(e.primer));
+        index.append(reinterpret_cast<const char*>(&e.ultim), sizeof(e.ultim));
+        index.append(reinterpret_cast<const char*>(&e.posicio), sizeof(e.posicio));
+        index.append(reinterpret_cast<const char*>(&e.mida), sizeof(e.mida));
+        index.append(reinterpret_cast<const char*>(&e.artistes), sizeof(e.artistes));
+        posicio += bloc.size();
+        nBlocs++;
+        inici = fi;
+    }
+
+    sortida.write(index.data(), index.size());
+    uint32_t zero = 0;
+    uint64_t total = artistes.size();
+    sortida.write(reinterpret_cast<const char*>(&posicio), sizeof(posicio));
+    sortida.write(reinterpret_cast<const char*>(&nBlocs), sizeof(nBlocs));
+    sortida.write(reinterpret_cast<const char*>(&zero), sizeof(zero));
+    sortida.write(reinterpret_cast<const char*>(&total), sizeof(total));
+    sortida.write(MAGIC, sizeof(MAGIC));
+    sortida.close();
+    if (!sortida) throw runtime_error("No es pot escriure " + temporal);
+    if (rename(temporal.c_str(), cami.c_str()) != 0) throw runtime_error("No es pot substituir " + cami);
+}
+
+/**
+ * Obre un magatzem i en llegeix l'índex. blocsCache és el nombre de blocs que es guarden a la cache,
+ * comprimits tal com són al fitxer
+*/
+MagatzemArtistes::MagatzemArtistes(const string& cami, size_t blocsCache):
+    cami(cami), total(0), cache(blocsCache), lectures(0), bytesLlegits(0) {
+#if !defined(_WIN32)
+    fd = ::open(cami.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw runtime_error("Error: Unable to open file " + cami + ": " + strerror(errno));
+    off_t midaFitxer = ::lseek(fd, 0, SEEK_END);
+#else
+    fitxer.open(cami, ios::binary);
+    if (!fitxer) throw runtime_error("Error: Unable to open file " + cami);
+    fitxer.seekg(0, ios::end);
+    long long midaFitxer = static_cast<long long>(fitxer.tellg());
+#endif
+    try {
+        if (midaFitxer < static_cast<long long>(sizeof(MAGIC) + MIDA_PEU)) throw runtime_error(cami + " no és un magatzem d'artistes\n");
+        char peu[MIDA_PEU];
+        llegeix(static_cast<uint64_t>(midaFitxer) - MIDA_PEU, MIDA_PEU, peu);
+        uint64_t posicioIndex, artistes;
+        uint32_t nBlocs;
+        memcpy(&posicioIndex, peu, 8);
+        memcpy(&nBlocs, peu + 8, 4);
+        memcpy(&artistes, peu + 16, 8);
+        if (memcmp(peu + 24, MAGIC, sizeof(MAGIC)) != 0
+            || posicioIndex + uint64_t(nBlocs) * 24 + MIDA_PEU != static_cast<uint64_t>(midaFitxer))
+            throw runtime_error(cami + " no és un magatzem d'artistes\n");
+
+        string dades(size_t(nBlocs) * 24, '\0');
+        if (!dades.empty()) llegeix(posicioIndex, dades.size(), &dades[0]);
+        index.resize(nBlocs);
+        inicis.resize(nBlocs);
+        for (uint32_t b = 0; b < nBlocs; b++) {
+            const char* p = dades.data() + size_t(b) * 24;
+            memcpy(&index[b].primer, p, 4);
+            memcpy(&index[b].ultim, p + 4, 4);
+            memcpy(&index[b].posicio, p + 8, 8);
+            memcpy(&index[b].mida, p + 16, 4);
+            memcpy(&index[b].artistes, p + 20, 4);
+            inicis[b] = index[b].primer;
+        }
+        total = artistes;
+    } catch (...) {
+#if !defined(_WIN32)
+        ::close(fd);
+#endif
+        throw;
+    }
+}
+
+MagatzemArtistes::~MagatzemArtistes() {
+#if !defined(_WIN32)
+    ::close(fd);
+#endif
+}
+
+/**
+ * Llegeix mida bytes del fitxer a partir de posicio
+*/
+void MagatzemArtistes::llegeix(uint64_t posicio, size_t mida, char* desti) const {
+#if !defined(_WIN32)
+    while (mida > 0) {
+        ssize_t r = ::pread(fd, desti, mida, static_cast<off_t>(posicio));
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) throw runtime_error("No es pot llegir " + cami);
+        desti += r;
+        posicio += static_cast<uint64_t>(r);
+        mida -= static_cast<size_t>(r);
+    }
+#else
+    lock_guard<mutex> lock(mtxFitxer);
+    fitxer.clear();
+    fitxer.seekg(static_cast<streamoff>(posicio));
+    if (!fitxer.read(desti, static_cast<streamsize>(mida))) throw runtime_error("No es pot llegir " + cami);
+#endif
+}
+
+/**
+ * Retorna un bloc, de la cache o llegint-lo del disc
+ * @return Bloc bytes del bloc
+*/
+MagatzemArtistes::Bloc MagatzemArtistes::bloc(uint32_t b) const {
+    Bloc dades;
+    if (cache.obte(b, dades)) return dades;
+    shared_ptr<string> llegit = make_shared<string>(index[b].mida, '\0');
+    llegeix(index[b].posicio, llegit->size(), &(*llegit)[0]);
+    lectures++;
+    bytesLlegits += llegit->size();
+    dades = llegit;
+    cache.posa(b, dades, dades->size());
+    return dades;
+}
+
+/**
+ * Busca el bloc on hauria de ser un id: l'últim bloc que comença abans o a l'id
+ * @return size_t posició del bloc, o index.size() si l'id és més petit que tots
+*/
+size_t MagatzemArtistes::blocDe(int artistId) const {
+    size_t b = static_cast<size_t>(upper_bound(inicis.begin(), inicis.end(), artistId) - inicis.begin());
+    return (b == 0) ? index.size() : b - 1;
+}
+
+size_t MagatzemArtistes::mida() const {
+    return total;
+}
+
+/**
+ * Busca un artista. Llegeix com a molt un bloc (cap si l'id queda fora dels rangs de l'índex)
+ * @return bool si l'artista existeix
+*/
+bool MagatzemArtistes::busca(int artistId, Artist& a) const {
+    size_t b = blocDe(artistId);
+    if (b == index.size() || artistId > index[b].ultim) return false;
+    bool trobat = false;
+    recorreBloc(*bloc(static_cast<uint32_t>(b)), index[b].primer,
+        [&](int id, int playcount, string_view nom, string_view genere, string_view pais, string_view estils) {
+            if (id == artistId) {
+                a = Artist(id, nom, genere, pais, estils, playcount);
+                trobat = true;
+            }
+            return id < artistId;
+        });
+    return trobat;
+}
+
+bool MagatzemArtistes::buscarArtista(int artistId) const {
+    Artist a;
+    return busca(artistId, a);
+}
+
+/**
+ * Mostra un artista amb el mateix format que els cercadors
+ * @return string informació de l'artista
+*/
+string MagatzemArtistes::mostrarArtista(int artistId) const {
+    string text;
+    if (!mostrarArtista(artistId, text)) return "No s'a trobat l'artista";
+    return text;
+}
+
+/**
+ * Afegeix la línia de mostrarArtista al final de sortida, si l'artista existeix
+ * @return bool si l'artista existeix
+*/
+bool MagatzemArtistes::mostrarArtista(int artistId, string& sortida) const {
+    Artist a;
+    if (!busca(artistId, a)) return false;
+    sortida.reserve(sortida.size() + a.midaFormat() + 12);
+    a.formatAmbIdTo(sortida);
+    sortida += '\n';
+    return true;
+}
+
+/**
+ * Crida a f(const Artist&) per cada artista amb id dins de [minim, maxim], en ordre d'id
+*/
+template <class F>
+void MagatzemArtistes::recorre(int minim, int maxim, F f) const {
+    if (minim > maxim || index.empty()) return;
+    size_t b = blocDe(minim);
+    if (b == index.size()) b = 0;
+    for (; b < index.size() && index[b].primer <= maxim; b++) {
+        if (index[b].ultim < minim) continue;
+        recorreBloc(*bloc(static_cast<uint32_t>(b)), index[b].primer,
+            [&](int id, int playcount, string_view nom, string_view genere, string_view pais, string_view estils) {
+                if (id >= minim && id <= maxim) f(Artist(id, nom, genere, pais, estils, playcount));
+                return id < maxim;
+            });
+    }
+}
+
+/**
+ * Compta els artistes amb id dins de [minim, maxim]. Els blocs sencers dins del rang es compten amb
+ * l'índex, i només es llegeixen els blocs dels extrems
+ * @return size_t nombre d'artistes
+*/
+size_t MagatzemArtistes::compta(int minim, int maxim) const {
+    if (minim > maxim || index.empty()) return 0;
+    size_t n = 0;
+    size_t b = blocDe(minim);
+    if (b == index.size()) b = 0;
+    for (; b < index.size() && index[b].primer <= maxim; b++) {
+        if (index[b].ultim < minim) continue;
+        if (index[b].primer >= minim && index[b].ultim <= maxim) {
+            n += index[b].artistes;
+            continue;
+        }
+        recorreBloc(*bloc(static_cast<uint32_t>(b)), index[b].primer,
+            [&](int id, int, string_view, string_view, string_view, string_view) {
+                n += (id >= minim && id <= maxim);
+                return id < maxim;
+            });
+    }
+    return n;
+}
+
+/**
+ * Crida a f(int) amb l'id de cada artista dins de [minim, maxim], en ordre d'id, sense construir cap Artist
+*/
+template <class F>
+void MagatzemArtistes::recorreIds(int minim, int maxim, F f) const {
+    if (minim > maxim || index.empty()) return;
+    size_t b = blocDe(minim);
+    if (b == index.size()) b = 0;
+    for (; b < index.size() && index[b].primer <= maxim; b++) {
+        if (index[b].ultim < minim) continue;
+        recorreBloc(*bloc(static_cast<uint32_t>(b)), index[b].primer,
+            [&](int id, int, string_view, string_view, string_view, string_view) {
+                if (id >= minim && id <= maxim) f(id);
+                return id < maxim;
+            });
+    }
+}
+
+/**
+ * Obté els ids dels artistes dins de [minim, maxim]
+ * @return list<int> ids ordenats
+*/
+list<int> MagatzemArtistes::obtenirArtistes(int minim, int maxim) const {
+    list<int> ids;
+    recorreIds(minim, maxim, [&ids](int id) { ids.push_back(id); });
+    return ids;
+}
+
+EstadistiquesMagatzem MagatzemArtistes::estadistiques() const {
+    EstadistiquesMagatzem e;
+    e.artistes = total;
+    e.blocs = index.size();
+    e.lectures = lectures;
+    e.bytesLlegits = bytesLlegits;
+    e.cache = cache.estadistiques();
+    return e;
+}
+
+#endif /* MAGATZEMARTISTES_H */
@@ -46,6 +46,7 @@
  * setLeft   : Sets the left child pointer of the node.
  * setRight  : Sets the right child pointer of the node.
  * insereixVALUE : Sets the value of the node.
+ * valorModificable : Returns a reference to the value to change it in place, without copying it.
  * 
  * CONSULTORS #####################################
  * 
@@ -69,6 +70,7 @@
 #ifndef NodeTree_H
 #define NodeTree_H
 #include <iostream>
+#include <utility>
 using namespace std;
 
 template <class KEY, class VALUE >
@@ -76,6 +78,7 @@ class NodeTree {
 public:
     /* Constructors */
     NodeTree(const KEY& key, const VALUE& v); //Constructor O(1)
+    NodeTree(const KEY& key, VALUE&& v); //Constructor O(1), mou el valor
     NodeTree(const NodeTree<KEY,VALUE>& orig); // Constructor copia O(n)
     virtual ~NodeTree(); //Destructor O(n)
     /* Modifiers */
@@ -98,6 +101,7 @@ public:
     bool teDreta() const;
     bool esExtern() const;
     void insereixVALUE(const VALUE & v);
+    VALUE& valorModificable();
     int altura() const;
     bool operator==(const NodeTree<KEY,VALUE>& node) const;
 
@@ -121,6 +125,13 @@ NodeTree <KEY, VALUE>::NodeTree(const KEY& key, const VALUE& v){
             this->parent = nullptr;
         }
 
+template <class KEY, class VALUE>
+NodeTree <KEY, VALUE>::NodeTree(const KEY& key, VALUE&& v): key(key), value(std::move(v)){
+            this->left = nullptr;
+            this->right = nullptr;
+            this->parent = nullptr;
+        }
+
 template <class KEY, class VALUE>
 NodeTree<KEY,VALUE>::NodeTree(const NodeTree<KEY,VALUE>& orig){
     this->key = orig.key;
@@ -163,6 +174,15 @@ void NodeTree<KEY, VALUE>::insereixVALUE(const VALUE & v){
     this->value = v;
 }
 
+/**
+ * Retorna el VALUE del node per modificar-lo sense copiar-lo
+ * @return VALUE& referència al valor
+*/
+template<class KEY, class VALUE>
+VALUE& NodeTree<KEY, VALUE>::valorModificable(){
+    return this->value;
+}
+
 template<class KEY, class VALUE>
 void NodeTree<KEY, VALUE>::setLeft(NodeTree<KEY, VALUE>* left){
     this->left = left;
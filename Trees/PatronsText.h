@@ -0,0 +1,271 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Multi-pattern substring search (Patrons de text).
+ * PatronsText is an Aho-Corasick automaton: all the patterns are put in a trie, every state gets the
+ * longest suffix of its path that is also in the trie (failure link), and the failure links are
+ * folded into a complete transition table (a DFA). Scanning a text reads every byte once and does a
+ * single table lookup per byte, whatever the number of patterns is: the table keeps the position of
+ * the row of the next state (state * classes), with the top bit set if some pattern ends there.
+ * The bytes are first mapped to classes (the bytes that appear in some pattern, plus one class for
+ * all the others), so a state only has as many transitions as classes and the table stays small.
+ * Without majuscules the upper case ASCII letters go to the class of the lower case ones.
+ * FiltreText says which patterns are searched in which fields of an artist, and CercaText checks it
+ * on an Artist reading every field once.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - Building: O(L * c), where L is the total length of the patterns and c the number of byte classes.
+ * - conteAlgun, marca: O(m) for a text of m bytes (plus O(p / 64) words for every state that ends a pattern).
+ * - The table uses 4 * (L + 1) * c bytes, and the outputs (p / 64) * 8 bytes per state.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * classe : Byte class of every byte.
+ * transicions : Row of the next state of every (state, class), and the FINAL bit.
+ * sortides : For every state, the bit set of the patterns that end there (with the ones of its
+ *            failure links), in words of 64 bits.
+ *
+ * ################################################
+ */
+
+#ifndef PATRONSTEXT_H
+#define PATRONSTEXT_H
+#include "Artist.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <list>
+#include <queue>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+struct FiltreText {
+    enum Camps { NOM = 1, GENERE = 2, PAIS = 4, ESTILS = 8, TOTS_ELS_CAMPS = 15 };
+
+    list<string> patrons;               // Trossos de text que es busquen
+    unsigned camps = TOTS_ELS_CAMPS;    // Camps on es busquen (suma de Camps)
+    bool tots = false;                  // true: l'artista ha de contenir tots els patrons; false: algun
+    bool majuscules = false;            // Distingir majúscules i minúscules (només ASCII)
+};
+
+class PatronsText {
+public:
+    explicit PatronsText(const vector<string>& patrons, bool majuscules = false);
+
+    bool conteAlgun(string_view text) const;
+    void marca(string_view text, uint64_t* trobats) const;
+    bool totsMarcats(const uint64_t* trobats) const;
+    size_t patrons() const;
+    size_t paraules() const;
+    size_t estats() const;
+
+private:
+    static const uint32_t FINAL = 0x80000000u;
+
+    uint16_t classe[256];
+    unsigned nClasses;
+    vector<uint32_t> transicions;
+    vector<uint64_t> sortides;
+    size_t nPatrons;
+    size_t nParaules;
+    bool buit;          // Hi ha un patró buit: tots els textos en contenen algun
+
+    const uint64_t* sortidesDe(uint32_t fila) const;
+};
+
+class CercaText {
+public:
+    explicit CercaText(const FiltreText& filtre);
+
+    bool compleix(const Artist& a) const;
+
+private:
+    PatronsText patrons;
+    unsigned camps;
+    bool tots;
+
+    static vector<string> comVector(const list<string>& patrons);
+};
+
+/**
+ * Constructor que construeix l'autòmat dels patrons. Un patró buit el conté qualsevol text
+*/
+PatronsText::PatronsText(const vector<string>& patrons, bool majuscules):
+    nClasses(1), nPatrons(patrons.size()), nParaules((patrons.size() + 63) / 64), buit(false) {
+    auto normalitza = [majuscules](unsigned char c) {
+        return (!majuscules && c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c - 'A' + 'a') : c;
+    };
+    // Classe 0: els bytes que no surten a cap patró
+    fill(classe, classe + 256, 0);
+    for (const string& p : patrons) {
+        for (char c : p) {
+            unsigned char b = normalitza(static_cast<unsigned char>(c));
+            if (classe[b] == 0) classe[b] = static_cast<uint16_t>(nClasses++);
+        }
+    }
+    if (!majuscules) {
+        for (unsigned c = 'A'; c <= 'Z'; c++) classe[c] = classe[c - 'A' + 'a'];
+    }
+
+    // Trie dels patrons: les transicions que falten valen BUIDA
+    const uint32_t BUIDA = UINT32_MAX;
+    transicions.assign(nClasses, BUIDA);
+    sortides.assign(nParaules, 0);
+    for (size_t i = 0; i < patrons.size(); i++) {
+        uint32_t estat = 0;
+        for (char c : patrons[i]) {
+            uint32_t& seguent = transicions[estat * nClasses + classe[normalitza(static_cast<unsigned char>(c))]];
+            if (seguent == BUIDA) {
+                seguent = static_cast<uint32_t>(transicions.size() / nClasses);
+                transicions.resize(transicions.size() + nClasses, BUIDA);
+                sortides.resize(sortides.size() + nParaules, 0);
+            }
+            estat = transicions[estat * nClasses + classe[normalitza(static_cast<unsigned char>(c))]];
+        }
+        sortides[estat * nParaules + i / 64] |= uint64_t(1) << (i % 64);
+    }
+
+    // Recorregut en amplada: l'enllaç de fallada d'un estat és menys profund, així que quan es
+    // visita un estat el seu enllaç ja té les transicions completes i les sortides acumulades
+    size_t n = transicions.size() / nClasses;
+    vector<uint32_t> fallada(n, 0);
+    queue<uint32_t> cua;
+    for (unsigned c = 0; c < nClasses; c++) {
+        uint32_t& t = transicions[c];
+        if (t == BUIDA) t = 0;
+        else cua.push(t);
+    }
+    while (!cua.empty()) {
+        uint32_t estat = cua.front();
+        cua.pop();
+        for (size_t w = 0; w < nParaules; w++) sortides[estat * nParaules + w] |= sortides[fallada[estat] * nParaules + w];
+        for (unsigned c = 0; c < nClasses; c++) {
+            uint32_t& t = transicions[estat * nClasses + c];
+            uint32_t desFallada = transicions[fallada[estat] * nClasses + c];
+            if (t == BUIDA) t = desFallada;
+            else {
+                fallada[t] = desFallada;
+                cua.push(t);
+            }
+        }
+    }
+    if (static_cast<uint64_t>(n) * nClasses >= FINAL) throw length_error("Massa patrons per l'autòmat\n");
+
+    // Cada transició passa a ser la fila de l'estat destí, amb FINAL si s'hi acaba algun patró
+    vector<uint8_t> final(n, 0);
+    for (size_t e = 0; e < n; e++) {
+        for (size_t w = 0; w < nParaules; w++) final[e] |= (sortides[e * nParaules + w] != 0);
+    }
+    buit = final[0] != 0;
+    for (uint32_t& t : transicions) t = (t * nClasses) | (final[t] ? FINAL : 0);
+}
+
+/**
+ * Patrons que acaben a l'estat d'una fila de la taula
+ * @return const uint64_t* paraules() paraules amb un bit per patró
+*/
+const uint64_t* PatronsText::sortidesDe(uint32_t fila) const {
+    return &sortides[(fila & ~FINAL) / nClasses * nParaules];
+}
+
+/**
+ * Mira si el text conté algun patró. Para al primer que troba
+ * @return bool si n'hi ha algun
+*/
+bool PatronsText::conteAlgun(string_view text) const {
+    if (buit) return true;
+    uint32_t fila = 0;
+    for (char c : text) {
+        fila = transicions[fila + classe[static_cast<unsigned char>(c)]];
+        if (fila & FINAL) return true;
+    }
+    return false;
+}
+
+/**
+ * Marca a trobats (paraules() paraules de 64 bits) els patrons que surten al text
+*/
+void PatronsText::marca(string_view text, uint64_t* trobats) const {
+    if (buit) {
+        for (size_t w = 0; w < nParaules; w++) trobats[w] |= sortides[w];
+    }
+    uint32_t fila = 0;
+    for (char c : text) {
+        fila = transicions[(fila & ~FINAL) + classe[static_cast<unsigned char>(c)]];
+        if (fila & FINAL) {
+            const uint64_t* s = sortidesDe(fila);
+            for (size_t w = 0; w < nParaules; w++) trobats[w] |= s[w];
+        }
+    }
+}
+
+/**
+ * Mira si trobats té marcats tots els patrons
+ * @return bool si s'han trobat tots
+*/
+bool PatronsText::totsMarcats(const uint64_t* trobats) const {
+    for (size_t w = 0; w < nParaules; w++) {
+        uint64_t tots = (w + 1 < nParaules || nPatrons % 64 == 0) ? ~uint64_t(0) : (uint64_t(1) << (nPatrons % 64)) - 1;
+        if ((trobats[w] & tots) != tots) return false;
+    }
+    return true;
+}
+
+size_t PatronsText::patrons() const {
+    return nPatrons;
+}
+
+size_t PatronsText::paraules() const {
+    return nParaules;
+}
+
+size_t PatronsText::estats() const {
+    return transicions.size() / nClasses;
+}
+
+/**
+ * Constructor que compila els patrons del filtre
+*/
+CercaText::CercaText(const FiltreText& filtre):
+    patrons(comVector(filtre.patrons), filtre.majuscules), camps(filtre.camps), tots(filtre.tots) {}
+
+vector<string> CercaText::comVector(const list<string>& patrons) {
+    return vector<string>(patrons.begin(), patrons.end());
+}
+
+/**
+ * Mira si un artista compleix el filtre: cada camp triat es llegeix un sol cop amb l'autòmat.
+ * Sense patrons, el compleixen tots els artistes amb "tots" i cap sense
+ * @return bool si el compleix
+*/
+bool CercaText::compleix(const Artist& a) const {
+    string_view textos[] = {a.nameView(), a.genderView(), a.countryView(), a.stylesView()};
+    if (!tots) {
+        for (unsigned c = 0; c < 4; c++) {
+            if ((camps & (1u << c)) && patrons.conteAlgun(textos[c])) return true;
+        }
+        return false;
+    }
+    uint64_t petit[4] = {0, 0, 0, 0};
+    vector<uint64_t> gran;
+    uint64_t* trobats = petit;
+    if (patrons.paraules() > 4) {
+        gran.assign(patrons.paraules(), 0);
+        trobats = gran.data();
+    }
+    for (unsigned c = 0; c < 4; c++) {
+        if (camps & (1u << c)) patrons.marca(textos[c], trobats);
+    }
+    return patrons.totsMarcats(trobats);
+}
+
+#endif /* PATRONSTEXT_H */
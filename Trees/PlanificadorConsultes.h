@@ -0,0 +1,195 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Query planner for combined filters (Planificador de consultes).
+ * A FiltreArtistes combines several predicates (playcount range, country, gender and styles).
+ * The planner estimates how many artists every predicate keeps using the statistics of the
+ * indexes, and chooses how to run the query:
+ * - LLISTA_ESTILS: start from the shortest style posting list, intersect the other style lists
+ *   and check the rest of predicates only on the candidates.
+ * - RANG_PLAYCOUNT: walk the playcount index inside the range and check the candidates.
+ * - RECORREGUT_TAULA: if no index keeps few artists, a vectorized scan of the columnar table.
+ * - BUIDA: some text of the filter does not exist, nothing to do.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - planifica: O(e + log n), where e is the number of styles of the filter.
+ * - executa: O(c log c) with an index, where c is the number of candidates of the chosen index
+ *   (the other style lists are intersected by galloping), or O(n / fils) with the scan.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * indexos : Indexes of a search engine.
+ * FACTOR_RECORREGUT : An index is used only if it keeps less than 1 / FACTOR_RECORREGUT of the
+ *     artists. Checking a candidate is a random access, while the scan reads the columns in order.
+ *
+ * ################################################
+ */
+
+#ifndef PLANIFICADORCONSULTES_H
+#define PLANIFICADORCONSULTES_H
+#include "IndexosArtistes.h"
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+struct PlaConsulta {
+    enum Estrategia { BUIDA, LLISTA_ESTILS, RANG_PLAYCOUNT, RECORREGUT_TAULA };
+
+    Estrategia estrategia = RECORREGUT_TAULA;
+    size_t total = 0;                   // Artistes dels índexs
+    size_t perEstils = SIZE_MAX;        // Mida de la llista d'estils més curta (SIZE_MAX: sense estils)
+    size_t perPlaycount = SIZE_MAX;     // Artistes dins del rang (SIZE_MAX: sense rang)
+    size_t perPais = SIZE_MAX;
+    size_t perGenere = SIZE_MAX;
+    double estimacio = 0;               // Resultat estimat suposant predicats independents
+    FiltreCodis codis;
+    vector<string> ordreEstils;         // Estils ordenats de la llista més curta a la més llarga
+
+    string descripcio() const;
+};
+
+class PlanificadorConsultes {
+public:
+    static const size_t FACTOR_RECORREGUT = 8;
+
+    explicit PlanificadorConsultes(const IndexosArtistes& indexos);
+
+    PlaConsulta planifica(const FiltreArtistes& f) const;
+    vector<int> executa(const PlaConsulta& pla, unsigned fils = 1) const;
+    vector<int> executa(const FiltreArtistes& f, unsigned fils = 1) const;
+
+private:
+    const IndexosArtistes& indexos;
+};
+
+/**
+ * Explica el pla en una línia (com un EXPLAIN)
+ * @return string descripció del pla
+*/
+string PlaConsulta::descripcio() const {
+    static const char* const NOMS[] = {"buida", "llista d'estils", "rang de playcount", "recorregut de la taula"};
+    ostringstream text;
+    text << NOMS[estrategia] << " (total " << total;
+    if (perEstils != SIZE_MAX) text << ", estils " << perEstils;
+    if (perPlaycount != SIZE_MAX) text << ", playcount " << perPlaycount;
+    if (perPais != SIZE_MAX) text << ", pais " << perPais;
+    if (perGenere != SIZE_MAX) text << ", genere " << perGenere;
+    text << ", estimacio " << static_cast<size_t>(estimacio) << ")";
+    return text.str();
+}
+
+/**
+ * Constructor amb els índexs d'un cercador
+*/
+PlanificadorConsultes::PlanificadorConsultes(const IndexosArtistes& indexos): indexos(indexos) {}
+
+/**
+ * Estima la selectivitat de cada predicat amb les estadístiques dels índexs i tria l'estratègia
+ * @return PlaConsulta pla de la consulta
+*/
+PlaConsulta PlanificadorConsultes::planifica(const FiltreArtistes& f) const {
+    PlaConsulta pla;
+    pla.total = indexos.mida();
+    pla.codis = indexos.tradueix(f);
+    if (pla.codis.impossible || f.minPlaycount > f.maxPlaycount || pla.total == 0) {
+        pla.estrategia = PlaConsulta::BUIDA;
+        return pla;
+    }
+
+    double seleccio = 1.0;
+    if (!f.estils.empty()) {
+        for (const string& estil : f.estils) {
+            size_t mida = indexos.artistesPerEstil(estil).size();
+            pla.perEstils = min(pla.perEstils, mida);
+            seleccio *= static_cast<double>(mida) / pla.total;
+            pla.ordreEstils.push_back(estil);
+        }
+        sort(pla.ordreEstils.begin(), pla.ordreEstils.end(), [this](const string& a, const string& b) {
+            return indexos.artistesPerEstil(a).size() < indexos.artistesPerEstil(b).size();
+        });
+    }
+    if (f.minPlaycount != INT_MIN || f.maxPlaycount != INT_MAX) {
+        pla.perPlaycount = indexos.comptaPlaycount(f.minPlaycount, f.maxPlaycount);
+        seleccio *= static_cast<double>(pla.perPlaycount) / pla.total;
+    }
+    if (pla.codis.pais >= 0) {
+        pla.perPais = indexos.artistesAmbPais(static_cast<uint32_t>(pla.codis.pais));
+        seleccio *= static_cast<double>(pla.perPais) / pla.total;
+    }
+    if (pla.codis.genere >= 0) {
+        pla.perGenere = indexos.artistesAmbGenere(static_cast<uint32_t>(pla.codis.genere));
+        seleccio *= static_cast<double>(pla.perGenere) / pla.total;
+    }
+    pla.estimacio = seleccio * pla.total;
+
+    // Algun predicat indexat no deixa cap artista
+    if (pla.perEstils == 0 || pla.perPlaycount == 0 || pla.perPais == 0 || pla.perGenere == 0) {
+        pla.estrategia = PlaConsulta::BUIDA;
+        return pla;
+    }
+
+    size_t llindar = pla.total / FACTOR_RECORREGUT;
+    if (pla.perEstils <= pla.perPlaycount && pla.perEstils <= llindar) pla.estrategia = PlaConsulta::LLISTA_ESTILS;
+    else if (pla.perPlaycount < pla.perEstils && pla.perPlaycount <= llindar) pla.estrategia = PlaConsulta::RANG_PLAYCOUNT;
+    else pla.estrategia = PlaConsulta::RECORREGUT_TAULA;
+    return pla;
+}
+
+/**
+ * Executa un pla
+ * @return vector<int> ids ordenats dels artistes que compleixen el filtre
+*/
+vector<int> PlanificadorConsultes::executa(const PlaConsulta& pla, unsigned fils) const {
+    vector<int> resultat;
+    const TaulaArtistes& taula = indexos.taulaArtistes();
+    switch (pla.estrategia) {
+        case PlaConsulta::BUIDA:
+            return resultat;
+
+        case PlaConsulta::LLISTA_ESTILS: {
+            // Els estils ja queden comprovats per la intersecció: només falten la resta de predicats
+            resultat = indexos.artistesPerEstil(pla.ordreEstils[0]);
+            for (size_t i = 1; i < pla.ordreEstils.size() && !resultat.empty(); i++)
+                resultat = IndexEstils::interseccio(resultat, indexos.artistesPerEstil(pla.ordreEstils[i]));
+            FiltreCodis resta = pla.codis;
+            resta.estils.clear();
+            if (resta.pais < 0 && resta.genere < 0 && resta.minPlaycount == INT_MIN && resta.maxPlaycount == INT_MAX)
+                return resultat;
+            resultat.erase(remove_if(resultat.begin(), resultat.end(),
+                [&](int id) { return !taula.compleix(id, resta); }), resultat.end());
+            return resultat;
+        }
+
+        case PlaConsulta::RANG_PLAYCOUNT: {
+            resultat.reserve(pla.perPlaycount);
+            indexos.recorrePlaycount(pla.codis.minPlaycount, pla.codis.maxPlaycount, [&](int id, int) {
+                if (taula.compleix(id, pla.codis)) resultat.push_back(id);
+            });
+            sort(resultat.begin(), resultat.end());
+            return resultat;
+        }
+
+        default:
+            return taula.filtra(pla.codis, fils);
+    }
+}
+
+/**
+ * Planifica i executa un filtre
+ * @return vector<int> ids ordenats dels artistes que compleixen el filtre
+*/
+vector<int> PlanificadorConsultes::executa(const FiltreArtistes& f, unsigned fils) const {
+    return executa(planifica(f), fils);
+}
+
+#endif /* PLANIFICADORCONSULTES_H */
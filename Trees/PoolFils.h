@@ -0,0 +1,179 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Thread pool (Pool de fils).
+ * This class keeps a fixed number of worker threads that run the tasks sent to a shared queue.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - Sending a task (envia) is O(1) plus the cost of locking the queue.
+ * - perCadaBloc splits [0, n) into one block per thread and waits for all of them: O(n / fils) time
+ *   per thread if the work is uniform.
+ * - The pool uses O(fils + tasques pendents) space.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * A PoolFils has a vector of worker threads, a queue of pending tasks, a mutex and a
+ * condition variable to wake up the workers, and a flag to stop them in the destructor.
+ *
+ * ################################################
+ *
+ * ################################################
+ * METHODS
+ *
+ * CONSTRUCTORS  ##################################
+ *
+ * PoolFils : Creates the worker threads. With 0 threads it uses hardware_concurrency().
+ * ~PoolFils : Finishes the pending tasks and joins all the threads.
+ *
+ * CONSULTORS #####################################
+ *
+ * mida : Returns the number of worker threads.
+ *
+ * OPERATIONS #####################################
+ *
+ * envia : Sends a task to the queue and returns a future with its result.
+ * perCadaBloc : Runs f(bloc, inici, fi) in parallel over [0, n) split into blocks and waits.
+ *
+ * ################################################
+ */
+
+#ifndef POOLFILS_H
+#define POOLFILS_H
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+using namespace std;
+
+class PoolFils {
+public:
+    explicit PoolFils(unsigned fils = 0);
+    PoolFils(const PoolFils&) = delete;
+    PoolFils& operator=(const PoolFils&) = delete;
+    ~PoolFils();
+
+    unsigned mida() const;
+
+    template <class F>
+    future<invoke_result_t<F>> envia(F f);
+
+    template <class F>
+    void perCadaBloc(size_t n, F f);
+
+    static unsigned filsPerDefecte(unsigned fils);
+
+private:
+    vector<thread> treballadors;
+    queue<function<void()>> tasques;
+    mutex mtx;
+    condition_variable cv;
+    bool aturat;
+
+    void treballa();
+};
+
+/**
+ * Constructor que engega els fils treballadors
+*/
+PoolFils::PoolFils(unsigned fils): aturat(false) {
+    fils = filsPerDefecte(fils);
+    treballadors.reserve(fils);
+    for (unsigned i = 0; i < fils; i++) {
+        treballadors.emplace_back([this] { treballa(); });
+    }
+}
+
+/**
+ * Destructor. Acaba les tasques pendents i espera tots els fils
+*/
+PoolFils::~PoolFils() {
+    {
+        lock_guard<mutex> lock(mtx);
+        aturat = true;
+    }
+    cv.notify_all();
+    for (thread& t : treballadors) t.join();
+}
+
+unsigned PoolFils::mida() const {
+    return static_cast<unsigned>(treballadors.size());
+}
+
+/**
+ * Nombre de fils a fer servir si se'n demanen 0
+ * @return unsigned nombre de fils (com a mínim 1)
+*/
+unsigned PoolFils::filsPerDefecte(unsigned fils) {
+    if (fils == 0) fils = thread::hardware_concurrency();
+    return (fils == 0) ? 1 : fils;
+}
+
+/**
+ * Bucle de cada fil treballador
+*/
+void PoolFils::treballa() {
+    while (true) {
+        function<void()> tasca;
+        {
+            unique_lock<mutex> lock(mtx);
+            cv.wait(lock, [this] { return aturat || !tasques.empty(); });
+            if (aturat && tasques.empty()) return;
+            tasca = std::move(tasques.front());
+            tasques.pop();
+        }
+        tasca();
+    }
+}
+
+/**
+ * Envia una tasca a la cua del pool
+ * @return future amb el resultat de la tasca (o l'excepció que hagi llançat)
+*/
+template <class F>
+future<invoke_result_t<F>> PoolFils::envia(F f) {
+    using R = invoke_result_t<F>;
+    auto tasca = make_shared<packaged_task<R()>>(std::move(f));
+    future<R> resultat = tasca->get_future();
+    {
+        lock_guard<mutex> lock(mtx);
+        tasques.emplace([tasca] { (*tasca)(); });
+    }
+    cv.notify_one();
+    return resultat;
+}
+
+/**
+ * Executa f(bloc, inici, fi) en paral·lel sobre [0, n) dividit en un bloc per fil i espera que acabin.
+ * Si algun bloc llança una excepció, es torna a llançar aquí.
+*/
+template <class F>
+void PoolFils::perCadaBloc(size_t n, F f) {
+    size_t blocs = min<size_t>(mida(), n);
+    vector<future<void>> pendents;
+    pendents.reserve(blocs);
+    for (size_t b = 0; b < blocs; b++) {
+        size_t inici = n * b / blocs, fi = n * (b + 1) / blocs;
+        pendents.push_back(envia([&f, b, inici, fi] { f(b, inici, fi); }));
+    }
+    // S'esperen tots els blocs abans de tornar a llançar, perquè fan servir f per referència
+    exception_ptr error;
+    for (future<void>& p : pendents) {
+        try { p.get(); }
+        catch (...) { if (!error) error = current_exception(); }
+    }
+    if (error) rethrow_exception(error);
+}
+
+#endif /* POOLFILS_H */
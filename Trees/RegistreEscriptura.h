@@ -0,0 +1,511 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Write-ahead log of the artist search engines (Registre d'escriptura anticipada).
+ * Every artist inserted and every playcount changed at runtime is appended to a binary log file,
+ * so it is not lost when the program restarts. On start, the last snapshot and then the log are
+ * replayed on top of the artists loaded from the CSV files. Compacting writes a new snapshot with
+ * all the artists and empties the log, only after the snapshot file and its directory entry are synced.
+ *
+ * Group commit: the records are appended to a buffer in memory and a writer thread writes the
+ * buffer and calls fdatasync once for all of them, every "interval" milliseconds or as soon as
+ * someone waits for a record with sincronitza. The threads that wait at the same time share the
+ * same fdatasync. A record is durable when sincronitza(lsn) returns.
+ * ################################################
+ *
+ * ################################################
+ * FORMAT
+ *
+ * File: the 8 bytes "REGART01" followed by records. The snapshot has the same format.
+ * Record: mida (uint32), crc (uint32, CRC-32 of the tipus byte and the data), tipus (uint8), data.
+ *   INSEREIX data: artistId, playcount (int32), name, gender, country, styles (uint32 length + bytes).
+ *   PLAYCOUNT data: artistId, playcount (int32). It stores the new value, so replaying it twice is harmless.
+ * The integers are written in the byte order of the machine.
+ * A record cut by a crash (short or with a wrong crc) ends the log: it is discarded when the log is replayed.
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - registraArtista, registraPlaycount: O(record size) to append to the buffer while holding a mutex.
+ * - sincronitza: waits at most one write and fdatasync of all the pending records.
+ * - reprodueix: O(file size).
+ * - The buffer uses at most MAX_PENDENT bytes: when it is full, registra waits for the writer.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * fd : Log file, opened with O_APPEND.
+ * pendent : Records not written yet.
+ * seguent : Log sequence number (lsn) of the next record. durable : Last lsn written and synced.
+ * demanat : Largest lsn that someone is waiting for with sincronitza.
+ * escrivint : The writer is writing a batch without holding the mutex.
+ * escriptor : Thread that writes the buffer (group commit).
+ *
+ * ################################################
+ */
+
+#ifndef REGISTREESCRIPTURA_H
+#define REGISTREESCRIPTURA_H
+#include "Artist.h"
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+struct EstadistiquesRegistre {
+    size_t registres = 0;
+    size_t bytes = 0;
+    size_t sincronitzacions = 0;    // Crides a fdatasync (cada una fa durables molts registres)
+};
+
+#if !defined(_WIN32)
+
+class RegistreEscriptura {
+public:
+    enum Tipus : uint8_t { INSEREIX = 1, PLAYCOUNT = 2 };
+    static const size_t MAX_PENDENT = 8 << 20;
+
+    explicit RegistreEscriptura(const string& cami, unsigned intervalMs = 2);
+    RegistreEscriptura(const RegistreEscriptura&) = delete;
+    RegistreEscriptura& operator=(const RegistreEscriptura&) = delete;
+    ~RegistreEscriptura();
+
+    uint64_t registraArtista(const Artist& a);
+    uint64_t registraPlaycount(int artistId, int playcount);
+    void sincronitza(uint64_t lsn);
+    void sincronitza();
+    void buida();
+    EstadistiquesRegistre estadistiques() const;
+
+    template <class FA, class FP>
+    static size_t reprodueix(const string& cami, FA artista, FP playcount);
+    static void escriuInstantania(const string& cami, const vector<const Artist*>& artistes);
+
+private:
+    static const char CAPCALERA[8];
+
+    int fd;
+    string cami;
+    chrono::milliseconds interval;
+    string pendent;
+    uint64_t seguent, durable, demanat;
+    bool atura, escrivint;
+    string error;
+    EstadistiquesRegistre totals;
+    mutable mutex mtx;
+    condition_variable cvEscriptor, cvDurable;
+    thread escriptor;
+
+    uint64_t afegeix(const string& registre);
+    void bucleEscriptor();
+    static int obre(const string& cami, int opcions);
+    static void escriuTot(int fd, const char* dades, size_t mida);
+    static void sincronitzaFitxer(int fd);
+    static void sincronitzaDirectori(const string& cami);
+    static uint32_t crc32(const char* dades, size_t mida);
+    static void afegeixEnter(string& registre, uint32_t valor);
+    static void afegeixText(string& registre, string_view text);
+    static string codificaArtista(const Artist& a);
+    static void emmarca(string& sortida, const string& registre);
+    static bool llegeixEnter(const string& dades, size_t& pos, uint32_t& valor);
+    static bool llegeixText(const string& dades, size_t& pos, string& text);
+};
+
+const char RegistreEscriptura::CAPCALERA[8] = {'R', 'E', 'G', 'A', 'R', 'T', '0', '1'};
+
+/**
+ * Obre (o crea) el registre per afegir-hi registres i arrenca el fil escriptor
+*/
+RegistreEscriptura::RegistreEscriptura(const string& cami, unsigned intervalMs):
+    fd(-1), cami(cami), interval(intervalMs), seguent(1), durable(0), demanat(0), atura(false), escrivint(false) {
+    fd = obre(cami, O_WRONLY | O_CREAT | O_APPEND);
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && info.st_size == 0) {
+        escriuTot(fd, CAPCALERA, sizeof(CAPCALERA));
+        sincronitzaFitxer(fd);
+    }
+    escriptor = thread(&RegistreEscriptura::bucleEscriptor, this);
+}
+
+/**
+ * Destructor: escriu els registres pendents, atura el fil escriptor i tanca el fitxer
+*/
+RegistreEscriptura::~RegistreEscriptura() {
+    {
+        lock_guard<mutex> lock(mtx);
+        atura = true;
+    }
+    cvEscriptor.notify_one();
+    escriptor.join();
+    ::close(fd);
+}
+
+int RegistreEscriptura::obre(const string& cami, int opcions) {
+    int fd = ::open(cami.c_str(), opcions | O_CLOEXEC, 0644);
+    if (fd < 0) throw runtime_error("Error: Unable to open file " + cami + ": " + strerror(errno));
+    return fd;
+}
+
+void RegistreEscriptura::escriuTot(int fd, const char* dades, size_t mida) {
+    while (mida > 0) {
+        ssize_t w = ::write(fd, dades, mida);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            throw runtime_error(string("No es pot escriure el registre: ") + strerror(errno));
+        }
+        dades += w;
+        mida -= static_cast<size_t>(w);
+    }
+}
+
+void RegistreEscriptura::sincronitzaFitxer(int fd) {
+#if defined(__linux__)
+    int r = ::fdatasync(fd);
+#else
+    int r = ::fsync(fd);
+#endif
+    if (r < 0) throw runtime_error(string("No es pot sincronitzar el registre: ") + strerror(errno));
+}
+
+/**
+ * Fa durables les entrades del directori d'un fitxer (el rename d'una instantània). Sense això una caiguda
+ * pot perdre el rename encara que el fitxer ja sigui al disc
+*/
+void RegistreEscriptura::sincronitzaDirectori(const string& cami) {
+    size_t barra = cami.find_last_of('/');
+    string directori = (barra == string::npos) ? "." : (barra == 0 ? "/" : cami.substr(0, barra));
+    int fd = obre(directori, O_RDONLY | O_DIRECTORY);
+    int r = ::fsync(fd);
+    int errada = errno;
+    ::close(fd);
+    // Alguns sistemes de fitxers no permeten sincronitzar directoris
+    if (r < 0 && errada != EINVAL) throw runtime_error("No es pot sincronitzar el directori " + directori + ": " + strerror(errada));
+}
+
+/**
+ * CRC-32 (polinomi 0xEDB88320, el de zlib) amb una taula de 256 entrades
+ * @return uint32_t crc de les dades
+*/
+uint32_t RegistreEscriptura::crc32(const char* dades, size_t mida) {
+    static const vector<uint32_t> taula = []() {
+        vector<uint32_t> t(256);
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < mida; i++) crc = taula[(crc ^ static_cast<uint8_t>(dades[i])) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void RegistreEscriptura::afegeixEnter(string& registre, uint32_t valor) {
+    registre.append(reinterpret_cast<const char*>(&valor), sizeof(valor));
+}
+
+void RegistreEscriptura::afegeixText(string& registre, string_view text) {
+    afegeixEnter(registre, static_cast<uint32_t>(text.size()));
+    registre += text;
+}
+
+/**
+ * Afegeix la mida i el crc davant d'un registre (tipus + dades)
+*/
+void RegistreEscriptura::emmarca(string& sortida, const string& registre) {
+    afegeixEnter(sortida, static_cast<uint32_t>(registre.size()));
+    afegeixEnter(sortida, crc32(registre.data(), registre.size()));
+    sortida += registre;
+}
+
+string RegistreEscriptura::codificaArtista(const Artist& a) {
+    string registre(1, static_cast<char>(INSEREIX));
+    afegeixEnter(registre, static_cast<uint32_t>(a.getArtistId()));
+    afegeixEnter(registre, static_cast<uint32_t>(a.getPlaycount()));
+    afegeixText(registre, a.nameView());
+    afegeixText(registre, a.genderView());
+    afegeixText(registre, a.countryView());
+    afegeixText(registre, a.stylesView());
+    return registre;
+}
+
+/**
+ * Afegeix un registre al buffer. Si el buffer és massa gran, espera que l'escriptor el buidi
+ * @return uint64_t lsn del registre
+*/
+uint64_t RegistreEscriptura::afegeix(const string& registre) {
+    unique_lock<mutex> lock(mtx);
+    if (!error.empty()) throw runtime_error(error);
+    if (pendent.size() >= MAX_PENDENT) {
+        cvEscriptor.notify_one();
+        cvDurable.wait(lock, [this]() { return pendent.size() < MAX_PENDENT || !error.empty(); });
+        if (!error.empty()) throw runtime_error(error);
+    }
+    emmarca(pendent, registre);
+    totals.registres++;
+    totals.bytes += registre.size() + 8;
+    return seguent++;
+}
+
+/**
+ * Registra un artista inserit
+ * @return uint64_t lsn del registre
+*/
+uint64_t RegistreEscriptura::registraArtista(const Artist& a) {
+    return afegeix(codificaArtista(a));
+}
+
+/**
+ * Registra el nou playcount d'un artista
+ * @return uint64_t lsn del registre
+*/
+uint64_t RegistreEscriptura::registraPlaycount(int artistId, int playcount) {
+    string registre(1, static_cast<char>(PLAYCOUNT));
+    afegeixEnter(registre, static_cast<uint32_t>(artistId));
+    afegeixEnter(registre, static_cast<uint32_t>(playcount));
+    return afegeix(registre);
+}
+
+/**
+ * Espera que el registre lsn (i tots els anteriors) sigui al disc
+*/
+void RegistreEscriptura::sincronitza(uint64_t lsn) {
+    unique_lock<mutex> lock(mtx);
+    if (durable >= lsn) return;
+    demanat = max(demanat, lsn);
+    cvEscriptor.notify_one();
+    cvDurable.wait(lock, [this, lsn]() { return durable >= lsn || !error.empty(); });
+    if (!error.empty()) throw runtime_error(error);
+}
+
+/**
+ * Espera que tots els registres fets fins ara siguin al disc
+*/
+void RegistreEscriptura::sincronitza() {
+    uint64_t ultim;
+    {
+        lock_guard<mutex> lock(mtx);
+        ultim = seguent - 1;
+    }
+    sincronitza(ultim);
+}
+
+/**
+ * Buida el registre (després d'escriure una instantània amb tots els artistes). Espera que l'escriptor
+ * hagi escrit tots els pendents i no deixa afegir-ne de nous fins que el fitxer queda buit
+*/
+void RegistreEscriptura::buida() {
+    unique_lock<mutex> lock(mtx);
+    demanat = max(demanat, seguent - 1);
+    cvEscriptor.notify_one();
+    cvDurable.wait(lock, [this]() { return (pendent.empty() && !escrivint) || !error.empty(); });
+    if (!error.empty()) throw runtime_error(error);
+    if (::ftruncate(fd, sizeof(CAPCALERA)) < 0) throw runtime_error(string("No es pot buidar el registre: ") + strerror(errno));
+    sincronitzaFitxer(fd);
+}
+
+EstadistiquesRegistre RegistreEscriptura::estadistiques() const {
+    lock_guard<mutex> lock(mtx);
+    return totals;
+}
+
+/**
+ * Fil escriptor: cada interval (o quan algú espera amb sincronitza) escriu tot el buffer
+ * i fa un sol fdatasync per tots els registres
+*/
+void RegistreEscriptura::bucleEscriptor() {
+    unique_lock<mutex> lock(mtx);
+    string lot;
+    while (true) {
+        cvEscriptor.wait_for(lock, interval, [this]() {
+            return atura || demanat > durable || pendent.size() >= MAX_PENDENT;
+        });
+        if (pendent.empty()) {
+            if (atura) return;
+            continue;
+        }
+        lot.clear();
+        lot.swap(pendent);
+        uint64_t fins = seguent - 1;
+        escrivint = true;
+        lock.unlock();
+        string falla;
+        try {
+            escriuTot(fd, lot.data(), lot.size());
+            sincronitzaFitxer(fd);
+        } catch (const exception& e) {
+            falla = e.what();
+        }
+        lock.lock();
+        escrivint = false;
+        if (!falla.empty()) error = falla;
+        else {
+            durable = fins;
+            totals.sincronitzacions++;
+        }
+        cvDurable.notify_all();
+        if (!error.empty()) return;
+    }
+}
+
+bool RegistreEscriptura::llegeixEnter(const string& dades, size_t& pos, uint32_t& valor) {
+    if (dades.size() - pos < sizeof(valor)) return false;
+    memcpy(&valor, dades.data() + pos, sizeof(valor));
+    pos += sizeof(valor);
+    return true;
+}
+
+bool RegistreEscriptura::llegeixText(const string& dades, size_t& pos, string& text) {
+    uint32_t mida;
+    if (!llegeixEnter(dades, pos, mida) || dades.size() - pos < mida) return false;
+    text.assign(dades, pos, mida);
+    pos += mida;
+    return true;
+}
+
+/**
+ * Llegeix un registre o una instantània i crida artista(const Artist&) o playcount(artistId, playcount)
+ * per cada registre. Un registre tallat o amb el crc incorrecte acaba el fitxer, i es treu del fitxer
+ * perquè els registres nous vagin just després de l'últim correcte. Si el fitxer no existeix no fa res.
+ * @return size_t nombre de registres llegits
+*/
+template <class FA, class FP>
+size_t RegistreEscriptura::reprodueix(const string& cami, FA artista, FP playcount) {
+    int fd = ::open(cami.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) return 0;
+        throw runtime_error("Error: Unable to open file " + cami + ": " + strerror(errno));
+    }
+    string dades;
+    char buffer[1 << 16];
+    ssize_t r;
+    while ((r = ::read(fd, buffer, sizeof(buffer))) != 0) {
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            throw runtime_error("No es pot llegir " + cami + ": " + strerror(errno));
+        }
+        dades.append(buffer, static_cast<size_t>(r));
+    }
+    ::close(fd);
+    if (dades.empty()) return 0;
+    if (dades.size() < sizeof(CAPCALERA) || memcmp(dades.data(), CAPCALERA, sizeof(CAPCALERA)) != 0)
+        throw runtime_error(cami + " no és un registre d'artistes\n");
+
+    size_t pos = sizeof(CAPCALERA), llegits = 0;
+    while (pos < dades.size()) {
+        size_t inici = pos;
+        uint32_t mida, crc;
+        if (!llegeixEnter(dades, pos, mida) || !llegeixEnter(dades, pos, crc) || mida == 0
+            || dades.size() - pos < mida || crc32(dades.data() + pos, mida) != crc) {
+            pos = inici;
+            break;
+        }
+        string registre = dades.substr(pos, mida);
+        pos += mida;
+        size_t p = 1;
+        uint32_t id, pc;
+        bool correcte = llegeixEnter(registre, p, id) && llegeixEnter(registre, p, pc);
+        if (correcte && registre[0] == INSEREIX) {
+            string nom, genere, pais, estils;
+            correcte = llegeixText(registre, p, nom) && llegeixText(registre, p, genere)
+                && llegeixText(registre, p, pais) && llegeixText(registre, p, estils);
+            if (correcte) artista(Artist(static_cast<int>(id), nom, genere, pais, estils, static_cast<int>(pc)));
+        } else if (correcte && registre[0] == PLAYCOUNT) {
+            playcount(static_cast<int>(id), static_cast<int>(pc));
+        } else correcte = false;
+        if (!correcte) throw runtime_error(cami + ": registre desconegut\n");
+        llegits++;
+    }
+    // La cua tallada per una caiguda es descarta
+    if (pos < dades.size() && ::truncate(cami.c_str(), static_cast<off_t>(pos)) < 0)
+        throw runtime_error("No es pot truncar " + cami + ": " + strerror(errno));
+    return llegits;
+}
+
+/**
+ * Escriu una instantània amb tots els artistes. S'escriu a un fitxer temporal que després
+ * substitueix l'anterior (rename és atòmic), així una caiguda mai deixa una instantània a mitges.
+ * Quan torna, el rename ja és durable (s'ha sincronitzat el directori) i es pot buidar el registre
+*/
+void RegistreEscriptura::escriuInstantania(const string& cami, const vector<const Artist*>& artistes) {
+    string temporal = cami + ".tmp";
+    int fd = obre(temporal, O_WRONLY | O_CREAT | O_TRUNC);
+    try {
+        string sortida(CAPCALERA, sizeof(CAPCALERA));
+        for (const Artist* a : artistes) {
+            emmarca(sortida, codificaArtista(*a));
+            if (sortida.size() >= (1 << 20)) {
+                escriuTot(fd, sortida.data(), sortida.size());
+                sortida.clear();
+            }
+        }
+        escriuTot(fd, sortida.data(), sortida.size());
+        sincronitzaFitxer(fd);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    if (::rename(temporal.c_str(), cami.c_str()) < 0)
+        throw runtime_error("No es pot substituir " + cami + ": " + strerror(errno));
+    sincronitzaDirectori(cami);
+}
+
+/**
+ * Recupera un cercador: reprodueix la instantània (cami + ".snap") i després el registre a sobre dels
+ * artistes que ja té. Un artista que ja existeix només canvia de playcount, així reproduir dos cops
+ * la mateixa instantània o el mateix registre deixa el cercador igual
+ * @return size_t registres reproduïts
+*/
+template <class Cercador>
+size_t recuperaRegistre(Cercador& cercador, const string& cami) {
+    auto artista = [&cercador](const Artist& a) {
+        if (!cercador.actualitzaPlaycount(a.getArtistId(), a.getPlaycount()))
+            cercador.insereixArtista(a.getArtistId(), a.getName(), a.getGender(), a.getCountry(), a.getStyles(), a.getPlaycount());
+    };
+    auto playcount = [&cercador](int artistId, int pc) { cercador.actualitzaPlaycount(artistId, pc); };
+    size_t n = RegistreEscriptura::reprodueix(cami + ".snap", artista, playcount);
+    return n + RegistreEscriptura::reprodueix(cami, artista, playcount);
+}
+
+#else
+
+// Sense POSIX el registre no està disponible
+class RegistreEscriptura {
+public:
+    explicit RegistreEscriptura(const string&, unsigned = 2) { throw runtime_error("El registre necessita POSIX\n"); }
+    uint64_t registraArtista(const Artist&) { return 0; }
+    uint64_t registraPlaycount(int, int) { return 0; }
+    void sincronitza(uint64_t) {}
+    void sincronitza() {}
+    void buida() {}
+    EstadistiquesRegistre estadistiques() const { return EstadistiquesRegistre(); }
+    static void escriuInstantania(const string&, const vector<const Artist*>&) { throw runtime_error("El registre necessita POSIX\n"); }
+};
+
+template <class Cercador>
+size_t recuperaRegistre(Cercador&, const string&) {
+    throw runtime_error("El registre necessita POSIX\n");
+}
+
+#endif
+
+#endif /* REGISTREESCRIPTURA_H */
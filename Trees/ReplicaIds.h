@@ -0,0 +1,151 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Read-only replica of the artist ids (Rèplica d'ids).
+ * activaConjuntIds of the search engines adds a ConjuntEliasFano next to the tree and the indexes,
+ * so the memory of the engine only grows. A ReplicaIds keeps only the ConjuntEliasFano of the ids,
+ * without the tree, the indexes nor the text of the artists, and answers the membership and pagination
+ * queries (buscarArtista, obtenirPaginaIds, obtenirIdsDesDe) with the same results as the engine.
+ * It is built from a search engine (the engine can be destroyed afterwards) or directly from a
+ * MagatzemArtistes file, reading its blocks one by one without loading the artists in a tree.
+ * The replica cannot change: a new id needs a new replica.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - Building: O(n) from the ids, plus reading the engine or the file.
+ * - buscarArtista: O(1) (see ConjuntEliasFano::conte).
+ * - obtenirPaginaIds, obtenirIdsDesDe: O(1 + mida).
+ * - About 2 + log2(U / n) bits per id (U is the range of the ids), instead of a tree node per artist.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * ids : ConjuntEliasFano with all the ids of the replica.
+ *
+ * ################################################
+ *
+ * ################################################
+ * METHODS
+ *
+ * CONSTRUCTORS  ##################################
+ *
+ * ReplicaIds : Builds the replica from sorted ids without repeats.
+ * deCercador : Builds the replica with the ids of a search engine (tree and cold store).
+ * deMagatzem : Builds the replica with the ids of a MagatzemArtistes file.
+ *
+ * CONSULTORS #####################################
+ *
+ * buscarArtista : Returns true if the id is in the replica.
+ * obtenirPaginaIds : Returns the page number pagina (from 0) of the sorted ids.
+ * obtenirIdsDesDe : Returns the first mida ids greater or equal than an id (pagination by key).
+ * mida, memoria : Returns the number of ids and the bytes used.
+ * conjunt : Returns the ConjuntEliasFano of the ids.
+ *
+ * ################################################
+ */
+
+#ifndef REPLICAIDS_H
+#define REPLICAIDS_H
+#include "ConjuntEliasFano.h"
+#include "MagatzemArtistes.h"
+#include <vector>
+#include <list>
+#include <string>
+#include <climits>
+
+using namespace std;
+
+class ReplicaIds {
+public:
+    explicit ReplicaIds(const vector<int>& ids);
+
+    template <class Cercador>
+    static ReplicaIds deCercador(const Cercador& cercador);
+    static ReplicaIds deMagatzem(const string& cami);
+
+    bool buscarArtista(int ArtistID) const;
+    list<int> obtenirPaginaIds(size_t pagina, size_t mida) const;
+    list<int> obtenirIdsDesDe(int primer, size_t mida) const;
+
+    size_t mida() const;
+    size_t memoria() const;
+    const ConjuntEliasFano& conjunt() const;
+
+private:
+    ConjuntEliasFano ids;
+};
+
+/**
+ * Constructor amb els ids, que han d'estar ordenats i sense repetits
+*/
+ReplicaIds::ReplicaIds(const vector<int>& ids): ids(ids) {}
+
+/**
+ * Construeix la rèplica amb els ids d'un cercador (els de l'arbre i els del magatzem en disc)
+ * @return ReplicaIds rèplica dels ids
+*/
+template <class Cercador>
+ReplicaIds ReplicaIds::deCercador(const Cercador& cercador) {
+    return ReplicaIds(cercador.obtenirIds());
+}
+
+/**
+ * Construeix la rèplica amb els ids d'un magatzem en disc, sense carregar-ne els artistes
+ * @return ReplicaIds rèplica dels ids
+*/
+ReplicaIds ReplicaIds::deMagatzem(const string& cami) {
+    // Cada bloc es llegeix un sol cop: no cal cache
+    MagatzemArtistes magatzem(cami, 1);
+    vector<int> ids;
+    ids.reserve(magatzem.mida());
+    magatzem.recorreIds(INT_MIN, INT_MAX, [&ids](int id) { ids.push_back(id); });
+    return ReplicaIds(ids);
+}
+
+bool ReplicaIds::buscarArtista(int ArtistID) const {
+    return ids.conte(ArtistID);
+}
+
+/**
+ * Obté la pàgina número pagina (des de 0) dels ids ordenats, amb mida ids per pàgina
+ * @return list<int> identificadors ordenats
+*/
+list<int> ReplicaIds::obtenirPaginaIds(size_t pagina, size_t mida) const {
+    list<int> pagines;
+    if (mida == 0) return pagines;
+    ids.recorre(pagina * mida, [&pagines, mida](int id) { pagines.push_back(id); return pagines.size() < mida; });
+    return pagines;
+}
+
+/**
+ * Obté els mida primers ids més grans o iguals que primer (paginació per clau)
+ * @return list<int> identificadors ordenats
+*/
+list<int> ReplicaIds::obtenirIdsDesDe(int primer, size_t mida) const {
+    list<int> pagina;
+    if (mida == 0) return pagina;
+    ids.recorre(ids.comptaMenors(primer), [&pagina, mida](int id) { pagina.push_back(id); return pagina.size() < mida; });
+    return pagina;
+}
+
+size_t ReplicaIds::mida() const {
+    return ids.mida();
+}
+
+/**
+ * Bytes que fa servir la rèplica
+ * @return size_t bytes
+*/
+size_t ReplicaIds::memoria() const {
+    return sizeof(ReplicaIds) + ids.memoria();
+}
+
+const ConjuntEliasFano& ReplicaIds::conjunt() const {
+    return ids;
+}
+
+#endif /* REPLICAIDS_H */
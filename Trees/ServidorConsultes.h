@@ -0,0 +1,464 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Local query server (Servidor de consultes).
+ * This class keeps a search engine loaded in a long running process and answers the queries of
+ * other local processes through a Unix domain socket. One thread runs an epoll event loop that
+ * accepts the connections and reads and writes the sockets; the queries are answered by a pool
+ * of worker threads.
+ * ################################################
+ *
+ * ################################################
+ * PROTOCOL
+ *
+ * One query per line, with the format of ConsultesLot (id, mostra, estil, nom, prefix, recompte), and one
+ * answer line per query, in the same order ("error: ..." if the query is wrong). A client can send
+ * many queries without waiting for the answers (pipelining): all the complete lines read at once
+ * are answered by a worker as one batch (up to MAX_LOT lines) and written with one write().
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - Every event of the loop is O(1) plus the bytes read or written. A batch of q queries is O(q * c)
+ *   in a worker, where c is the cost of one query.
+ * - Every connection uses its input and output buffers. A connection stops being read while it has
+ *   MAX_LOTS_PENDENTS batches or MAX_SORTIDA bytes waiting, so a slow client cannot fill the memory.
+ *   A connection that sends more than MAX_SORTIDA bytes without a line break is closed.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * connexions : Open connections by their id (the id is never reused, unlike the fd).
+ * respostes : Batches answered by the workers and not yet taken by the event loop.
+ * fdAvis : eventfd that the workers (and atura) use to wake up the event loop.
+ * pool : Worker threads.
+ *
+ * ################################################
+ * METHODS
+ *
+ * ServidorConsultes : Creates the socket in the path cami (it is removed first if it exists).
+ * executa : Runs the event loop until atura is called.
+ * atura : Stops the event loop. It can be called from any thread.
+ * estadistiques : Connections and queries answered.
+ *
+ * ################################################
+ */
+
+#ifndef SERVIDORCONSULTES_H
+#define SERVIDORCONSULTES_H
+#include "ConsultesLot.h"
+#include "PoolFils.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+struct EstadistiquesServidor {
+    size_t connexions = 0;
+    size_t consultes = 0;
+    size_t lots = 0;
+};
+
+template <class Cercador>
+class ServidorConsultes {
+public:
+    static const size_t MAX_LOT = 1024;
+    static const size_t MAX_LOTS_PENDENTS = 64;
+    static const size_t MAX_SORTIDA = 8 << 20;
+
+    ServidorConsultes(Cercador& cercador, const string& cami, unsigned fils = 0);
+    ServidorConsultes(const ServidorConsultes&) = delete;
+    ServidorConsultes& operator=(const ServidorConsultes&) = delete;
+    ~ServidorConsultes();
+
+    void executa();
+    void atura();
+    EstadistiquesServidor estadistiques() const;
+
+private:
+    static const uint64_t ESCOLTA = 0;
+    static const uint64_t AVIS = 1;
+
+    struct Connexio {
+        int fd;
+        string entrada;
+        string sortida;
+        size_t enviat = 0;              // Bytes de sortida ja escrits
+        uint64_t lotsEnviats = 0;       // Lots donats als fils
+        uint64_t lotsEscrits = 0;       // Lots ja posats a sortida (en ordre)
+        map<uint64_t, string> acabats;  // Lots acabats que esperen els anteriors
+        bool tancada = false;           // El client ha tancat la connexió
+        uint32_t events = 0;            // Events registrats a epoll
+    };
+
+    struct Resposta {
+        uint64_t connexio;
+        uint64_t lot;
+        string text;
+    };
+
+    Cercador& cercador;
+    string cami;
+    int fdEscolta, fdEpoll, fdAvis;
+    map<uint64_t, unique_ptr<Connexio>> connexions;
+    uint64_t seguentId;
+    mutex mtxRespostes;
+    vector<Resposta> respostes;
+    atomic<bool> aturat;
+    atomic<size_t> nConnexions, nConsultes, nLots;
+    unique_ptr<PoolFils> pool;
+
+    void accepta();
+    void llegeix(uint64_t id, Connexio& c);
+    void enviaLots(uint64_t id, Connexio& c);
+    void recullRespostes();
+    bool escriu(Connexio& c);
+    void actualitzaInteres(uint64_t id, Connexio& c);
+    void tanca(uint64_t id);
+    void avisa();
+};
+
+#if defined(__linux__)
+
+/**
+ * Constructor: crea el socket d'escolta, epoll i l'eventfd dels avisos
+*/
+template <class Cercador>
+ServidorConsultes<Cercador>::ServidorConsultes(Cercador& cercador, const string& cami, unsigned fils):
+    cercador(cercador), cami(cami), fdEscolta(-1), fdEpoll(-1), fdAvis(-1), seguentId(2),
+    aturat(false), nConnexions(0), nConsultes(0), nLots(0), pool(new PoolFils(fils)) {
+    sockaddr_un adreca;
+    memset(&adreca, 0, sizeof(adreca));
+    adreca.sun_family = AF_UNIX;
+    if (cami.size() >= sizeof(adreca.sun_path)) throw invalid_argument("Cami del socket massa llarg\n");
+    memcpy(adreca.sun_path, cami.c_str(), cami.size() + 1);
+
+    fdEscolta = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fdEscolta < 0) throw runtime_error(string("socket: ") + strerror(errno));
+    ::unlink(cami.c_str());
+    if (::bind(fdEscolta, reinterpret_cast<sockaddr*>(&adreca), sizeof(adreca)) < 0
+        || ::listen(fdEscolta, SOMAXCONN) < 0) {
+        string error = strerror(errno);
+        ::close(fdEscolta);
+        throw runtime_error("No es pot escoltar a " + cami + ": " + error);
+    }
+
+    fdEpoll = ::epoll_create1(EPOLL_CLOEXEC);
+    fdAvis = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = ESCOLTA;
+    ::epoll_ctl(fdEpoll, EPOLL_CTL_ADD, fdEscolta, &ev);
+    ev.data.u64 = AVIS;
+    ::epoll_ctl(fdEpoll, EPOLL_CTL_ADD, fdAvis, &ev);
+}
+
+/**
+ * Destructor: espera els fils (que encara poden avisar) i després tanca tots els descriptors
+*/
+template <class Cercador>
+ServidorConsultes<Cercador>::~ServidorConsultes() {
+    pool.reset();
+    for (auto& c : connexions) ::close(c.second->fd);
+    if (fdAvis >= 0) ::close(fdAvis);
+    if (fdEpoll >= 0) ::close(fdEpoll);
+    if (fdEscolta >= 0) ::close(fdEscolta);
+    ::unlink(cami.c_str());
+}
+
+/**
+ * Desperta el bucle d'events
+*/
+template <class Cercador>
+void ServidorConsultes<Cercador>::avisa() {
+    uint64_t u = 1;
+    ssize_t r = ::write(fdAvis, &u, sizeof(u));
+    (void) r;
+}
+
+/**
+ * Atura el bucle d'events. Es pot cridar des de qualsevol fil
+*/
+template <class Cercador>
+void ServidorConsultes<Cercador>::atura() {
+    aturat = true;
+    avisa();
+}
+
+/**
+ * Bucle d'events: accepta connexions, llegeix consultes, recull les respostes dels fils i les escriu
+*/
+template <class Cercador>
+void ServidorConsultes<Cercador>::executa() {
+    const int MAX_EVENTS = 256;
+    epoll_event events[MAX_EVENTS];
+    while (!aturat) {
+        int n = ::epoll_wait(fdEpoll, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw runtime_error(string("epoll_wait: ") + strerror(errno));
+        }
+        for (int i = 0; i < n; i++) {
+            uint64_t id = events[i].data.u64;
+            if (id == ESCOLTA) accepta();
+            else if (id == AVIS) {
+                uint64_t u;
+                while (::read(fdAvis, &u, sizeof(u)) > 0) {}
+                recullRespostes();
+            } else {
+                auto it = connexions.find(id);
+                if (it == connexions.end()) continue;
+                Connexio& c = *it->second;
+                if (events[i].events & (EPOLLERR | EPOLLHUP) && !(events[i].events & EPOLLIN)) {
+                    tanca(id);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT && !escriu(c)) {
+                    tanca(id);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) llegeix(id, c);
+                else actualitzaInteres(id, c);
+            }
+        }
+    }
+}
+
+/**
+ * Accepta totes les connexions pendents
+*/
+template <class Cercador>
+void ServidorConsultes<Cercador>::accepta() {
+    while (true) {
+        int fd = ::accept4(fdEscolta, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        uint64_t id = seguentId++;
+        unique_ptr<Connexio> c(new Connexio());
+        c->fd = fd;
+        c->events = EPOLLIN;
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = id;
+        ::epoll_ctl(fdEpoll, EPOLL_CTL_ADD, fd, &ev);
+        connexions[id] = move(c);
+        nConnexions++;
+    }
+}
+
+/**
+ * Llegeix tot el que ha arribat per una connexió i envia les línies completes als fils
+*/
+template <class Cercador>
+void ServidorConsultes<Cercador>::llegeix(uint64_t id, Connexio& c) {
+    char buffer[1 << 16];
+    // Com a molt 1 MiB per event, perquè una connexió no deixi les altres sense servir
+    for (int lectures = 0; lectures < 16; lectures++) {
+        ssize_t r = ::read(c.fd, buffer, sizeof(buffer));
+        if (r > 0) {
+            c.entrada.append(buffer, static_cast<size_t>(r));
+            if (static_cast<size_t>(r) < sizeof(buffer)) break;
+        } else if (r == 0) {
+            // L'última línia pot no tenir salt de línia
+            if (!c.entrada.empty()) c.entrada += '\n';
+            c.tancada = true;
+            break;
+        } else {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            tanca(id);
+            return;
+        }
+    }
+    enviaLots(id, c);
+    // Només hi queda l'última línia, sense acabar: si és massa llarga el client no envia consultes
+    if (c.entrada.size() > MAX_SORTIDA) {
+        tanca(id);
+        return;
+    }
+    if (c.tancada && c.lotsEnviats == c.lotsEscrits && c.enviat == c.sortida.size()) tanca(id);
+    else actualitzaInteres(id, c);
+}
+
+/**
+ * Agrupa les línies completes de l'entrada en lots i els dona als fils
+*/
+template <class Cercador>
+void ServidorConsultes<Cercador>::enviaLots(uint64_t id, Connexio& c) {
+    size_t inici = 0;
+    while (inici < c.entrada.size()) {
+        size_t fi = inici, linies = 0;
+        while (linies < MAX_LOT) {
+            size_t salt = c.entrada.find('\n', fi);
+            if (salt == string::npos) break;
+            fi = salt + 1;
+            linies++;
+        }
+        if (linies == 0) break;
+
+        string lot = c.entrada.substr(inici, fi - inici);
+        uint64_t numero = c.lotsEnviats++;
+        pool->envia([this, id, numero, lot = move(lot)]() {
+            string text;
+            text.reserve(lot.size() * 2);
+            size_t consultes = 0;
+            string_view resta(lot);
+            while (!resta.empty()) {
+                size_t salt = resta.find('\n');
+                string_view linia = resta.substr(0, salt);
+                resta.remove_prefix(salt + 1);
+                if (!linia.empty() && linia.back() == '\r') linia.remove_suffix(1);
+                try {
+                    respondreConsulta(cercador, linia, text);
+                } catch (const exception& e) {
+                    text += "error: ";
+                    text += e.what();
+                    while (!text.empty() && text.back() == '\n') text.pop_back();
+                }
+                text += '\n';
+                consultes++;
+            }
+            nConsultes += consultes;
+            nLots++;
+            {
+                lock_guard<mutex> lock(mtxRespostes);
+                respostes.push_back(Resposta{id, numero, move(text)});
+            }
+            avisa();
+        });
+        inici = fi;
+    }
+    c.entrada.erase(0, inici);
+}
+
+/**
+ * Recull els lots acabats pels fils i els posa a la sortida de cada connexió en ordre
+*/
+template <class Cercador>
+void ServidorConsultes<Cercador>::recullRespostes() {
+    vector<Resposta> acabades;
+    {
+        lock_guard<mutex> lock(mtxRespostes);
+        acabades.swap(respostes);
+    }
+    vector<uint64_t> tocades;
+    for (Resposta& r : acabades) {
+        auto it = connexions.find(r.connexio);
+        if (it == connexions.end()) continue; // La connexió s'ha tancat
+        it->second->acabats[r.lot] = move(r.text);
+        tocades.push_back(r.connexio);
+    }
+    for (uint64_t id : tocades) {
+        auto it = connexions.find(id);
+        if (it == connexions.end()) continue;
+        Connexio& c = *it->second;
+        auto a = c.acabats.find(c.lotsEscrits);
+        while (a != c.acabats.end()) {
+            c.sortida += a->second;
+            c.acabats.erase(a);
+            a = c.acabats.find(++c.lotsEscrits);
+        }
+        if (!escriu(c)) tanca(id);
+        else if (c.tancada && c.lotsEnviats == c.lotsEscrits && c.enviat == c.sortida.size()) tanca(id);
+        else actualitzaInteres(id, c);
+    }
+}
+
+/**
+ * Escriu tot el que pugui de la sortida d'una connexió sense bloquejar
+ * @return bool false si hi ha hagut un error i s'ha de tancar la connexió
+*/
+template <class Cercador>
+bool ServidorConsultes<Cercador>::escriu(Connexio& c) {
+    while (c.enviat < c.sortida.size()) {
+        ssize_t w = ::send(c.fd, c.sortida.data() + c.enviat, c.sortida.size() - c.enviat, MSG_NOSIGNAL);
+        if (w > 0) c.enviat += static_cast<size_t>(w);
+        else if (w < 0 && errno == EINTR) continue;
+        else return w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+    c.sortida.clear();
+    c.enviat = 0;
+    return true;
+}
+
+/**
+ * Registra a epoll els events que interessen: llegir si la connexió no té massa feina pendent,
+ * i escriure si queda sortida per enviar
+*/
+template <class Cercador>
+void ServidorConsultes<Cercador>::actualitzaInteres(uint64_t id, Connexio& c) {
+    uint32_t events = 0;
+    size_t pendent = c.sortida.size() - c.enviat;
+    if (!c.tancada && c.lotsEnviats - c.lotsEscrits < MAX_LOTS_PENDENTS && pendent < MAX_SORTIDA) events |= EPOLLIN;
+    if (pendent > 0) events |= EPOLLOUT;
+    if (events == c.events) return;
+    epoll_event ev;
+    ev.events = events;
+    ev.data.u64 = id;
+    ::epoll_ctl(fdEpoll, EPOLL_CTL_MOD, c.fd, &ev);
+    c.events = events;
+}
+
+/**
+ * Tanca una connexió. Les respostes que encara facin els fils per ella es descarten
+*/
+template <class Cercador>
+void ServidorConsultes<Cercador>::tanca(uint64_t id) {
+    auto it = connexions.find(id);
+    if (it == connexions.end()) return;
+    ::epoll_ctl(fdEpoll, EPOLL_CTL_DEL, it->second->fd, nullptr);
+    ::close(it->second->fd);
+    connexions.erase(it);
+}
+
+#else
+
+template <class Cercador>
+ServidorConsultes<Cercador>::ServidorConsultes(Cercador& cercador, const string& cami, unsigned):
+    cercador(cercador), cami(cami), fdEscolta(-1), fdEpoll(-1), fdAvis(-1), seguentId(2),
+    aturat(false), nConnexions(0), nConsultes(0), nLots(0) {
+    throw runtime_error("El servidor de consultes necessita Linux (epoll)\n");
+}
+
+template <class Cercador>
+ServidorConsultes<Cercador>::~ServidorConsultes() {}
+
+template <class Cercador>
+void ServidorConsultes<Cercador>::executa() {}
+
+template <class Cercador>
+void ServidorConsultes<Cercador>::atura() {}
+
+#endif
+
+/**
+ * Connexions acceptades, consultes i lots contestats
+ * @return EstadistiquesServidor estadístiques
+*/
+template <class Cercador>
+EstadistiquesServidor ServidorConsultes<Cercador>::estadistiques() const {
+    EstadistiquesServidor e;
+    e.connexions = nConnexions;
+    e.consultes = nConsultes;
+    e.lots = nLots;
+    return e;
+}
+
+#endif /* SERVIDORCONSULTES_H */
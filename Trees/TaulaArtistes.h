@@ -0,0 +1,513 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Columnar artist table (Taula d'artistes per columnes).
+ * This class keeps the fields used by the analytic queries in contiguous arrays (one array per
+ * field, struct-of-arrays), next to the tree index of the search engine. Filters and aggregates
+ * scan the arrays in blocks with loops without branches that the compiler vectorizes (SIMD),
+ * and can split the scan between several threads.
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - afegeix: O(1) amortized. canviaPlaycount: O(1) average (HashTable from id to row).
+ * - compta, filtra, sumaPlaycount: O(n / fils) time, reading only the columns used by the filter.
+ * - compleix: O(1) average for one artist (HashTable lookup of its row).
+ * - top: O(n / fils + n log k) in the worst case, one pass with a MinHeap of size k per thread.
+ * - agrupa: O(n / fils + g * fils) average, where g is the number of groups. Every thread aggregates
+ *   its rows in its own HashTable of groups and the partial groups are merged at the end.
+ * - A style filter first checks every different styles string (O(d)), then each row does one lookup.
+ * - The columns use 16 bytes per artist, plus one bitset per different styles string. The files HashTable
+ *   adds about 32 bytes per artist (a list node) plus 24 bytes per bucket, between 64 and 96 bytes per
+ *   artist depending on its load, so the whole table uses about 80 to 110 bytes per artist.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * ids, playcounts, paisos, generes, conjunts : One array per field. Row i is the i-th inserted artist.
+ *     paisos and generes are Artist dictionary codes, conjunts is the code of the styles string.
+ * bitsEstils : For every styles code, a bitset with one bit per style token (positions of IndexEstils).
+ * files : HashTable from artistId to its row.
+ * pool : Thread pool shared by the scans with more than one thread, created by the first one and
+ *        created again only if a scan asks for a different number of threads.
+ *
+ * A FiltreArtistes is a filter written with texts (country, gender, styles) for the search engines.
+ * A FiltreCodis is the same filter translated to dictionary codes, the one used by the scans.
+ * An AgregatPlaycount keeps count, sum, minimum and maximum of the playcounts of a group (GROUP BY).
+ *
+ * ################################################
+ */
+
+#ifndef TAULAARTISTES_H
+#define TAULAARTISTES_H
+#include "Artist.h"
+#include "PoolFils.h"
+#include "../Heap/MinHeap/MinHeap.h"
+#include "../Hash_Tables/HashTable.h"
+#include <vector>
+#include <list>
+#include <string>
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+
+using namespace std;
+
+struct FiltreArtistes {
+    int minPlaycount = INT_MIN;
+    int maxPlaycount = INT_MAX;
+    string pais;            // Buit: qualsevol país
+    string genere;          // Buit: qualsevol gènere
+    list<string> estils;    // L'artista ha de tenir tots aquests estils
+};
+
+struct FiltreCodis {
+    int minPlaycount = INT_MIN;
+    int maxPlaycount = INT_MAX;
+    int pais = -1;              // -1: qualsevol país
+    int genere = -1;            // -1: qualsevol gènere
+    vector<uint32_t> estils;    // Posicions dels estils a IndexEstils
+    bool impossible = false;    // Algun text del filtre no existeix: cap artista el compleix
+};
+
+// Camps d'agrupació, es poden combinar: AGRUPA_PAIS | AGRUPA_GENERE
+enum CampsAgrupacio { AGRUPA_PAIS = 1, AGRUPA_GENERE = 2, AGRUPA_ESTIL = 4 };
+
+struct AgregatPlaycount {
+    size_t recompte = 0;
+    long long suma = 0;
+    int minim = INT_MAX;
+    int maxim = INT_MIN;
+
+    void afegeix(int playcount);
+    void fusiona(const AgregatPlaycount& altre);
+    double mitjana() const;
+};
+
+struct GrupArtistes {
+    string pais;            // Buit si no s'agrupa per país
+    string genere;          // Buit si no s'agrupa per gènere
+    string estil;           // Buit si no s'agrupa per estil
+    AgregatPlaycount agregat;
+};
+
+class TaulaArtistes {
+public:
+    TaulaArtistes();
+
+    void afegeix(const Artist& a, const vector<uint32_t>& posicionsEstils);
+    bool canviaPlaycount(int artistId, int playcount);
+
+    size_t mida() const;
+    size_t compta(const FiltreCodis& f, unsigned fils = 1) const;
+    vector<int> filtra(const FiltreCodis& f, unsigned fils = 1) const;
+    long long sumaPlaycount(const FiltreCodis& f, unsigned fils = 1) const;
+    vector<pair<int, int>> top(const FiltreCodis& f, size_t k, unsigned fils = 1) const;
+    bool compleix(int artistId, const FiltreCodis& f) const;
+    vector<pair<uint64_t, AgregatPlaycount>> agrupa(const FiltreCodis& f, unsigned camps, unsigned fils = 1) const;
+    static uint64_t clauGrup(uint16_t pais, uint16_t genere, uint32_t conjunt);
+
+    const vector<int>& columnaIds() const;
+    const vector<int>& columnaPlaycounts() const;
+    const vector<uint16_t>& columnaPaisos() const;
+    const vector<uint16_t>& columnaGeneres() const;
+    const vector<uint32_t>& columnaConjunts() const;
+
+    template <class F>
+    void recorre(const FiltreCodis& f, unsigned fils, F visita) const;
+
+private:
+    static const size_t BLOC = 1024;
+
+    // Grups d'un fil: la HashTable dona la posició de cada grup als vectors, que es recorren en fusionar
+    struct alignas(64) GrupsParcials {
+        HashTable<uint64_t, uint32_t> posicions;
+        vector<uint64_t> claus;
+        vector<AgregatPlaycount> agregats;
+        uint64_t darreraClau = UINT64_MAX;
+        uint32_t darreraPosicio = 0;
+
+        GrupsParcials(): posicions(64) {}
+        AgregatPlaycount& grup(uint64_t clau);
+        static uint64_t barreja(uint64_t clau);
+    };
+
+    vector<int> ids;
+    vector<int> playcounts;
+    vector<uint16_t> paisos;
+    vector<uint16_t> generes;
+    vector<uint32_t> conjunts;
+    vector<vector<uint64_t>> bitsEstils;
+    HashTable<int, uint32_t> files;
+    mutable shared_ptr<PoolFils> pool;
+    mutable mutex mtxPool;
+
+    shared_ptr<PoolFils> poolDe(unsigned fils) const;
+    vector<uint8_t> conjuntsValids(const FiltreCodis& f) const;
+    void marcaBloc(const FiltreCodis& f, const vector<uint8_t>& valids, size_t inici, size_t fi, uint8_t* marca) const;
+    static void afegeixAlTop(MinHeap<pair<int, int>>& heap, size_t k, const pair<int, int>& candidat);
+};
+
+/**
+ * Constructor sense paràmetres
+*/
+TaulaArtistes::TaulaArtistes(): files(1024) {}
+
+/**
+ * Afegeix una fila amb l'artista al final de la taula
+*/
+void TaulaArtistes::afegeix(const Artist& a, const vector<uint32_t>& posicionsEstils) {
+    files.insert(a.getArtistId(), static_cast<uint32_t>(ids.size()));
+    ids.push_back(a.getArtistId());
+    playcounts.push_back(a.getPlaycount());
+    paisos.push_back(a.getCountryCode());
+    generes.push_back(a.getGenderCode());
+    uint32_t c = a.getStylesCode();
+    conjunts.push_back(c);
+
+    if (c >= bitsEstils.size()) bitsEstils.resize(c + 1);
+    if (bitsEstils[c].empty() && !posicionsEstils.empty()) {
+        uint32_t maxim = *max_element(posicionsEstils.begin(), posicionsEstils.end());
+        bitsEstils[c].assign(maxim / 64 + 1, 0);
+        for (uint32_t p : posicionsEstils) bitsEstils[c][p / 64] |= uint64_t(1) << (p % 64);
+    }
+}
+
+/**
+ * Canvia el playcount de la fila d'un artista
+ * @return bool si l'artista és a la taula
+*/
+bool TaulaArtistes::canviaPlaycount(int artistId, int playcount) {
+    if (!files.contains(artistId)) return false;
+    playcounts[files.get(artistId)] = playcount;
+    return true;
+}
+
+size_t TaulaArtistes::mida() const {
+    return ids.size();
+}
+
+/**
+ * Consultors de les columnes
+*/
+const vector<int>& TaulaArtistes::columnaIds() const { return ids; }
+const vector<int>& TaulaArtistes::columnaPlaycounts() const { return playcounts; }
+const vector<uint16_t>& TaulaArtistes::columnaPaisos() const { return paisos; }
+const vector<uint16_t>& TaulaArtistes::columnaGeneres() const { return generes; }
+const vector<uint32_t>& TaulaArtistes::columnaConjunts() const { return conjunts; }
+
+/**
+ * Comprova si un sol artista compleix el filtre, sense recórrer la taula
+ * @return bool si l'artista és a la taula i compleix el filtre
+*/
+bool TaulaArtistes::compleix(int artistId, const FiltreCodis& f) const {
+    if (f.impossible || !files.contains(artistId)) return false;
+    uint32_t fila = files.get(artistId);
+    if (playcounts[fila] < f.minPlaycount || playcounts[fila] > f.maxPlaycount) return false;
+    if (f.pais >= 0 && paisos[fila] != f.pais) return false;
+    if (f.genere >= 0 && generes[fila] != f.genere) return false;
+    const vector<uint64_t>& bits = bitsEstils[conjunts[fila]];
+    for (uint32_t p : f.estils) {
+        if (p / 64 >= bits.size() || !(bits[p / 64] & (uint64_t(1) << (p % 64)))) return false;
+    }
+    return true;
+}
+
+/**
+ * Per cada codi d'estils, 1 si té tots els estils del filtre
+ * @return vector<uint8_t> amb una posició per codi d'estils (buit si el filtre no té estils)
+*/
+vector<uint8_t> TaulaArtistes::conjuntsValids(const FiltreCodis& f) const {
+    vector<uint8_t> valids;
+    if (f.estils.empty()) return valids;
+    valids.assign(bitsEstils.size(), 0);
+    for (size_t c = 0; c < bitsEstils.size(); c++) {
+        const vector<uint64_t>& bits = bitsEstils[c];
+        bool te = true;
+        for (uint32_t p : f.estils) {
+            if (p / 64 >= bits.size() || !(bits[p / 64] & (uint64_t(1) << (p % 64)))) {
+                te = false;
+                break;
+            }
+        }
+        valids[c] = te;
+    }
+    return valids;
+}
+
+/**
+ * Marca amb 1 les files de [inici, fi) que compleixen el filtre.
+ * Cada predicat és un bucle separat sense salts sobre una sola columna, perquè el compilador el vectoritzi.
+*/
+void TaulaArtistes::marcaBloc(const FiltreCodis& f, const vector<uint8_t>& valids, size_t inici, size_t fi, uint8_t* marca) const {
+    size_t n = fi - inici;
+    const int* pc = playcounts.data() + inici;
+    const int lo = f.minPlaycount, hi = f.maxPlaycount;
+    for (size_t i = 0; i < n; i++) marca[i] = (pc[i] >= lo) & (pc[i] <= hi);
+
+    if (f.pais >= 0) {
+        const uint16_t* ps = paisos.data() + inici;
+        const uint16_t p = static_cast<uint16_t>(f.pais);
+        for (size_t i = 0; i < n; i++) marca[i] &= (ps[i] == p);
+    }
+    if (f.genere >= 0) {
+        const uint16_t* gs = generes.data() + inici;
+        const uint16_t g = static_cast<uint16_t>(f.genere);
+        for (size_t i = 0; i < n; i++) marca[i] &= (gs[i] == g);
+    }
+    if (!valids.empty()) {
+        const uint32_t* cs = conjunts.data() + inici;
+        const uint8_t* v = valids.data();
+        for (size_t i = 0; i < n; i++) marca[i] &= v[cs[i]];
+    }
+}
+
+/**
+ * Pool de fils de les consultes. Es comparteix entre consultes (també de fils diferents) i només es
+ * torna a crear si es demanen uns altres fils: les consultes que encara fan servir l'anterior el mantenen viu
+ * @return shared_ptr<PoolFils> pool amb fils treballadors
+*/
+shared_ptr<PoolFils> TaulaArtistes::poolDe(unsigned fils) const {
+    lock_guard<mutex> lock(mtxPool);
+    if (!pool || pool->mida() != fils) pool = make_shared<PoolFils>(fils);
+    return pool;
+}
+
+/**
+ * Recorre les files que compleixen el filtre i crida a visita(fil, fila).
+ * Amb més d'un fil, cada fil recorre un tros de la taula i visita es crida des de diversos fils alhora.
+*/
+template <class F>
+void TaulaArtistes::recorre(const FiltreCodis& f, unsigned fils, F visita) const {
+    if (f.impossible || ids.empty()) return;
+    fils = PoolFils::filsPerDefecte(fils);
+    vector<uint8_t> valids = conjuntsValids(f);
+    auto trosFn = [&](size_t fil, size_t inici, size_t fi) {
+        uint8_t marca[BLOC];
+        for (size_t b = inici; b < fi; b += BLOC) {
+            size_t fiBloc = min(fi, b + BLOC);
+            marcaBloc(f, valids, b, fiBloc, marca);
+            for (size_t i = 0; i < fiBloc - b; i++) {
+                if (marca[i]) visita(fil, b + i);
+            }
+        }
+    };
+    if (fils <= 1 || ids.size() < BLOC * 4) trosFn(0, 0, ids.size());
+    else {
+        poolDe(fils)->perCadaBloc(ids.size(), trosFn);
+    }
+}
+
+/**
+ * Compta els artistes que compleixen el filtre
+ * @return size_t nombre d'artistes
+*/
+size_t TaulaArtistes::compta(const FiltreCodis& f, unsigned fils) const {
+    if (f.impossible || ids.empty()) return 0;
+    vector<uint8_t> valids = conjuntsValids(f);
+    fils = PoolFils::filsPerDefecte(fils);
+    vector<size_t> parcials(fils, 0);
+    auto trosFn = [&](size_t fil, size_t inici, size_t fi) {
+        uint8_t marca[BLOC];
+        size_t total = 0;
+        for (size_t b = inici; b < fi; b += BLOC) {
+            size_t fiBloc = min(fi, b + BLOC);
+            marcaBloc(f, valids, b, fiBloc, marca);
+            for (size_t i = 0; i < fiBloc - b; i++) total += marca[i];
+        }
+        parcials[fil] = total;
+    };
+    if (fils <= 1 || ids.size() < BLOC * 4) trosFn(0, 0, ids.size());
+    else {
+        poolDe(fils)->perCadaBloc(ids.size(), trosFn);
+    }
+    size_t total = 0;
+    for (size_t p : parcials) total += p;
+    return total;
+}
+
+/**
+ * Suma el playcount dels artistes que compleixen el filtre
+ * @return long long suma de reproduccions
+*/
+long long TaulaArtistes::sumaPlaycount(const FiltreCodis& f, unsigned fils) const {
+    if (f.impossible || ids.empty()) return 0;
+    vector<uint8_t> valids = conjuntsValids(f);
+    fils = PoolFils::filsPerDefecte(fils);
+    vector<long long> parcials(fils, 0);
+    auto trosFn = [&](size_t fil, size_t inici, size_t fi) {
+        uint8_t marca[BLOC];
+        long long total = 0;
+        for (size_t b = inici; b < fi; b += BLOC) {
+            size_t fiBloc = min(fi, b + BLOC);
+            marcaBloc(f, valids, b, fiBloc, marca);
+            const int* pc = playcounts.data() + b;
+            for (size_t i = 0; i < fiBloc - b; i++) total += static_cast<long long>(pc[i]) * marca[i];
+        }
+        parcials[fil] = total;
+    };
+    if (fils <= 1 || ids.size() < BLOC * 4) trosFn(0, 0, ids.size());
+    else {
+        poolDe(fils)->perCadaBloc(ids.size(), trosFn);
+    }
+    long long total = 0;
+    for (long long p : parcials) total += p;
+    return total;
+}
+
+/**
+ * Retorna els identificadors dels artistes que compleixen el filtre
+ * @return vector<int> ids ordenats
+*/
+vector<int> TaulaArtistes::filtra(const FiltreCodis& f, unsigned fils) const {
+    fils = PoolFils::filsPerDefecte(fils);
+    vector<vector<int>> parcials(fils);
+    recorre(f, fils, [&](size_t fil, size_t fila) { parcials[fil].push_back(ids[fila]); });
+    vector<int> resultat;
+    for (const vector<int>& p : parcials) resultat.insert(resultat.end(), p.begin(), p.end());
+    sort(resultat.begin(), resultat.end());
+    return resultat;
+}
+
+/**
+ * Afegeix un candidat (playcount, -artistId) a un heap que guarda els k millors.
+ * El mínim del heap és el pitjor dels k, així que només cal comparar amb ell.
+*/
+void TaulaArtistes::afegeixAlTop(MinHeap<pair<int, int>>& heap, size_t k, const pair<int, int>& candidat) {
+    if (heap.size() < k) heap.push(candidat);
+    else if (heap.top() < candidat) {
+        heap.pop();
+        heap.push(candidat);
+    }
+}
+
+/**
+ * Retorna els k artistes amb més playcount que compleixen el filtre. Cada fil omple el seu
+ * heap de mida k i al final es fusionen en un sol heap
+ * @return vector<pair<int, int>> (playcount, artistId) de més a menys playcount, a igual playcount per id
+*/
+vector<pair<int, int>> TaulaArtistes::top(const FiltreCodis& f, size_t k, unsigned fils) const {
+    vector<pair<int, int>> resultat;
+    if (k == 0) return resultat;
+    fils = PoolFils::filsPerDefecte(fils);
+    vector<MinHeap<pair<int, int>>> heaps(fils);
+    recorre(f, fils, [&](size_t fil, size_t fila) {
+        afegeixAlTop(heaps[fil], k, make_pair(playcounts[fila], -ids[fila]));
+    });
+
+    MinHeap<pair<int, int>> millors;
+    for (MinHeap<pair<int, int>>& h : heaps) {
+        while (!h.empty()) afegeixAlTop(millors, k, h.pop());
+    }
+    resultat.resize(millors.size());
+    for (size_t i = resultat.size(); i-- > 0;) {
+        pair<int, int> p = millors.pop();
+        resultat[i] = make_pair(p.first, -p.second);
+    }
+    return resultat;
+}
+
+/**
+ * Afegeix un playcount al grup
+*/
+void AgregatPlaycount::afegeix(int playcount) {
+    recompte++;
+    suma += playcount;
+    minim = min(minim, playcount);
+    maxim = max(maxim, playcount);
+}
+
+/**
+ * Afegeix tots els playcounts d'un altre grup
+*/
+void AgregatPlaycount::fusiona(const AgregatPlaycount& altre) {
+    recompte += altre.recompte;
+    suma += altre.suma;
+    minim = min(minim, altre.minim);
+    maxim = max(maxim, altre.maxim);
+}
+
+/**
+ * @return double mitjana del playcount del grup (0 si és buit)
+*/
+double AgregatPlaycount::mitjana() const {
+    return recompte ? static_cast<double>(suma) / recompte : 0.0;
+}
+
+/**
+ * Clau d'un grup: país als 16 bits alts, gènere als 16 següents i codi d'estils als 32 baixos.
+ * Els camps que no s'agrupen valen 0
+ * @return uint64_t clau del grup
+*/
+uint64_t TaulaArtistes::clauGrup(uint16_t pais, uint16_t genere, uint32_t conjunt) {
+    return (uint64_t(pais) << 48) | (uint64_t(genere) << 32) | conjunt;
+}
+
+/**
+ * Barreja els bits d'una clau (finalitzador de splitmix64, és bijectiu). La HashTable fa servir std::hash,
+ * que per enters és la identitat, i les claus de país i gènere tenen els bits baixos a 0
+ * @return uint64_t clau barrejada
+*/
+uint64_t TaulaArtistes::GrupsParcials::barreja(uint64_t clau) {
+    clau ^= clau >> 30;
+    clau *= 0xbf58476d1ce4e5b9ULL;
+    clau ^= clau >> 27;
+    clau *= 0x94d049bb133111ebULL;
+    return clau ^ (clau >> 31);
+}
+
+/**
+ * Busca el grup d'una clau i el crea si no existeix. Les files seguides solen ser del mateix grup,
+ * així que es recorda l'últim per no consultar la HashTable
+ * @return AgregatPlaycount& agregat del grup
+*/
+AgregatPlaycount& TaulaArtistes::GrupsParcials::grup(uint64_t clau) {
+    if (clau != darreraClau) {
+        uint64_t barrejada = barreja(clau);
+        if (posicions.contains(barrejada)) darreraPosicio = posicions.get(barrejada);
+        else {
+            darreraPosicio = static_cast<uint32_t>(claus.size());
+            posicions.insert(barrejada, darreraPosicio);
+            claus.push_back(clau);
+            agregats.emplace_back();
+        }
+        darreraClau = clau;
+    }
+    return agregats[darreraPosicio];
+}
+
+/**
+ * Agrupa els artistes que compleixen el filtre pels camps indicats (país, gènere i codi d'estils)
+ * i calcula el recompte, la suma, el mínim i el màxim del playcount de cada grup.
+ * Cada fil agrega les seves files en la seva HashTable i al final es fusionen.
+ * Amb AGRUPA_ESTIL els grups són per codi d'estils (el text sencer): cal repartir-los per estil
+ * @return vector<pair<uint64_t, AgregatPlaycount>> (clauGrup, agregat) ordenats per clau
+*/
+vector<pair<uint64_t, AgregatPlaycount>> TaulaArtistes::agrupa(const FiltreCodis& f, unsigned camps, unsigned fils) const {
+    fils = PoolFils::filsPerDefecte(fils);
+    const uint64_t mascara = clauGrup((camps & AGRUPA_PAIS) ? UINT16_MAX : 0, (camps & AGRUPA_GENERE) ? UINT16_MAX : 0,
+        (camps & AGRUPA_ESTIL) ? UINT32_MAX : 0);
+    vector<GrupsParcials> parcials(fils);
+    recorre(f, fils, [&](size_t fil, size_t fila) {
+        uint64_t clau = clauGrup(paisos[fila], generes[fila], conjunts[fila]) & mascara;
+        parcials[fil].grup(clau).afegeix(playcounts[fila]);
+    });
+
+    GrupsParcials total;
+    for (const GrupsParcials& p : parcials) {
+        for (size_t i = 0; i < p.claus.size(); i++) total.grup(p.claus[i]).fusiona(p.agregats[i]);
+    }
+    vector<pair<uint64_t, AgregatPlaycount>> resultat;
+    resultat.reserve(total.claus.size());
+    for (size_t i = 0; i < total.claus.size(); i++) resultat.emplace_back(total.claus[i], total.agregats[i]);
+    sort(resultat.begin(), resultat.end(),
+        [](const pair<uint64_t, AgregatPlaycount>& a, const pair<uint64_t, AgregatPlaycount>& b) { return a.first < b.first; });
+    return resultat;
+}
+
+#endif /* TAULAARTISTES_H */
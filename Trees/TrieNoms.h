@@ -0,0 +1,470 @@
+/**
+ * @author Albert Villanueva Kosoy Grup C
+ *
+ * ################################################
+ * Compressed radix trie of artist names (Trie de noms).
+ * Every edge of the trie keeps a piece of a name instead of a single character, so a node only
+ * exists where two names split. The names are normalized before inserting and searching:
+ * lowercase and without accents ("ROSALÍA" and "rosalia" are the same key).
+ * Every node keeps the best playcount of its subtree, so the k most played names that start
+ * with a prefix are found without visiting the whole subtree (best-first search).
+ * The approximate search (aproximada) walks the trie with the rows of the Levenshtein distance
+ * between the name searched and the path of every node, like a Levenshtein automaton: a row only
+ * keeps the 2d+1 cells of the band that can be <= d, and a subtree is skipped when no cell of the row
+ * is <= d (no name below can be closer). When there are already k results, a subtree is also skipped
+ * if it can't beat the worst of them (its row minimum and its best playcount).
+ * ################################################
+ *
+ * ################################################
+ * COMPLEXITY
+ *
+ * Time and Space Complexity:
+ * - insereix, cerca: O(m) where m is the length of the name (times the children of each node visited).
+ * - completa: O(p + k log k) nodes visited in the usual case, where p is the length of the prefix.
+ * - aproximada: O(d) per char of the nodes visited, which are the prefixes at distance <= d of some
+ *   prefix of the name (it does not depend on the number of names, only on how dense the trie is),
+ *   plus O(e log k) for the e artists of the names found.
+ * - canviaPlaycount: O(m) plus the children of the nodes of the path.
+ * - Nodes (24 bytes) and entries (12 bytes) are kept in arrays and the labels in one pool of chars,
+ *   so the trie uses about the size of the names plus 43 bytes per name (measured after compacta with
+ *   the files of Data: 55 bytes per name for names of 12 bytes on average).
+ * - compacta: O(nodes + names), it needs a second copy of the arrays while it runs.
+ *
+ * ################################################
+ * ATRIBUTES
+ *
+ * nodes : Array of nodes. Node 0 is the root. Each node has its label (inici, llarg in etiquetes),
+ *         its first child, its next sibling (children sorted by first char), its first entry and
+ *         the best playcount of its subtree.
+ * entrades : Array of (artistId, playcount, next entry) of the names that end in a node.
+ * etiquetes : Pool with the chars of all the labels.
+ *
+ * ################################################
+ */
+
+#ifndef TRIENOMS_H
+#define TRIENOMS_H
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <climits>
+#include <queue>
+#include <tuple>
+#include <algorithm>
+
+using namespace std;
+
+class TrieNoms {
+public:
+    TrieNoms();
+
+    void insereix(string_view nom, int artistId, int playcount);
+    vector<int> cerca(string_view nom) const;
+    vector<int> completa(string_view prefix, size_t k) const;
+    vector<int> aproximada(string_view nom, unsigned distancia, size_t k) const;
+    bool canviaPlaycount(string_view nom, int artistId, int playcount);
+    void compacta();
+
+    size_t mida() const;
+    size_t memoria() const;
+
+    static string normalitza(string_view text);
+
+private:
+    static const uint32_t CAP = UINT32_MAX;
+
+    struct Node {
+        uint32_t inici;
+        uint32_t llarg;
+        uint32_t fill;
+        uint32_t germa;
+        uint32_t entrada;
+        int millor;
+    };
+
+    struct Entrada {
+        int artistId;
+        int playcount;
+        uint32_t seguent;
+    };
+
+    vector<Node> nodes;
+    vector<Entrada> entrades;
+    vector<char> etiquetes;
+
+    uint32_t nouNode(uint32_t inici, uint32_t llarg, int millor);
+    uint32_t fillAmb(uint32_t node, char c) const;
+    void afegeixFill(uint32_t pare, uint32_t fill);
+    uint32_t baixa(const string& clau, bool exacte) const;
+
+    struct EstatAproximat {
+        string clau;
+        int distancia;
+        size_t k;
+        vector<int> files;                      // Fila de Levenshtein de cada profunditat, de clau.size() + 1 cel·les
+        vector<tuple<int, int, int>> millors;   // Heap de (distància, -playcount, id) amb el pitjor a dalt
+    };
+    void recorreAproximat(uint32_t node, size_t profunditat, EstatAproximat& e) const;
+};
+
+/**
+ * Constructor sense paràmetres. Crea l'arrel amb l'etiqueta buida
+*/
+TrieNoms::TrieNoms() {
+    nouNode(0, 0, INT_MIN);
+}
+
+/**
+ * Normalitza un nom en UTF-8: minúscules i lletres llatines sense accents
+ * @return string clau normalitzada
+*/
+string TrieNoms::normalitza(string_view text) {
+    // Lletres de U+00C0 a U+00FF sense accent (nullptr: es deixa igual)
+    static const char* const LATIN1[64] = {
+        "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+        "d", "n", "o", "o", "o", "o", "o", nullptr, "o", "u", "u", "u", "u", "y", "th", "ss",
+        "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+        "d", "n", "o", "o", "o", "o", "o", nullptr, "o", "u", "u", "u", "u", "y", "th", "y"
+    };
+    string resultat;
+    resultat.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c < 0x80) {
+            resultat += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : static_cast<char>(c);
+        } else if ((c == 0xC3) && i + 1 < text.size()) {
+            unsigned char d = static_cast<unsigned char>(text[i + 1]);
+            const char* base = (d >= 0x80 && d <= 0xBF) ? LATIN1[d - 0x80] : nullptr;
+            if (base != nullptr) {
+                resultat += base;
+                i++;
+            } else resultat += text[i];
+        } else resultat += text[i];
+    }
+    return resultat;
+}
+
+/**
+ * Crea un node nou sense fills ni entrades
+ * @return uint32_t posició del node
+*/
+uint32_t TrieNoms::nouNode(uint32_t inici, uint32_t llarg, int millor) {
+    nodes.push_back(Node{inici, llarg, CAP, CAP, CAP, millor});
+    return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+/**
+ * Busca el fill d'un node que comença pel caràcter c
+ * @return uint32_t posició del fill (CAP si no n'hi ha)
+*/
+uint32_t TrieNoms::fillAmb(uint32_t node, char c) const {
+    for (uint32_t f = nodes[node].fill; f != CAP; f = nodes[f].germa) {
+        char primer = etiquetes[nodes[f].inici];
+        if (primer == c) return f;
+        if (static_cast<unsigned char>(primer) > static_cast<unsigned char>(c)) break;
+    }
+    return CAP;
+}
+
+/**
+ * Afegeix un fill a un node mantenint els germans ordenats pel primer caràcter
+*/
+void TrieNoms::afegeixFill(uint32_t pare, uint32_t fill) {
+    unsigned char c = static_cast<unsigned char>(etiquetes[nodes[fill].inici]);
+    uint32_t anterior = CAP, actual = nodes[pare].fill;
+    while (actual != CAP && static_cast<unsigned char>(etiquetes[nodes[actual].inici]) < c) {
+        anterior = actual;
+        actual = nodes[actual].germa;
+    }
+    nodes[fill].germa = actual;
+    if (anterior == CAP) nodes[pare].fill = fill;
+    else nodes[anterior].germa = fill;
+}
+
+/**
+ * Insereix un nom amb el seu artista. Diversos artistes poden tenir el mateix nom
+*/
+void TrieNoms::insereix(string_view nom, int artistId, int playcount) {
+    string clau = normalitza(nom);
+    uint32_t node = 0;
+    size_t pos = 0;
+    while (true) {
+        nodes[node].millor = max(nodes[node].millor, playcount);
+        if (pos == clau.size()) break;
+
+        uint32_t fill = fillAmb(node, clau[pos]);
+        if (fill == CAP) {
+            uint32_t inici = static_cast<uint32_t>(etiquetes.size());
+            etiquetes.insert(etiquetes.end(), clau.begin() + pos, clau.end());
+            fill = nouNode(inici, static_cast<uint32_t>(clau.size() - pos), playcount);
+            afegeixFill(node, fill);
+            node = fill;
+            break;
+        }
+
+        // Llargada del tros comú entre l'etiqueta del fill i la resta del nom
+        uint32_t comu = 0;
+        const Node& f = nodes[fill];
+        while (comu < f.llarg && pos + comu < clau.size() && etiquetes[f.inici + comu] == clau[pos + comu]) comu++;
+
+        if (comu < nodes[fill].llarg) {
+            // Es parteix l'aresta: el fill es queda amb el tros comú i un node nou amb la resta
+            uint32_t resta = nouNode(nodes[fill].inici + comu, nodes[fill].llarg - comu, nodes[fill].millor);
+            nodes[resta].fill = nodes[fill].fill;
+            nodes[resta].entrada = nodes[fill].entrada;
+            nodes[fill].llarg = comu;
+            nodes[fill].fill = resta;
+            nodes[fill].entrada = CAP;
+        }
+        pos += comu;
+        node = fill;
+    }
+    entrades.push_back(Entrada{artistId, playcount, nodes[node].entrada});
+    nodes[node].entrada = static_cast<uint32_t>(entrades.size() - 1);
+}
+
+/**
+ * Baixa pel trie seguint una clau normalitzada. Si no és exacte, la clau pot acabar a mig d'una aresta
+ * @return uint32_t node on acaba la clau (CAP si no hi és)
+*/
+uint32_t TrieNoms::baixa(const string& clau, bool exacte) const {
+    uint32_t node = 0;
+    size_t pos = 0;
+    while (pos < clau.size()) {
+        uint32_t fill = fillAmb(node, clau[pos]);
+        if (fill == CAP) return CAP;
+        const Node& f = nodes[fill];
+        size_t i = 0;
+        while (i < f.llarg && pos + i < clau.size()) {
+            if (etiquetes[f.inici + i] != clau[pos + i]) return CAP;
+            i++;
+        }
+        if (i < f.llarg && exacte) return CAP;
+        pos += i;
+        node = fill;
+    }
+    return node;
+}
+
+/**
+ * Busca els artistes amb exactament aquest nom (un cop normalitzat)
+ * @return vector<int> ids ordenats
+*/
+vector<int> TrieNoms::cerca(string_view nom) const {
+    vector<int> ids;
+    uint32_t node = baixa(normalitza(nom), true);
+    if (node == CAP) return ids;
+    for (uint32_t e = nodes[node].entrada; e != CAP; e = entrades[e].seguent) ids.push_back(entrades[e].artistId);
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+/**
+ * Retorna els k artistes amb més playcount dels noms que comencen pel prefix.
+ * Recerca primer el millor: es treu de la cua el candidat amb més playcount, i un node té com
+ * a playcount el millor del seu subarbre, així que cap node pot tenir un artista millor que el que es treu.
+ * @return vector<int> ids de més a menys playcount (a igual playcount, per id)
+*/
+vector<int> TrieNoms::completa(string_view prefix, size_t k) const {
+    vector<int> ids;
+    uint32_t inici = baixa(normalitza(prefix), false);
+    if (inici == CAP || k == 0 || nodes[inici].millor == INT_MIN) return ids;
+
+    // (playcount, és node, -id o node): a igual playcount, els nodes surten abans que les entrades
+    // perquè totes les entrades empatades siguin a la cua i surtin per id
+    typedef tuple<int, bool, long long> Candidat;
+    priority_queue<Candidat> cua;
+    cua.emplace(nodes[inici].millor, true, inici);
+    while (!cua.empty() && ids.size() < k) {
+        Candidat c = cua.top();
+        cua.pop();
+        if (!get<1>(c)) {
+            ids.push_back(static_cast<int>(-get<2>(c)));
+            continue;
+        }
+        const Node& n = nodes[static_cast<uint32_t>(get<2>(c))];
+        for (uint32_t e = n.entrada; e != CAP; e = entrades[e].seguent)
+            cua.emplace(entrades[e].playcount, false, -static_cast<long long>(entrades[e].artistId));
+        for (uint32_t f = n.fill; f != CAP; f = nodes[f].germa)
+            cua.emplace(nodes[f].millor, true, f);
+    }
+    return ids;
+}
+
+/**
+ * Busca els k artistes dels noms a distància d'edició (Levenshtein, en bytes del nom normalitzat)
+ * com a molt distancia del nom
+ * @return vector<int> ids de menys a més distància, a igual distància de més a menys playcount i per id
+*/
+vector<int> TrieNoms::aproximada(string_view nom, unsigned distancia, size_t k) const {
+    vector<int> ids;
+    if (k == 0) return ids;
+    EstatAproximat e;
+    e.clau = normalitza(nom);
+    e.k = k;
+    size_t m = e.clau.size();
+    // Es busca amb distància 0, 1, ... i es para quan ja hi ha k resultats: amb una distància més
+    // petita es visiten molts menys nodes, i si ja hi ha k noms tan a prop no cal mirar més lluny
+    for (e.distancia = 0; e.distancia <= static_cast<int>(min<size_t>(distancia, 255)); e.distancia++) {
+        e.millors.clear();
+        e.files.resize(max(e.files.size(), m + 1));
+        for (size_t j = 0; j <= m; j++) e.files[j] = min(static_cast<int>(j), e.distancia + 1);
+        recorreAproximat(0, 0, e);
+        if (e.millors.size() == k) break;
+    }
+
+    sort_heap(e.millors.begin(), e.millors.end());
+    for (const tuple<int, int, int>& t : e.millors) ids.push_back(get<2>(t));
+    return ids;
+}
+
+/**
+ * Auxiliar de aproximada. La fila de la profunditat (caràcters des de l'arrel fins a l'inici de
+ * l'etiqueta del node) ja està calculada; es calculen les files dels caràcters de l'etiqueta, es
+ * recullen les entrades del node si el nom sencer és prou a prop i es baixa als fills
+*/
+void TrieNoms::recorreAproximat(uint32_t node, size_t profunditat, EstatAproximat& e) const {
+    const Node& n = nodes[node];
+    if (n.millor == INT_MIN) return;     // Subarbre sense cap nom
+    const int d = e.distancia, infinit = d + 1;
+    const size_t m = e.clau.size();
+    auto limit = [&e]() { return e.millors.size() < e.k ? e.distancia : get<0>(e.millors.front()); };
+
+    if (e.files.size() < (profunditat + n.llarg + 1) * (m + 1)) e.files.resize((profunditat + n.llarg + 1) * (m + 1) * 2);
+    for (uint32_t c = 0; c < n.llarg; c++) {
+        const int* anterior = &e.files[(profunditat + c) * (m + 1)];
+        int* fila = &e.files[(profunditat + c + 1) * (m + 1)];
+        char lletra = etiquetes[n.inici + c];
+        size_t i = profunditat + c + 1;
+        // Només les cel·les j amb |i - j| <= d poden valer <= d; les veïnes de la banda valen infinit
+        size_t baix = (i > static_cast<size_t>(d)) ? i - d : 1, alt = min(m, i + d);
+        fila[0] = static_cast<int>(min<size_t>(i, infinit));
+        int minim = fila[0];
+        if (baix > 1 && baix - 1 <= m) fila[baix - 1] = infinit;
+        for (size_t j = baix; j <= alt; j++) {
+            int cost = anterior[j - 1] + (e.clau[j - 1] != lletra);
+            cost = min(cost, min(anterior[j], fila[j - 1]) + 1);
+            fila[j] = min(cost, infinit);
+            minim = min(minim, fila[j]);
+        }
+        if (alt < m) fila[alt + 1] = infinit;
+        if (minim > limit()) return;
+    }
+
+    // Cap nom del subarbre pot quedar per davant del pitjor resultat: la distància no baixa del mínim de la fila
+    const int* fila = &e.files[(profunditat + n.llarg) * (m + 1)];
+    size_t i = profunditat + n.llarg;
+    if (e.millors.size() == e.k) {
+        int minim = INT_MAX;
+        for (size_t j = (i > static_cast<size_t>(d)) ? i - d : 0; j <= min(m, i + d); j++) minim = min(minim, fila[j]);
+        if (make_pair(minim, -n.millor) > make_pair(get<0>(e.millors.front()), get<1>(e.millors.front()))) return;
+    }
+
+    int final = (i + d >= m) ? fila[m] : infinit;
+    if (final <= limit()) {
+        for (uint32_t x = n.entrada; x != CAP; x = entrades[x].seguent) {
+            tuple<int, int, int> candidat(final, -entrades[x].playcount, entrades[x].artistId);
+            if (e.millors.size() < e.k) {
+                e.millors.push_back(candidat);
+                push_heap(e.millors.begin(), e.millors.end());
+            } else if (candidat < e.millors.front()) {
+                pop_heap(e.millors.begin(), e.millors.end());
+                e.millors.back() = candidat;
+                push_heap(e.millors.begin(), e.millors.end());
+            }
+        }
+    }
+    for (uint32_t f = n.fill; f != CAP; f = nodes[f].germa) recorreAproximat(f, i, e);
+}
+
+/**
+ * Canvia el playcount d'un artista i recalcula el millor playcount dels nodes del camí
+ * @return bool si l'artista és al trie amb aquest nom
+*/
+bool TrieNoms::canviaPlaycount(string_view nom, int artistId, int playcount) {
+    string clau = normalitza(nom);
+    vector<uint32_t> cami(1, 0);
+    size_t pos = 0;
+    while (pos < clau.size()) {
+        uint32_t fill = fillAmb(cami.back(), clau[pos]);
+        if (fill == CAP || nodes[fill].llarg > clau.size() - pos
+            || clau.compare(pos, nodes[fill].llarg, &etiquetes[nodes[fill].inici], nodes[fill].llarg) != 0) return false;
+        pos += nodes[fill].llarg;
+        cami.push_back(fill);
+    }
+
+    uint32_t e = nodes[cami.back()].entrada;
+    while (e != CAP && entrades[e].artistId != artistId) e = entrades[e].seguent;
+    if (e == CAP) return false;
+    entrades[e].playcount = playcount;
+
+    for (size_t i = cami.size(); i-- > 0;) {
+        Node& n = nodes[cami[i]];
+        int millor = INT_MIN;
+        for (uint32_t x = n.entrada; x != CAP; x = entrades[x].seguent) millor = max(millor, entrades[x].playcount);
+        for (uint32_t f = n.fill; f != CAP; f = nodes[f].germa) millor = max(millor, nodes[f].millor);
+        n.millor = millor;
+    }
+    return true;
+}
+
+/**
+ * Després d'una càrrega gran, torna a numerar els nodes en ordre d'amplada (els fills d'un node queden
+ * seguits, i les seves etiquetes i entrades també) i allibera la memòria reservada i no usada. Així recórrer els
+ * germans, que és el que més fan completa i aproximada, llegeix memòria seguida en lloc d'un node
+ * de cada càrrega
+*/
+void TrieNoms::compacta() {
+    vector<Node> ordenats;
+    vector<char> novesEtiquetes;
+    ordenats.reserve(nodes.size());
+    novesEtiquetes.reserve(etiquetes.size());
+    ordenats.push_back(nodes[0]);
+    // ordenats[i] encara té els fills amb la numeració antiga fins que es processa
+    for (size_t i = 0; i < ordenats.size(); i++) {
+        Node& n = ordenats[i];
+        uint32_t inici = static_cast<uint32_t>(novesEtiquetes.size());
+        novesEtiquetes.insert(novesEtiquetes.end(), etiquetes.begin() + n.inici, etiquetes.begin() + n.inici + n.llarg);
+        n.inici = inici;
+        uint32_t fill = n.fill;
+        n.fill = (fill == CAP) ? CAP : static_cast<uint32_t>(ordenats.size());
+        for (; fill != CAP; fill = nodes[fill].germa) {
+            ordenats.push_back(nodes[fill]);
+            ordenats.back().germa = (nodes[fill].germa == CAP) ? CAP : static_cast<uint32_t>(ordenats.size());
+        }
+    }
+    nodes.swap(ordenats);
+    etiquetes.swap(novesEtiquetes);
+
+    // Les entrades de cada node també queden seguides, en l'ordre dels nodes
+    vector<Entrada> novesEntrades;
+    novesEntrades.reserve(entrades.size());
+    for (Node& n : nodes) {
+        uint32_t e = n.entrada;
+        n.entrada = (e == CAP) ? CAP : static_cast<uint32_t>(novesEntrades.size());
+        for (; e != CAP; e = entrades[e].seguent) {
+            novesEntrades.push_back(entrades[e]);
+            novesEntrades.back().seguent = (entrades[e].seguent == CAP) ? CAP : static_cast<uint32_t>(novesEntrades.size());
+        }
+    }
+    entrades.swap(novesEntrades);
+}
+
+/**
+ * Nombre de noms inserits
+ * @return size_t nombre d'entrades
+*/
+size_t TrieNoms::mida() const {
+    return entrades.size();
+}
+
+/**
+ * Memòria usada pels vectors del trie
+ * @return size_t bytes
+*/
+size_t TrieNoms::memoria() const {
+    return nodes.capacity() * sizeof(Node) + entrades.capacity() * sizeof(Entrada) + etiquetes.capacity();
+}
+
+#endif /* TRIENOMS_H */
@@ -47,8 +47,21 @@ Differences between the two trees are in the file ArbreAVL.h
 #include "CercadorArtistes.h"
 #include "ABT.h"
 #include "CercadorArtistesAVL.h"
+#include "ConsultesLot.h"
+#include "ServidorConsultes.h"
+#include "ClientCarrega.h"
+#include "GeneradorArtistes.h"
+#include "BancProves.h"
+#include "CercadorArtistesParticionat.h"
+#include "ReplicaIds.h"
+#include <csignal>
+#include <random>
+#include <array>
+#include <thread>
 #include <chrono>
 #include <list>
+#include <set>
+#include <tuple>
 using namespace std;
 
 
@@ -554,7 +567,1094 @@ void mainExercici4(){
     } while (option!= 9);
 }
 
-int main(){
+/**
+ * Mode per lots, sense menús: carrega els artistes amb el cercador AVL i respon un fitxer de consultes.
+ * Ús: main --lot <consultes.csv|-> <fils> <artistes.csv> [artistes.csv ...]
+ * Les respostes surten per la sortida estàndard i les estadístiques per la sortida d'error
+*/
+int mainLot(int argc, char* argv[]){
+    if (argc < 5) {
+        cerr << "Us: " << argv[0] << " --lot <consultes.csv|-> <fils> <artistes.csv> [artistes.csv ...]" << endl;
+        return 1;
+    }
+    unsigned fils;
+    list<string> fitxers;
+    try {
+        fils = static_cast<unsigned>(LectorCSV::llegeixEnter(argv[3]));
+    } catch (const exception& e) {
+        cerr << "Error: nombre de fils incorrecte" << endl;
+        return 1;
+    }
+    for (int i = 4; i < argc; i++) fitxers.push_back(argv[i]);
+
+    CercadorArtistesAVL cercador;
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    try {
+        cercador.afegeixArtistesParallel(fitxers, fils);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    chrono::steady_clock::time_point end = chrono::steady_clock::now();
+    cerr << "Artistes carregats en " << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << " ms." << endl;
+
+    ConsultesLot<CercadorArtistesAVL> lot(cercador, fils);
+    EstadistiquesLot e = lot.executaFitxer(argv[2], cout);
+    cerr << "Consultes: " << e.consultes << " (trobades " << e.trobades << ", errors " << e.errors << ")" << endl;
+    cerr << "Temps: " << e.segons << " s, " << e.consultesPerSegon << " consultes/s" << endl;
+    cerr << "Latencia p50: " << e.p50 << " us, p99: " << e.p99 << " us" << endl;
+    return 0;
+}
+
+/**
+ * Benchmark del planificador: cada filtre combinat s'executa sense índexs (recorrent l'arbre)
+ * i amb el pla del planificador, i es comprova que els resultats són iguals.
+ * Ús: main --planificador <repeticions> <artistes.csv> [artistes.csv ...]
+*/
+int mainPlanificador(int argc, char* argv[]){
+    if (argc < 4) {
+        cerr << "Us: " << argv[0] << " --planificador <repeticions> <artistes.csv> [artistes.csv ...]" << endl;
+        return 1;
+    }
+    int repeticions;
+    list<string> fitxers;
+    CercadorArtistesAVL cercador;
+    try {
+        repeticions = max(1, LectorCSV::llegeixEnter(argv[2]));
+        for (int i = 3; i < argc; i++) fitxers.push_back(argv[i]);
+        cercador.afegeixArtistesParallel(fitxers);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+
+    vector<pair<string, FiltreArtistes>> filtres(7);
+    filtres[0].first = "pais = Spain AND estil = folk AND playcount >= 100000";
+    filtres[0].second.pais = "Spain";
+    filtres[0].second.estils = {"folk"};
+    filtres[0].second.minPlaycount = 100000;
+    filtres[1].first = "estil = rock AND estil = pop";
+    filtres[1].second.estils = {"rock", "pop"};
+    filtres[2].first = "playcount >= 10000000";
+    filtres[2].second.minPlaycount = 10000000;
+    filtres[3].first = "genere = female AND playcount <= 500000";
+    filtres[3].second.genere = "female";
+    filtres[3].second.maxPlaycount = 500000;
+    filtres[4].first = "estil = jazz AND genere = male";
+    filtres[4].second.estils = {"jazz"};
+    filtres[4].second.genere = "male";
+    filtres[5].first = "pais = Narnia";
+    filtres[5].second.pais = "Narnia";
+    filtres[6].first = "pais = United States AND playcount >= 1000000";
+    filtres[6].second.pais = "United States";
+    filtres[6].second.minPlaycount = 1000000;
+
+    bool iguals = true;
+    for (const pair<string, FiltreArtistes>& f : filtres) {
+        list<int> senseIndex, planificat;
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        for (int r = 0; r < repeticions; r++) senseIndex = cercador.obtenirArtistesSenseIndex(f.second);
+        chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+        for (int r = 0; r < repeticions; r++) planificat = cercador.obtenirArtistes(f.second);
+        chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+
+        iguals = iguals && planificat == senseIndex;
+        cout << f.first << endl;
+        cout << "  pla: " << cercador.explicaConsulta(f.second) << endl;
+        cout << "  resultats: " << planificat.size() << (planificat == senseIndex ? "" : "  DIFERENTS!") << endl;
+        cout << "  sense index: " << chrono::duration<double, micro>(t1 - t0).count() / repeticions << " us"
+             << ", planificat: " << chrono::duration<double, micro>(t2 - t1).count() / repeticions << " us" << endl;
+    }
+    return iguals ? 0 : 1;
+}
+
+/**
+ * Informe agrupat: agrupa tots els artistes pels camps indicats (pais, genere i/o estil separats per comes)
+ * amb 1 fil i amb els fils demanats, comprova que coincideixen i escriu els grups en CSV.
+ * Ús: main --agrupa <pais,genere,estil> <fils> <artistes.csv> [artistes.csv ...]
+*/
+int mainAgrupa(int argc, char* argv[]){
+    if (argc < 5) {
+        cerr << "Us: " << argv[0] << " --agrupa <pais,genere,estil> <fils> <artistes.csv> [artistes.csv ...]" << endl;
+        return 1;
+    }
+    unsigned camps = 0, fils;
+    list<string> fitxers;
+    CercadorArtistesAVL cercador;
+    try {
+        stringstream text(argv[2]);
+        string camp;
+        while (getline(text, camp, ',')) {
+            if (camp == "pais") camps |= AGRUPA_PAIS;
+            else if (camp == "genere") camps |= AGRUPA_GENERE;
+            else if (camp == "estil") camps |= AGRUPA_ESTIL;
+            else throw invalid_argument("Camp d'agrupacio desconegut: " + camp);
+        }
+        fils = static_cast<unsigned>(LectorCSV::llegeixEnter(argv[3]));
+        for (int i = 4; i < argc; i++) fitxers.push_back(argv[i]);
+        cercador.afegeixArtistesParallel(fitxers);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    list<GrupArtistes> unFil = cercador.agrupaArtistes(camps, FiltreArtistes(), 1);
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+    list<GrupArtistes> grups = cercador.agrupaArtistes(camps, FiltreArtistes(), fils);
+    chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+
+    bool iguals = unFil.size() == grups.size();
+    for (list<GrupArtistes>::const_iterator a = unFil.begin(), b = grups.begin(); iguals && a != unFil.end(); ++a, ++b) {
+        iguals = a->pais == b->pais && a->genere == b->genere && a->estil == b->estil
+            && a->agregat.recompte == b->agregat.recompte && a->agregat.suma == b->agregat.suma
+            && a->agregat.minim == b->agregat.minim && a->agregat.maxim == b->agregat.maxim;
+    }
+    // Cada clau ha de sortir en un sol grup (un país amb espais, per exemple, en faria dos)
+    set<tuple<string, string, string>> claus;
+    bool unics = true;
+    for (const GrupArtistes& g : grups) unics = claus.insert(make_tuple(g.pais, g.genere, g.estil)).second && unics;
+
+    cout << "pais;genere;estil;recompte;suma;minim;maxim;mitjana" << "\n";
+    for (const GrupArtistes& g : grups) {
+        cout << g.pais << ';' << g.genere << ';' << g.estil << ';' << g.agregat.recompte << ';' << g.agregat.suma
+             << ';' << g.agregat.minim << ';' << g.agregat.maxim << ';' << g.agregat.mitjana() << "\n";
+    }
+    cerr << grups.size() << " grups" << (iguals ? "" : "  DIFERENTS!") << (unics ? "" : "  CLAUS REPETIDES!")
+         << ", 1 fil: " << chrono::duration<double, milli>(t1 - t0).count() << " ms"
+         << ", " << PoolFils::filsPerDefecte(fils) << " fils: " << chrono::duration<double, milli>(t2 - t1).count() << " ms" << endl;
+    return iguals && unics ? 0 : 1;
+}
+
+/**
+ * Benchmark d'ingesta: genera events de reproducció sobre els artistes carregats (la meitat dels events
+ * van a l'1% d'artistes més escoltats) i els aplica amb un sol fil i amb diversos productors concurrents.
+ * Comprova que el playcount total i l'índex de playcount queden coherents amb la taula.
+ * Ús: main --ingesta <events> <productors> <artistes.csv> [artistes.csv ...]
+*/
+int mainIngesta(int argc, char* argv[]){
+    if (argc < 5) {
+        cerr << "Us: " << argv[0] << " --ingesta <events> <productors> <artistes.csv> [artistes.csv ...]" << endl;
+        return 1;
+    }
+    size_t nEvents;
+    unsigned productors;
+    list<string> fitxers;
+    CercadorArtistesAVL cercador;
+    try {
+        nEvents = static_cast<size_t>(max(0, LectorCSV::llegeixEnter(argv[2])));
+        productors = max(1, LectorCSV::llegeixEnter(argv[3]));
+        for (int i = 4; i < argc; i++) fitxers.push_back(argv[i]);
+        cercador.afegeixArtistesParallel(fitxers);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    list<int> llista = cercador.obtenirArtistes(FiltreArtistes());
+    vector<int> ids(llista.begin(), llista.end());
+    if (ids.empty()) {
+        cerr << "No hi ha artistes" << endl;
+        return 1;
+    }
+
+    vector<EventReproduccio> events(nEvents);
+    mt19937 aleatori(42);
+    size_t calents = max<size_t>(1, ids.size() / 100);
+    long long totalDeltes = 0;
+    for (EventReproduccio& e : events) {
+        size_t i = (aleatori() % 2) ? aleatori() % calents : aleatori() % ids.size();
+        e.artistId = ids[i];
+        e.delta = 1 + static_cast<int>(aleatori() % 3);
+        totalDeltes += e.delta;
+    }
+    long long abans = cercador.sumaPlaycount(FiltreArtistes());
+
+    // Un sol fil: lots de 64K events directament al cercador
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    EstadistiquesIngesta sequencial;
+    for (size_t inici = 0; inici < events.size(); inici += 65536) {
+        vector<EventReproduccio> lot(events.begin() + inici, events.begin() + min(events.size(), inici + 65536));
+        sequencial.suma(cercador.aplicaReproduccions(lot));
+    }
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+
+    // Diversos productors: cada un envia un tros dels events en paquets de 1024
+    EstadistiquesIngesta concurrent;
+    {
+        IngestaEvents<CercadorArtistesAVL> ingesta(cercador, 4 * productors);
+        vector<thread> fils;
+        for (unsigned p = 0; p < productors; p++) {
+            fils.emplace_back([&, p]() {
+                size_t inici = events.size() * p / productors, fi = events.size() * (p + 1) / productors;
+                for (size_t i = inici; i < fi; i += 1024) ingesta.envia(events.data() + i, min<size_t>(1024, fi - i));
+            });
+        }
+        for (thread& f : fils) f.join();
+        ingesta.buida();
+        concurrent = ingesta.estadistiques();
+    }
+    chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+
+    long long despres = cercador.sumaPlaycount(FiltreArtistes());
+    int llindar = 1000000;
+    FiltreArtistes perSobre;
+    perSobre.minPlaycount = llindar;
+    bool coherent = despres - abans == 2 * totalDeltes
+        && cercador.buscarRecompteArtistes(llindar) == cercador.comptaArtistes(perSobre);
+
+    double s1 = chrono::duration<double>(t1 - t0).count(), s2 = chrono::duration<double>(t2 - t1).count();
+    cout << "Un fil: " << sequencial.events << " events, " << sequencial.actualitzats << " actualitzacions, "
+         << (s1 > 0 ? sequencial.events / s1 : 0) << " events/s" << endl;
+    cout << productors << " productors: " << concurrent.events << " events, " << concurrent.lots << " lots, "
+         << concurrent.actualitzats << " actualitzacions, " << (s2 > 0 ? concurrent.events / s2 : 0) << " events/s" << endl;
+    cout << (coherent ? "Indexs coherents" : "INDEXS INCOHERENTS!") << endl;
+    return coherent ? 0 : 1;
+}
+
+/**
+ * Benchmark del registre d'escriptura anticipada: insereix els artistes amb insereixArtista sense registre
+ * i amb registre (group commit), canvia playcounts, i recupera el cercador des del registre abans i
+ * després de compactar-lo, comprovant que queda igual. Esborra cami i cami.snap abans de començar.
+ * Ús: main --registre <cami> <artistes.csv> [artistes.csv ...]
+*/
+int mainRegistre(int argc, char* argv[]){
+    if (argc < 4) {
+        cerr << "Us: " << argv[0] << " --registre <cami> <artistes.csv> [artistes.csv ...]" << endl;
+        return 1;
+    }
+    string cami = argv[2];
+    vector<Artist> artistes;
+    for (int i = 3; i < argc; i++) {
+        LectorCSV lector(argv[i]);
+        if (!lector.obert()) {
+            cerr << "Error: Unable to open file " << argv[i] << endl;
+            return 1;
+        }
+        lector.perCadaFila([&artistes](const FilaArtista& fila) { artistes.push_back(artistaDeFila(fila)); });
+    }
+    remove(cami.c_str());
+    remove((cami + ".snap").c_str());
+
+    try {
+        CercadorArtistesAVL memoria, durable;
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        for (const Artist& a : artistes)
+            memoria.insereixArtista(a.getArtistId(), a.getName(), a.getGender(), a.getCountry(), a.getStyles(), a.getPlaycount());
+        chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+        durable.activaRegistre(cami);
+        for (const Artist& a : artistes)
+            durable.insereixArtista(a.getArtistId(), a.getName(), a.getGender(), a.getCountry(), a.getStyles(), a.getPlaycount());
+        durable.sincronitzaRegistre();
+        chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+        for (size_t i = 0; i < artistes.size(); i += 2) durable.actualitzaPlaycount(artistes[i].getArtistId(), static_cast<int>(i));
+        durable.sincronitzaRegistre();
+
+        double sMemoria = chrono::duration<double>(t1 - t0).count(), sDurable = chrono::duration<double>(t2 - t1).count();
+        EstadistiquesRegistre e = durable.estadistiquesRegistre();
+        cout << "En memoria: " << sMemoria * 1000 << " ms, amb registre: " << sDurable * 1000 << " ms ("
+             << (sMemoria > 0 ? sDurable / sMemoria : 0) << "x)" << endl;
+        cout << "Registre: " << e.registres << " registres, " << e.bytes << " bytes, " << e.sincronitzacions << " fdatasync" << endl;
+
+        bool iguals = true;
+        for (int fase = 0; fase < 2; fase++) {
+            if (fase == 1) durable.compactaRegistre();
+            CercadorArtistesAVL recuperat;
+            chrono::steady_clock::time_point r0 = chrono::steady_clock::now();
+            size_t reproduits = recuperat.activaRegistre(cami);
+            chrono::steady_clock::time_point r1 = chrono::steady_clock::now();
+            bool igual = recuperat.comptaArtistes(FiltreArtistes()) == durable.comptaArtistes(FiltreArtistes())
+                && recuperat.sumaPlaycount(FiltreArtistes()) == durable.sumaPlaycount(FiltreArtistes());
+            iguals = iguals && igual;
+            cout << (fase == 0 ? "Recuperacio: " : "Recuperacio despres de compactar: ") << reproduits << " registres en "
+                 << chrono::duration<double, milli>(r1 - r0).count() << " ms" << (igual ? "" : "  DIFERENT!") << endl;
+        }
+        return iguals ? 0 : 1;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+}
+
+/**
+ * Benchmark del magatzem en disc: escriu els artistes carregats en un magatzem amb blocs de midaBloc bytes,
+ * el torna a obrir i compara cerques puntuals i per rang d'identificadors amb l'arbre, sense cache i amb cache.
+ * Ús: main --magatzem <cami> <midaBloc> <artistes.csv> [artistes.csv ...]
+*/
+int mainMagatzem(int argc, char* argv[]){
+    if (argc < 5) {
+        cerr << "Us: " << argv[0] << " --magatzem <cami> <midaBloc> <artistes.csv> [artistes.csv ...]" << endl;
+        return 1;
+    }
+    string cami = argv[2];
+    list<string> fitxers;
+    CercadorArtistesAVL cercador;
+    try {
+        size_t midaBloc = static_cast<size_t>(max(0, LectorCSV::llegeixEnter(argv[3])));
+        for (int i = 4; i < argc; i++) fitxers.push_back(argv[i]);
+        cercador.afegeixArtistesParallel(fitxers);
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        cercador.escriuMagatzem(cami, midaBloc);
+        cout << "Escrit en " << chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() << " ms" << endl;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    list<int> llista = cercador.obtenirArtistes(FiltreArtistes());
+    vector<int> ids(llista.begin(), llista.end());
+    if (ids.empty()) return 1;
+
+    bool iguals = true;
+    for (size_t blocsCache : {size_t(0), size_t(256)}) {
+        MagatzemArtistes magatzem(cami, blocsCache);
+        mt19937 aleatori(7);
+        size_t cerques = 100000, trobats = 0;
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        for (size_t i = 0; i < cerques; i++) {
+            // La meitat de cerques són d'ids que no existeixen
+            int id = (i % 2) ? ids[aleatori() % ids.size()] : static_cast<int>(aleatori() % (2 * static_cast<unsigned>(ids.back()) + 1));
+            bool hiEs = magatzem.buscarArtista(id);
+            trobats += hiEs;
+            iguals = iguals && hiEs == cercador.buscarArtista(id);
+        }
+        chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+        for (int r = 0; r < 100; r++) {
+            int a = ids[aleatori() % ids.size()], b = ids[aleatori() % ids.size()];
+            if (a > b) swap(a, b);
+            iguals = iguals && magatzem.obtenirArtistes(a, b) == cercador.obtenirArtistesPerId(a, b)
+                && magatzem.compta(a, b) == static_cast<size_t>(cercador.obtenirArtistesPerId(a, b).size());
+        }
+        EstadistiquesMagatzem e = magatzem.estadistiques();
+        cout << "Cache de " << blocsCache << " blocs: " << e.artistes << " artistes en " << e.blocs << " blocs, "
+             << trobats << " trobats de " << cerques << " cerques, "
+             << chrono::duration<double, micro>(t1 - t0).count() / cerques << " us per cerca, "
+             << e.lectures << " blocs llegits (" << e.bytesLlegits << " bytes)" << endl;
+    }
+    cout << (iguals ? "Resultats iguals que l'arbre" : "RESULTATS DIFERENTS!") << endl;
+    return iguals ? 0 : 1;
+}
+
+/**
+ * Benchmark del filtre de Bloom: cerques d'ids amb un percentatge d'ids que no existeixen,
+ * sense filtre i amb el filtre activat, i la taxa de falsos positius observada.
+ * Ús: main --bloom <falsPositius> <artistes.csv> [artistes.csv ...]
+*/
+int mainBloom(int argc, char* argv[]){
+    if (argc < 4) {
+        cerr << "Us: " << argv[0] << " --bloom <falsPositius> <artistes.csv> [artistes.csv ...]" << endl;
+        return 1;
+    }
+    list<string> fitxers;
+    for (int i = 3; i < argc; i++) fitxers.push_back(argv[i]);
+    CercadorArtistesAVL cercador;
+    double falsPositius;
+    try {
+        falsPositius = stod(argv[2]);
+        cercador.afegeixArtistesParallel(fitxers);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    list<int> llista = cercador.obtenirArtistes(FiltreArtistes());
+    vector<int> ids(llista.begin(), llista.end());
+    if (ids.empty()) return 1;
+
+    // 1 de cada 10 cerques és d'un artista que existeix, i la resta són ids qualsevol entre el primer i l'últim
+    mt19937 aleatori(11);
+    vector<int> cerques(1000000);
+    for (size_t i = 0; i < cerques.size(); i++) {
+        cerques[i] = (i % 10 == 0) ? ids[aleatori() % ids.size()]
+            : ids.front() + static_cast<int>(aleatori() % (static_cast<unsigned>(ids.back() - ids.front()) + 1));
+    }
+    vector<bool> sense(cerques.size());
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < cerques.size(); i++) sense[i] = cercador.buscarArtista(cerques[i]);
+    double msSense = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+    try {
+        t0 = chrono::steady_clock::now();
+        cercador.activaFiltreBloom(falsPositius);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    double msConstruccio = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    bool iguals = true;
+    t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < cerques.size(); i++) iguals = iguals && cercador.buscarArtista(cerques[i]) == sense[i];
+    double msAmb = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+    // Un artista inserit després d'activar el filtre s'hi ha d'afegir
+    int nou = ids.back() + 1;
+    cercador.insereixArtista(nou, "Bloom", "male", "Andorra", "rock", 1);
+    iguals = iguals && cercador.buscarArtista(nou);
+
+    EstadistiquesBloom e = cercador.estadistiquesBloom();
+    cout << "Filtre de " << e.bytes << " bytes per " << e.claus << " artistes (capacitat " << e.capacitat
+         << ", k = " << e.funcions << "), construit en " << msConstruccio << " ms" << endl;
+    cout << "Sense filtre: " << msSense * 1e6 / cerques.size() << " ns per cerca" << endl;
+    cout << "Amb filtre: " << msAmb * 1e6 / cerques.size() << " ns per cerca, " << e.descartades << " de "
+         << e.consultes << " descartades pel filtre, " << e.falsosPositius << " falsos positius (taxa "
+         << e.taxaFalsosPositius() << ", objectiu " << e.objectiu << ", esperada " << e.estimada << ")" << endl;
+    cout << (iguals ? "Resultats iguals sense filtre" : "RESULTATS DIFERENTS!") << endl;
+    return iguals ? 0 : 1;
+}
+
+/**
+ * Genera un catàleg sintètic d'artistes en format CSV.
+ * Ús: main --genera <fitxer.csv> <files> [ordenat|aleatori|agrupat] [zipf] [llavor]
+*/
+int mainGenera(int argc, char* argv[]){
+    if (argc < 4) {
+        cerr << "Us: " << argv[0] << " --genera <fitxer.csv> <files> [ordenat|aleatori|agrupat] [zipf] [llavor]" << endl;
+        return 1;
+    }
+    ConfiguracioGenerador c;
+    try {
+        c.files = stoull(argv[3]);
+        if (argc > 4) c.ordre = ConfiguracioGenerador::ordreDeText(argv[4]);
+        if (argc > 5) c.zipf = stod(argv[5]);
+        if (argc > 6) c.llavor = stoull(argv[6]);
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        generaArtistes(string(argv[2]), c);
+        cout << c.files << " artistes escrits en "
+             << chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() << " ms" << endl;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Banc de proves d'escalat: càrrega, cerques, estils i playcount de cada cercador de 1K a maxFiles files.
+ * Ús: main --escalat <directori> [maxFiles] [ordenat|aleatori|agrupat] [limitSegons]
+*/
+int mainEscalat(int argc, char* argv[]){
+    if (argc < 3) {
+        cerr << "Us: " << argv[0] << " --escalat <directori> [maxFiles] [ordenat|aleatori|agrupat] [limitSegons]" << endl;
+        return 1;
+    }
+    ConfiguracioBancProves c;
+    try {
+        c.directori = argv[2];
+        if (argc > 3) c.maxFiles = stoull(argv[3]);
+        if (argc > 4) c.ordre = ConfiguracioGenerador::ordreDeText(argv[4]);
+        if (argc > 5) c.limitSegons = stod(argv[5]);
+        bancProvesEscalat(c, cout);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Compara el cercador particionat amb un sol cercador AVL: temps de càrrega, de cerques i de consultes
+ * amb fan-out, i comprova que tots els resultats són iguals.
+ * Ús: main --particions <particions> <rang|hash> <artistes.csv> [artistes.csv ...]
+*/
+int mainParticions(int argc, char* argv[]){
+    if (argc < 5 || (string(argv[3]) != "rang" && string(argv[3]) != "hash")) {
+        cerr << "Us: " << argv[0] << " --particions <particions> <rang|hash> <artistes.csv> [artistes.csv ...]" << endl;
+        return 1;
+    }
+    typedef CercadorArtistesParticionat<CercadorArtistesAVL> Particionat;
+    list<string> fitxers;
+    for (int i = 4; i < argc; i++) fitxers.push_back(argv[i]);
+    unique_ptr<Particionat> particionat;
+    CercadorArtistesAVL sol;
+    double msParticionat, msSol;
+    try {
+        particionat = make_unique<Particionat>(static_cast<unsigned>(stoul(argv[2])),
+            string(argv[3]) == "hash" ? Particionat::PER_HASH : Particionat::PER_RANG);
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        particionat->afegeixArtistes(fitxers);
+        msParticionat = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        t0 = chrono::steady_clock::now();
+        sol.afegeixArtistesParallel(fitxers);
+        msSol = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    particionat->configuraCache(0);
+    sol.configuraCache(0);
+    list<int> llista = sol.obtenirArtistes(FiltreArtistes());
+    vector<int> ids(llista.begin(), llista.end());
+    if (ids.empty()) return 1;
+
+    cout << particionat->particions() << " particions:";
+    for (size_t m : particionat->midaParticions()) cout << " " << m;
+    cout << endl << "Carrega: " << msParticionat << " ms particionat, " << msSol << " ms un sol cercador" << endl;
+
+    // Cada consulta es fa als dos cercadors, es cronometra i es comparen els resultats
+    bool iguals = true;
+    double msP = 0, msS = 0;
+    auto compara = [&](const char* nom, auto consultaParticionat, auto consultaSol) {
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        auto a = consultaParticionat();
+        double p = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        t0 = chrono::steady_clock::now();
+        auto b = consultaSol();
+        double s = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        msP += p;
+        msS += s;
+        if (!(a == b)) {
+            cout << nom << ": RESULTATS DIFERENTS!" << endl;
+            iguals = false;
+        }
+    };
+
+    mt19937 aleatori(13);
+    vector<int> cerques(1000000);
+    for (size_t i = 0; i < cerques.size(); i++) {
+        cerques[i] = (i % 2 == 0) ? ids[aleatori() % ids.size()]
+            : ids.front() + static_cast<int>(aleatori() % (static_cast<unsigned>(ids.back() - ids.front()) + 1));
+    }
+    compara("buscarArtista", [&] {
+        size_t trobats = 0;
+        for (int id : cerques) trobats += particionat->buscarArtista(id);
+        return trobats;
+    }, [&] {
+        size_t trobats = 0;
+        for (int id : cerques) trobats += sol.buscarArtista(id);
+        return trobats;
+    });
+    cout << "Cerques: " << msP * 1e6 / cerques.size() << " ns particionat, " << msS * 1e6 / cerques.size() << " ns un sol cercador" << endl;
+
+    msP = msS = 0;
+    static const char* const ESTILS[] = {"rock", "rap", "pop", "jazz", "shoegaze", "mathcore", "polka"};
+    for (const char* estil : ESTILS) {
+        compara("obtenirArtistesPerEstil", [&] { return particionat->obtenirArtistesPerEstil(estil); },
+            [&] { return sol.obtenirArtistesPerEstil(estil); });
+    }
+    for (int i = 0; i < 20; i++) {
+        int minim = static_cast<int>(aleatori() % 400000), maxim = minim * 3 + 10;
+        compara("buscarRecompteArtistes", [&] { return particionat->buscarRecompteArtistes(minim, maxim); },
+            [&] { return sol.buscarRecompteArtistes(minim, maxim); });
+        compara("obtenirArtistesPerPlaycount", [&] { return particionat->obtenirArtistesPerPlaycount(minim, maxim); },
+            [&] { return sol.obtenirArtistesPerPlaycount(minim, maxim); });
+        int id = ids[aleatori() % ids.size()];
+        compara("obtenirArtistesPerId", [&] { return particionat->obtenirArtistesPerId(id, id + 5000); },
+            [&] { return sol.obtenirArtistesPerId(id, id + 5000); });
+    }
+    FiltreArtistes filtre;
+    filtre.pais = "Spain";
+    filtre.estils.push_back("rock");
+    compara("obtenirArtistes", [&] { return particionat->obtenirArtistes(filtre); }, [&] { return sol.obtenirArtistes(filtre); });
+    compara("comptaArtistes", [&] { return particionat->comptaArtistes(filtre); }, [&] { return sol.comptaArtistes(filtre); });
+    compara("sumaPlaycount", [&] { return particionat->sumaPlaycount(filtre); }, [&] { return sol.sumaPlaycount(filtre); });
+    compara("topArtistes", [&] { return particionat->topArtistes(100); }, [&] { return sol.topArtistes(100); });
+    compara("topArtistes amb filtre", [&] { return particionat->topArtistes(100, filtre); }, [&] { return sol.topArtistes(100, filtre); });
+    cout << "Consultes amb fan-out: " << msP << " ms particionat, " << msS << " ms un sol cercador" << endl;
+
+    // Reproduccions repartides per particions, i l'ordre per playcount ha de seguir igual
+    vector<EventReproduccio> events, copia;
+    for (int i = 0; i < 100000; i++) events.push_back(EventReproduccio{ids[aleatori() % ids.size()], static_cast<int>(aleatori() % 1000)});
+    copia = events;
+    EstadistiquesIngesta eP = particionat->aplicaReproduccions(events), eS = sol.aplicaReproduccions(copia);
+    iguals = iguals && eP.actualitzats == eS.actualitzats && eP.desconeguts == eS.desconeguts;
+    compara("topArtistes despres de reproduccions", [&] { return particionat->topArtistes(1000); }, [&] { return sol.topArtistes(1000); });
+    string linia, liniaSol;
+    particionat->mostrarArtista(ids[ids.size() / 2], linia);
+    sol.mostrarArtista(ids[ids.size() / 2], liniaSol);
+    iguals = iguals && linia == liniaSol;
+
+    cout << (iguals ? "Resultats iguals amb un sol cercador" : "RESULTATS DIFERENTS!") << endl;
+    return iguals ? 0 : 1;
+}
+
+/**
+ * Benchmark de la cerca aproximada de noms: un trie de noms sintètics (síl·labes a l'atzar, així hi ha
+ * molts noms diferents i que s'assemblen) i cerques de noms del trie amb distancia errors afegits.
+ * Amb pocs noms també comprova els resultats amb la distància calculada per tots els noms.
+ * Ús: main --aproximat <noms> <distancia> [k]
+*/
+int mainAproximat(int argc, char* argv[]){
+    if (argc < 4) {
+        cerr << "Us: " << argv[0] << " --aproximat <noms> <distancia> [k]" << endl;
+        return 1;
+    }
+    size_t n, k;
+    int distancia;
+    try {
+        n = stoul(argv[2]);
+        distancia = stoi(argv[3]);
+        k = (argc > 4) ? stoul(argv[4]) : 10;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    if (n == 0 || distancia < 0) return 1;
+    static const char* const SIL_LABES[] = {"ra", "lo", "mi", "ka", "su", "ne", "to", "ba", "ri", "an", "el", "or", "us",
+        "qui", "tra", "ble", "ste", "vo", "zen", "dy", "ph", "ix", "ou", "am", "ter", "son", "ly", "ck", "ma", "go"};
+    mt19937_64 aleatori(17);
+    vector<string> noms(n);
+    vector<int> playcounts(n);
+    TrieNoms trie;
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++) {
+        for (int paraula = 0, paraules = 1 + aleatori() % 2; paraula < paraules; paraula++) {
+            if (paraula > 0) noms[i] += ' ';
+            for (int s = 0, sil = 2 + aleatori() % 3; s < sil; s++) noms[i] += SIL_LABES[aleatori() % 30];
+        }
+        playcounts[i] = static_cast<int>(aleatori() % 1000000);
+        trie.insereix(noms[i], static_cast<int>(i), playcounts[i]);
+    }
+    trie.compacta();
+    cout << n << " noms, " << trie.memoria() / 1000000.0 << " MB, construit en "
+         << chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() << " ms" << endl;
+
+    // Distància de Levenshtein de dues claus normalitzades, per comprovar els resultats
+    auto levenshtein = [](const string& a, const string& b) {
+        vector<int> anterior(b.size() + 1), fila(b.size() + 1);
+        for (size_t j = 0; j <= b.size(); j++) anterior[j] = static_cast<int>(j);
+        for (size_t i = 1; i <= a.size(); i++) {
+            fila[0] = static_cast<int>(i);
+            for (size_t j = 1; j <= b.size(); j++)
+                fila[j] = min(min(anterior[j], fila[j - 1]) + 1, anterior[j - 1] + (a[i - 1] != b[j - 1]));
+            swap(anterior, fila);
+        }
+        return anterior[b.size()];
+    };
+    bool comprova = n <= 100000, iguals = true;
+    vector<double> latencies;
+    for (int q = 0; q < 5000; q++) {
+        string consulta = noms[aleatori() % n];
+        for (int e = 0; e < distancia; e++) {
+            size_t pos = aleatori() % (consulta.size() + 1);
+            char lletra = static_cast<char>('a' + aleatori() % 26);
+            int operacio = aleatori() % 3;
+            if (operacio == 0) consulta.insert(consulta.begin() + pos, lletra);
+            else if (pos < consulta.size() && operacio == 1) consulta.erase(pos, 1);
+            else if (pos < consulta.size()) consulta[pos] = lletra;
+        }
+        t0 = chrono::steady_clock::now();
+        vector<int> ids = trie.aproximada(consulta, static_cast<unsigned>(distancia), k);
+        latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count());
+        if (comprova && q < 100) {
+            vector<tuple<int, int, int>> tots;
+            string clau = TrieNoms::normalitza(consulta);
+            for (size_t i = 0; i < n; i++) {
+                int d = levenshtein(TrieNoms::normalitza(noms[i]), clau);
+                if (d <= distancia) tots.emplace_back(d, -playcounts[i], static_cast<int>(i));
+            }
+            sort(tots.begin(), tots.end());
+            if (tots.size() > k) tots.resize(k);
+            vector<int> esperats;
+            for (const tuple<int, int, int>& t : tots) esperats.push_back(get<2>(t));
+            iguals = iguals && esperats == ids;
+        }
+    }
+    sort(latencies.begin(), latencies.end());
+    cout << "Distancia " << distancia << ", k = " << k << ": p50 " << latencies[latencies.size() / 2] << " us, p99 "
+         << latencies[latencies.size() * 99 / 100] << " us, maxim " << latencies.back() << " us" << endl;
+    if (comprova) cout << (iguals ? "Resultats iguals que calculant totes les distancies" : "RESULTATS DIFERENTS!") << endl;
+    return iguals ? 0 : 1;
+}
+
+/**
+ * Benchmark del filtre de text: busca uns quants patrons a tots els camps de tots els artistes amb
+ * l'autòmat d'Aho-Corasick i amb un string::find per patró i camp, i comprova que donen el mateix.
+ * Els patrons van separats per '|' (per exemple "core|gaze|united|ana").
+ * Ús: main --text <patrons> <artistes.csv> [artistes.csv ...]
+*/
+int mainText(int argc, char* argv[]){
+    if (argc < 4) {
+        cerr << "Us: " << argv[0] << " --text <patro|patro|...> <artistes.csv> [artistes.csv ...]" << endl;
+        return 1;
+    }
+    list<string> fitxers;
+    for (int i = 3; i < argc; i++) fitxers.push_back(argv[i]);
+    CercadorArtistesAVL cercador;
+    try {
+        cercador.afegeixArtistesParallel(fitxers);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    FiltreText filtre;
+    IndexEstils::perCadaEstil(argv[2], [&filtre](string_view patro) { filtre.patrons.emplace_back(patro); });
+    filtre.majuscules = true;
+    // Els dos mètodes es cronometren sobre els mateixos artistes, sense el cost de recórrer l'arbre
+    list<int> llista = cercador.obtenirArtistes(FiltreArtistes());
+    vector<const Artist*> artistes;
+    for (int id : llista) artistes.push_back(&cercador.valorDe(id));
+
+    bool iguals = true;
+    for (int tots = 0; tots < 2; tots++) {
+        filtre.tots = (tots == 1);
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        CercaText cerca(filtre);
+        list<int> automat;
+        for (const Artist* a : artistes) {
+            if (cerca.compleix(*a)) automat.push_back(a->getArtistId());
+        }
+        double msAutomat = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        iguals = iguals && automat == cercador.obtenirArtistesPerText(filtre);
+
+        t0 = chrono::steady_clock::now();
+        list<int> find;
+        for (const Artist* a : artistes) {
+            string_view camps[] = {a->nameView(), a->genderView(), a->countryView(), a->stylesView()};
+            size_t trobats = 0;
+            for (const string& patro : filtre.patrons) {
+                bool hiEs = false;
+                for (string_view camp : camps) hiEs = hiEs || camp.find(patro) != string_view::npos;
+                trobats += hiEs;
+                if (hiEs && !filtre.tots) break;
+            }
+            if (filtre.tots ? trobats == filtre.patrons.size() : trobats > 0) find.push_back(a->getArtistId());
+        }
+        double msFind = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        iguals = iguals && automat == find;
+        cout << (filtre.tots ? "Tots els " : "Algun dels ") << filtre.patrons.size() << " patrons: " << automat.size()
+             << " artistes. Aho-Corasick " << msAutomat << " ms, string::find " << msFind << " ms" << endl;
+    }
+    cout << (iguals ? "Resultats iguals amb string::find" : "RESULTATS DIFERENTS!") << endl;
+    return iguals ? 0 : 1;
+}
+
+/**
+ * Benchmark de les consultes per rang d'id i de playcount: fa rectangles aleatoris recorrent tota la
+ * taula i amb l'arbre k-d, després canvia playcounts a l'atzar (els canvis queden pendents a l'arbre)
+ * i torna a comparar els resultats.
+ * Ús: main --rangs <consultes> <artistes.csv> [artistes.csv ...]
+*/
+int mainRangs(int argc, char* argv[]){
+    if (argc < 4) {
+        cerr << "Us: " << argv[0] << " --rangs <consultes> <artistes.csv> [artistes.csv ...]" << endl;
+        return 1;
+    }
+    list<string> fitxers;
+    for (int i = 3; i < argc; i++) fitxers.push_back(argv[i]);
+    CercadorArtistesAVL cercador;
+    size_t consultes = 0;
+    try {
+        consultes = static_cast<size_t>(LectorCSV::llegeixEnter(argv[2]));
+        cercador.afegeixArtistesParallel(fitxers);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    const TaulaArtistes& taula = cercador.indexosArtistes().taulaArtistes();
+    if (taula.mida() == 0) {
+        cerr << "Error: no hi ha cap artista" << endl;
+        return 1;
+    }
+    // Rectangles d'entre l'1% i el 10% dels artistes en cada eix. Els límits són quantils dels ids i dels
+    // playcounts, perquè els playcounts segueixen una Zipf i un rang uniforme de [0, màxim] quedaria buit
+    vector<int> idsOrdenats = taula.columnaIds(), playcountsOrdenats = taula.columnaPlaycounts();
+    sort(idsOrdenats.begin(), idsOrdenats.end());
+    sort(playcountsOrdenats.begin(), playcountsOrdenats.end());
+    size_t n = idsOrdenats.size();
+    mt19937 aleatori(48);
+    auto quantils = [&](const vector<int>& ordenats, int& minim, int& maxim) {
+        size_t ample = max<size_t>(1, n / 100 * (1 + aleatori() % 10));
+        size_t inici = aleatori() % (n - min(ample, n - 1));
+        minim = ordenats[inici];
+        maxim = ordenats[min(n - 1, inici + ample)];
+    };
+    vector<array<int, 4>> rectangles(consultes);
+    for (array<int, 4>& r : rectangles) {
+        quantils(idsOrdenats, r[0], r[1]);
+        quantils(playcountsOrdenats, r[2], r[3]);
+    }
+    auto executa = [&](const char* nom, vector<size_t>& recomptes, vector<list<int>>& llistes) {
+        recomptes.clear();
+        llistes.clear();
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        for (const array<int, 4>& r : rectangles) recomptes.push_back(cercador.buscarRecompteArtistes(r[0], r[1], r[2], r[3]));
+        double usCompta = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count() / max<size_t>(consultes, 1);
+        t0 = chrono::steady_clock::now();
+        size_t total = 0;
+        for (const array<int, 4>& r : rectangles) {
+            llistes.push_back(cercador.obtenirArtistesPerIdIPlaycount(r[0], r[1], r[2], r[3]));
+            total += llistes.back().size();
+        }
+        double usLlista = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count() / max<size_t>(consultes, 1);
+        size_t buides = static_cast<size_t>(count(recomptes.begin(), recomptes.end(), size_t(0)));
+        cout << nom << ": recompte " << usCompta << " us, llista " << usLlista << " us per consulta ("
+             << total / max<size_t>(consultes, 1) << " artistes de mitjana, " << buides << " consultes buides)" << endl;
+    };
+
+    vector<size_t> recomptesTaula, recomptesArbre;
+    vector<list<int>> llistesTaula, llistesArbre;
+    executa("Taula", recomptesTaula, llistesTaula);
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    cercador.activaArbreRangs();
+    cout << "Arbre k-d de " << taula.mida() << " artistes construit en "
+         << chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() << " ms" << endl;
+    executa("Arbre k-d", recomptesArbre, llistesArbre);
+    bool iguals = recomptesTaula == recomptesArbre && llistesTaula == llistesArbre;
+
+    // Canvis de playcount: els de l'arbre queden com a pendents fins que se'n fa una reconstrucció
+    const vector<int>& ids = taula.columnaIds();
+    for (size_t i = 0; i < 2000; i++) {
+        cercador.actualitzaPlaycount(ids[aleatori() % ids.size()], playcountsOrdenats[aleatori() % n]);
+    }
+    executa("Arbre k-d amb canvis", recomptesArbre, llistesArbre);
+    const vector<int>& playcounts = taula.columnaPlaycounts();
+    for (size_t c = 0; c < rectangles.size() && iguals; c++) {
+        const array<int, 4>& r = rectangles[c];
+        vector<int> dins;
+        for (size_t i = 0; i < ids.size(); i++) {
+            if (ids[i] >= r[0] && ids[i] <= r[1] && playcounts[i] >= r[2] && playcounts[i] <= r[3]) dins.push_back(ids[i]);
+        }
+        sort(dins.begin(), dins.end());
+        iguals = dins.size() == recomptesArbre[c] && list<int>(dins.begin(), dins.end()) == llistesArbre[c];
+    }
+    cout << (iguals ? "Resultats iguals que recorrent la taula" : "RESULTATS DIFERENTS!") << endl;
+    return iguals ? 0 : 1;
+}
+
+/**
+ * Escriu el temps i l'ocupació de cada etapa d'una càrrega per etapes
+*/
+void escriuEtapes(const string& nom, const EstadistiquesEtapes& e){
+    cout << nom << ": " << e.files << " files, " << e.bytes / (1 << 20) << " MiB en " << e.segons * 1000 << " ms"
+         << (e.ioUring ? " (io_uring)" : " (ifstream)") << endl;
+    const EtapaCarrega* etapes[] = {&e.lectura, &e.analisi, &e.insercio};
+    const char* noms[] = {"lectura", "analisi", "insercio"};
+    for (int i = 0; i < 3; i++) {
+        cout << "  " << noms[i] << ": ocupada " << etapes[i]->ocupatSegons * 1000 << " ms ("
+             << static_cast<int>(etapes[i]->ocupacio(e.segons) * 100) << "%), espera entrada "
+             << etapes[i]->esperaEntradaSegons * 1000 << " ms, espera sortida " << etapes[i]->esperaSortidaSegons * 1000
+             << " ms, " << etapes[i]->elements << " blocs" << endl;
+    }
+}
+
+/**
+ * Benchmark de la càrrega per etapes: carrega els fitxers amb afegeixArtistes (seqüencial) i amb
+ * afegeixArtistesEtapes amb io_uring i amb ifstream, escriu l'ocupació de cada etapa i comprova que
+ * els tres arbres tenen els mateixos artistes.
+ * Ús: main --etapes <mida bloc> <artistes.csv> [artistes.csv ...]
+*/
+int mainEtapes(int argc, char* argv[]){
+    if (argc < 4) {
+        cerr << "Us: " << argv[0] << " --etapes <mida bloc> <artistes.csv> [artistes.csv ...]" << endl;
+        return 1;
+    }
+    list<string> fitxers;
+    for (int i = 3; i < argc; i++) fitxers.push_back(argv[i]);
+    typedef chrono::steady_clock Rellotge;
+    try {
+        ConfiguracioEtapes c;
+        c.midaBloc = static_cast<size_t>(LectorCSV::llegeixEnter(argv[2]));
+
+        CercadorArtistesAVL sequencial;
+        Rellotge::time_point t0 = Rellotge::now();
+        for (const string& fitxer : fitxers) sequencial.afegeixArtistes(fitxer);
+        cout << "Sequencial: " << chrono::duration<double, milli>(Rellotge::now() - t0).count() << " ms" << endl;
+        list<int> ids = sequencial.obtenirArtistes(FiltreArtistes());
+        long long suma = sequencial.sumaPlaycount(FiltreArtistes());
+
+        bool iguals = true;
+        for (int uring = 1; uring >= 0; uring--) {
+            c.ioUring = (uring == 1);
+            CercadorArtistesAVL etapes;
+            EstadistiquesEtapes e = etapes.afegeixArtistesEtapes(fitxers, c);
+            escriuEtapes(c.ioUring ? "Etapes amb io_uring" : "Etapes amb ifstream", e);
+            iguals = iguals && etapes.obtenirArtistes(FiltreArtistes()) == ids && etapes.sumaPlaycount(FiltreArtistes()) == suma
+                && etapes.buida() == sequencial.buida() && (sequencial.buida() || etapes.height() == sequencial.height());
+        }
+        cout << (iguals ? "Mateixos artistes que la carrega sequencial" : "ARTISTES DIFERENTS!") << endl;
+        return iguals ? 0 : 1;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+}
+
+/**
+ * Benchmark del conjunt Elias-Fano d'ids: compara buscarArtista i la paginació amb l'arbre i amb el
+ * conjunt, la memòria de cadascun, i comprova que donen els mateixos resultats. També comprova el conjunt
+ * amb un id aïllat a INT_MAX afegit (univers esbiaixat, grups de milers d'ids).
+ * Ús: main --eliasfano <artistes.csv> [artistes.csv ...]
+*/
+int mainEliasFano(int argc, char* argv[]){
+    if (argc < 3) {
+        cerr << "Us: " << argv[0] << " --eliasfano <artistes.csv> [artistes.csv ...]" << endl;
+        return 1;
+    }
+    list<string> fitxers;
+    for (int i = 2; i < argc; i++) fitxers.push_back(argv[i]);
+    CercadorArtistesAVL cercador;
+    try {
+        cercador.afegeixArtistesParallel(fitxers);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    list<int> tots = cercador.obtenirArtistesPerId(INT_MIN, INT_MAX);
+    if (tots.empty()) {
+        cerr << "Error: no hi ha cap artista" << endl;
+        return 1;
+    }
+    typedef chrono::steady_clock Rellotge;
+    const size_t CERQUES = 2000000, PAGINES = 200, MIDA_PAGINA = 50;
+    mt19937 aleatori(50);
+    uniform_int_distribution<int> id(tots.front(), tots.back());
+    vector<int> cerques(CERQUES);
+    for (int& c : cerques) c = id(aleatori);
+    vector<size_t> pagines(PAGINES);
+    for (size_t& p : pagines) p = aleatori() % (tots.size() / MIDA_PAGINA + 1);
+
+    auto mesura = [&](const char* nom, vector<bool>& trobats, vector<list<int>>& resultats) {
+        trobats.assign(CERQUES, false);
+        resultats.clear();
+        Rellotge::time_point t0 = Rellotge::now();
+        for (size_t i = 0; i < CERQUES; i++) trobats[i] = cercador.buscarArtista(cerques[i]);
+        double nsCerca = chrono::duration<double, nano>(Rellotge::now() - t0).count() / CERQUES;
+        t0 = Rellotge::now();
+        for (size_t p : pagines) resultats.push_back(cercador.obtenirPaginaIds(p, MIDA_PAGINA));
+        double usPagina = chrono::duration<double, micro>(Rellotge::now() - t0).count() / PAGINES;
+        cout << nom << ": buscarArtista " << nsCerca << " ns, obtenirPaginaIds " << usPagina << " us" << endl;
+    };
+
+    vector<bool> trobatsArbre, trobatsConjunt;
+    vector<list<int>> paginesArbre, paginesConjunt;
+    mesura("Arbre", trobatsArbre, paginesArbre);
+    Rellotge::time_point t0 = Rellotge::now();
+    cercador.activaConjuntIds();
+    double msConstruccio = chrono::duration<double, milli>(Rellotge::now() - t0).count();
+    mesura("Elias-Fano", trobatsConjunt, paginesConjunt);
+    const ConjuntEliasFano& conjunt = *cercador.conjuntIds();
+    cout << conjunt.mida() << " ids de " << tots.front() << " a " << tots.back() << ": Elias-Fano " << conjunt.memoria()
+         << " bytes (" << conjunt.bitsPerClau() << " bits per id, construit en " << msConstruccio << " ms), nodes de l'arbre "
+         << tots.size() * sizeof(NodeTree<int, Artist>) << " bytes sense el text dels artistes" << endl;
+
+    // Paginació per clau de tot el conjunt, comparada amb la llista ordenada
+    list<int> perClau;
+    for (list<int> pagina = cercador.obtenirIdsDesDe(INT_MIN, 1000); !pagina.empty();
+         pagina = cercador.obtenirIdsDesDe(perClau.back() + 1, 1000)) {
+        perClau.splice(perClau.end(), pagina);
+        if (perClau.back() == INT_MAX) break;
+    }
+    bool iguals = trobatsArbre == trobatsConjunt && paginesArbre == paginesConjunt && perClau == tots;
+
+    // La rèplica només guarda els ids: el cercador es podria destruir i seguiria responent igual
+    ReplicaIds replica = ReplicaIds::deCercador(cercador);
+    for (size_t i = 0; i < CERQUES && iguals; i++) iguals = replica.buscarArtista(cerques[i]) == trobatsArbre[i];
+    for (size_t p = 0; p < PAGINES && iguals; p++) iguals = replica.obtenirPaginaIds(pagines[p], MIDA_PAGINA) == paginesArbre[p];
+    iguals = iguals && replica.obtenirIdsDesDe(INT_MIN, tots.size()) == tots;
+    cout << "Replica d'ids: " << replica.memoria() << " bytes en total, " << replica.memoria() / static_cast<double>(replica.mida())
+         << " bytes per artista" << endl;
+
+    // Univers esbiaixat: els mateixos ids i un id aïllat a INT_MAX. Els grups del conjunt passen a ser de
+    // milers d'ids, i conte i comptaMenors han de seguir coincidint amb la cerca binària sobre la llista
+    vector<int> esbiaixats(tots.begin(), tots.end());
+    if (esbiaixats.back() != INT_MAX) esbiaixats.push_back(INT_MAX);
+    ConjuntEliasFano esbiaixat(esbiaixats);
+    vector<bool> trobatsEsbiaixat(CERQUES);
+    t0 = Rellotge::now();
+    for (size_t i = 0; i < CERQUES; i++) trobatsEsbiaixat[i] = esbiaixat.conte(cerques[i]);
+    double nsEsbiaixat = chrono::duration<double, nano>(Rellotge::now() - t0).count() / CERQUES;
+    iguals = iguals && trobatsEsbiaixat == trobatsArbre;
+    for (size_t i = 0; i < CERQUES && iguals; i++) {
+        iguals = esbiaixat.comptaMenors(cerques[i])
+            == static_cast<size_t>(lower_bound(esbiaixats.begin(), esbiaixats.end(), cerques[i]) - esbiaixats.begin());
+    }
+    cout << "Elias-Fano amb un id a INT_MAX: " << esbiaixat.bitsPerClau() << " bits per id, conte " << nsEsbiaixat << " ns" << endl;
+    cout << (iguals ? "Resultats iguals que amb l'arbre" : "RESULTATS DIFERENTS!") << endl;
+    return iguals ? 0 : 1;
+}
+
+ServidorConsultes<CercadorArtistesAVL>* servidorActiu = nullptr;
+
+/**
+ * Atura el servidor amb Ctrl+C (atura només escriu a un eventfd, es pot cridar des d'un senyal)
+*/
+void aturaServidor(int){
+    if (servidorActiu != nullptr) servidorActiu->atura();
+}
+
+/**
+ * Mode servidor: carrega els artistes una vegada i respon consultes per un socket Unix fins a Ctrl+C.
+ * Ús: main --servidor <socket> <fils> <artistes.csv> [artistes.csv ...]
+*/
+int mainServidor(int argc, char* argv[]){
+    if (argc < 5) {
+        cerr << "Us: " << argv[0] << " --servidor <socket> <fils> <artistes.csv> [artistes.csv ...]" << endl;
+        return 1;
+    }
+    try {
+        unsigned fils = static_cast<unsigned>(LectorCSV::llegeixEnter(argv[3]));
+        list<string> fitxers;
+        for (int i = 4; i < argc; i++) fitxers.push_back(argv[i]);
+
+        CercadorArtistesAVL cercador;
+        cercador.afegeixArtistesParallel(fitxers, fils);
+        ServidorConsultes<CercadorArtistesAVL> servidor(cercador, argv[2], fils);
+        servidorActiu = &servidor;
+        signal(SIGINT, aturaServidor);
+        signal(SIGTERM, aturaServidor);
+        cerr << "Escoltant a " << argv[2] << endl;
+        servidor.executa();
+        servidorActiu = nullptr;
+
+        EstadistiquesServidor e = servidor.estadistiques();
+        cerr << "Connexions: " << e.connexions << ", consultes: " << e.consultes << ", lots: " << e.lots << endl;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Client de càrrega per al mode servidor.
+ * Ús: main --client <socket> <consultes.csv> <connexions> <peticions per connexio> <pipeline>
+*/
+int mainClient(int argc, char* argv[]){
+    if (argc < 7) {
+        cerr << "Us: " << argv[0] << " --client <socket> <consultes.csv> <connexions> <peticions> <pipeline>" << endl;
+        return 1;
+    }
+    ifstream fitxer(argv[3]);
+    if (!fitxer.is_open()) {
+        cerr << "Error: Unable to open file " << argv[3] << endl;
+        return 1;
+    }
+    vector<string> consultes;
+    string line;
+    while (getline(fitxer, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#' || line.compare(0, 9, "artist_id") == 0) continue;
+        consultes.push_back(line);
+    }
+    try {
+        EstadistiquesClient e = carregaServidor(argv[2], consultes,
+            static_cast<unsigned>(LectorCSV::llegeixEnter(argv[4])), LectorCSV::llegeixEnter(argv[5]), LectorCSV::llegeixEnter(argv[6]));
+        cout << "Peticions: " << e.peticions << " (errors " << e.errors << ") en " << e.segons << " s" << endl;
+        cout << "Rendiment: " << e.peticionsPerSegon << " peticions/s" << endl;
+        cout << "Latencia p50: " << e.p50 << " us, p99: " << e.p99 << " us, p99.9: " << e.p999 << " us" << endl;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]){
+    if (argc > 1 && string(argv[1]) == "--lot") return mainLot(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--servidor") return mainServidor(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--client") return mainClient(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--planificador") return mainPlanificador(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--agrupa") return mainAgrupa(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--ingesta") return mainIngesta(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--registre") return mainRegistre(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--magatzem") return mainMagatzem(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--bloom") return mainBloom(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--genera") return mainGenera(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--escalat") return mainEscalat(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--particions") return mainParticions(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--aproximat") return mainAproximat(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--text") return mainText(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--rangs") return mainRangs(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--etapes") return mainEtapes(argc, argv);
+    if (argc > 1 && string(argv[1]) == "--eliasfano") return mainEliasFano(argc, argv);
+
     /* Exercici1 */
     casDeProvaExercici1(); 
 